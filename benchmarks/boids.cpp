@@ -0,0 +1,201 @@
+// Boids flock benchmark
+//
+// The components are
+//  - a position
+//  - a velocity
+//
+// The systems are
+// - the steering system. It buckets the boids in a uniform grid and applies the cohesion, alignment and
+//   separation rules to the velocity of each boid, using the boids in the neighbouring cells
+// - the movement system. It integrates the velocity into the position and wraps the position around the
+//   borders of the world
+//
+// The size of the world grows with the number of boids, so the density of the flock stays constant. The
+// steering and movement loops run in parallel.
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <mantra/System.hpp>
+#include <mantra/World.hpp>
+
+#include "harness.hpp"
+
+struct Position
+{
+	float x, y;
+};
+
+struct Velocity
+{
+	float x, y;
+};
+
+namespace
+{
+
+float constexpr cell_size{4.f};
+float constexpr max_speed{2.f};
+std::size_t constexpr max_neighbours{16};
+
+float wrap(float v, float size)
+{
+	if (v < 0)
+		return v + size;
+	if (v >= size)
+		return v - size;
+	return v;
+}
+
+} // namespace
+
+class SteerSys : public mantra::System<Velocity, Position>
+{
+	public:
+	explicit SteerSys(float s) : size{s}, cells{static_cast<std::size_t>(std::ceil(s / cell_size))}, grid{} {}
+
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		grid.assign(cells * cells, {});
+		for (auto& entity : wv.entities())
+		{
+			auto const& p = entity.template get_component<Position>();
+			auto const& v = entity.template get_component<Velocity>();
+			grid[cell_of(p.x, p.y)].push_back({p, v});
+		}
+
+		wv.parallel_for_each([this](auto& entity)
+		{
+			auto const& p = entity.template get_component<Position>();
+			auto& v = entity.template get_component<Velocity>();
+			steer(p, v);
+		});
+	}
+
+	private:
+	struct Boid
+	{
+		Position p;
+		Velocity v;
+	};
+
+	std::size_t cell_of(float x, float y) const
+	{
+		auto cx = std::min(static_cast<std::size_t>(x / cell_size), cells - 1);
+		auto cy = std::min(static_cast<std::size_t>(y / cell_size), cells - 1);
+		return cy * cells + cx;
+	}
+
+	void steer(Position const& p, Velocity& v) const
+	{
+		auto cx = static_cast<long>(std::min(static_cast<std::size_t>(p.x / cell_size), cells - 1));
+		auto cy = static_cast<long>(std::min(static_cast<std::size_t>(p.y / cell_size), cells - 1));
+		auto n = static_cast<long>(cells);
+
+		float cohx{0}, cohy{0}, alix{0}, aliy{0}, sepx{0}, sepy{0};
+		std::size_t count{0};
+		for (long dy{-1}; dy <= 1; ++dy)
+		{
+			for (long dx{-1}; dx <= 1; ++dx)
+			{
+				auto const& cell = grid[static_cast<std::size_t>(((cy + dy + n) % n) * n + (cx + dx + n) % n)];
+				for (auto const& b : cell)
+				{
+					if (count == max_neighbours)
+						break;
+					auto ox = b.p.x - p.x;
+					auto oy = b.p.y - p.y;
+					auto dist2 = ox * ox + oy * oy;
+					if (dist2 == 0 || dist2 > cell_size * cell_size)
+						continue;
+					cohx += ox;
+					cohy += oy;
+					alix += b.v.x;
+					aliy += b.v.y;
+					sepx -= ox / dist2;
+					sepy -= oy / dist2;
+					++count;
+				}
+			}
+		}
+		if (count == 0)
+			return;
+
+		auto inv = 1.f / static_cast<float>(count);
+		v.x += 0.01f * cohx * inv + 0.05f * (alix * inv - v.x) + 0.1f * sepx;
+		v.y += 0.01f * cohy * inv + 0.05f * (aliy * inv - v.y) + 0.1f * sepy;
+		auto speed = std::sqrt(v.x * v.x + v.y * v.y);
+		if (speed > max_speed)
+		{
+			v.x *= max_speed / speed;
+			v.y *= max_speed / speed;
+		}
+	}
+
+	float size;
+	std::size_t cells;
+	std::vector<std::vector<Boid>> grid;
+};
+
+class MoveSys : public mantra::System<Position, Velocity>
+{
+	public:
+	explicit MoveSys(float s) : size{s} {}
+
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		wv.parallel_for_each([this](auto& entity)
+		{
+			auto& p = entity.template get_component<Position>();
+			auto const& v = entity.template get_component<Velocity>();
+			p.x = wrap(p.x + v.x, size);
+			p.y = wrap(p.y + v.y, size);
+		});
+	}
+
+	private:
+	float size;
+};
+
+class Boids
+{
+	using World = mantra::World<mantra::ComponentList<Position, Velocity>,
+	                            mantra::SystemList<SteerSys, MoveSys>>;
+
+	public:
+	Boids(std::size_t n, unsigned seed, mantra::Scheduler& scheduler)
+		: size{cell_size * std::ceil(std::sqrt(static_cast<float>(n) / 2.f))},
+		  world{mantra::forward_as_tuple(float{size}), mantra::forward_as_tuple(float{size})}
+	{
+		std::mt19937 rng{seed};
+		std::uniform_real_distribution<float> pos{0, size};
+		std::uniform_real_distribution<float> vel{-max_speed, max_speed};
+
+		world.set_scheduler(&scheduler);
+		world.reserve_entities(n);
+		world.reserve_components<Position>(n);
+		world.reserve_components<Velocity>(n);
+		for (std::size_t i{0}; i < n; ++i)
+		{
+			world.create_entity<Position, Velocity>(mantra::forward_as_tuple(Position{pos(rng), pos(rng)}),
+			                                        mantra::forward_as_tuple(Velocity{vel(rng), vel(rng)}));
+		}
+	}
+
+	void frame()
+	{
+		world.update();
+	}
+
+	private:
+	float size;
+	World world;
+};
+
+int main(int argc, char** argv)
+{
+	return bench::main<Boids>("boids", argc, argv);
+}
@@ -0,0 +1,202 @@
+// Shared harness for the macro benchmarks
+//
+// A scenario is a class with
+// - a constructor taking the number of entities, a seed and a scheduler, which builds a populated world
+//   running its parallel loops on the scheduler
+// - a `void frame()` function, which runs one frame of the world
+//
+// The harness runs every scenario for a number of frames at each requested entity count and thread count,
+// and reports frame time percentiles and scaling efficiency. With `T` threads, a single world is simulated
+// with a scheduler of `T - 1` workers plus the main thread (strong scaling). The efficiency is the speedup
+// over the first thread count divided by the increase in threads, so 100% means perfect scaling.
+//
+// Command line options
+// - `--entities N[,N...]` Entity counts (default 1000,10000)
+// - `--threads T[,T...]` Thread counts (default 1,2,4)
+// - `--frames F` Number of measured frames, at least 1 (default 200)
+// - `--warmup W` Number of frames run before measuring (default 20)
+// - `--seed S` Seed of the random generators (default 42)
+// - `--help`, `-h` Print the options and exit
+
+#ifndef MANTRA_BENCHMARKS_HARNESS_HPP
+#define MANTRA_BENCHMARKS_HARNESS_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <mantra/Scheduler.hpp>
+
+namespace bench
+{
+
+struct Options
+{
+	std::vector<std::size_t> entities{1000, 10000};
+	std::vector<std::size_t> threads{1, 2, 4};
+	std::size_t frames{200};
+	std::size_t warmup{20};
+	unsigned seed{42};
+};
+
+inline std::vector<std::size_t> parse_list(char const* str)
+{
+	std::vector<std::size_t> res;
+	std::string s{str};
+	std::size_t pos{0};
+	while (pos <= s.size())
+	{
+		auto next = s.find(',', pos);
+		if (next == std::string::npos)
+			next = s.size();
+		if (next > pos)
+			res.emplace_back(std::stoul(s.substr(pos, next - pos)));
+		pos = next + 1;
+	}
+	return res;
+}
+
+// What to do with a command line
+enum class Parse
+{
+	run,
+	help,
+	invalid
+};
+
+inline Parse parse_options(int argc, char** argv, Options& opts)
+{
+	for (int i{1}; i < argc; ++i)
+	{
+		auto has_value = i + 1 < argc;
+		if (!std::strcmp(argv[i], "--help") || !std::strcmp(argv[i], "-h"))
+			return Parse::help;
+		else if (!std::strcmp(argv[i], "--entities") && has_value)
+			opts.entities = parse_list(argv[++i]);
+		else if (!std::strcmp(argv[i], "--threads") && has_value)
+			opts.threads = parse_list(argv[++i]);
+		else if (!std::strcmp(argv[i], "--frames") && has_value)
+			opts.frames = std::stoul(argv[++i]);
+		else if (!std::strcmp(argv[i], "--warmup") && has_value)
+			opts.warmup = std::stoul(argv[++i]);
+		else if (!std::strcmp(argv[i], "--seed") && has_value)
+			opts.seed = static_cast<unsigned>(std::stoul(argv[++i]));
+		else
+			return Parse::invalid;
+	}
+	// The frame time summaries need at least one frame
+	return opts.frames ? Parse::run : Parse::invalid;
+}
+
+inline void usage(std::ostream& out, char const* name)
+{
+	out << "Usage: " << name << " [--entities N,...] [--threads T,...] [--frames F] [--warmup W] [--seed S]\n";
+}
+
+// Exits after printing the usage for --help and invalid command lines
+inline Options parse_options(int argc, char** argv)
+{
+	Options opts;
+	auto parse = parse_options(argc, argv, opts);
+	if (parse == Parse::help)
+	{
+		usage(std::cout, argv[0]);
+		std::exit(EXIT_SUCCESS);
+	}
+	if (parse == Parse::invalid)
+	{
+		usage(std::cerr, argv[0]);
+		std::exit(EXIT_FAILURE);
+	}
+	return opts;
+}
+
+struct Result
+{
+	double mean;
+	double p50;
+	double p90;
+	double p99;
+	double max;
+};
+
+inline double percentile(std::vector<double> const& sorted, double p)
+{
+	auto idx = static_cast<std::size_t>(p * static_cast<double>(sorted.size() - 1) + 0.5);
+	return sorted[std::min(idx, sorted.size() - 1)];
+}
+
+inline Result summarize(std::vector<double> times)
+{
+	std::sort(std::begin(times), std::end(times));
+	double sum{0};
+	for (auto t : times)
+		sum += t;
+	return {sum / static_cast<double>(times.size()), percentile(times, 0.5), percentile(times, 0.9),
+	        percentile(times, 0.99), times.back()};
+}
+
+// Frame times are in microseconds
+template <typename Scenario>
+std::vector<double> run_world(std::size_t entities, unsigned seed, mantra::Scheduler& scheduler, std::size_t warmup,
+                              std::size_t frames)
+{
+	Scenario scenario{entities, seed, scheduler};
+	for (std::size_t i{0}; i < warmup; ++i)
+		scenario.frame();
+
+	std::vector<double> times;
+	times.reserve(frames);
+	for (std::size_t i{0}; i < frames; ++i)
+	{
+		auto start = std::chrono::steady_clock::now();
+		scenario.frame();
+		auto end = std::chrono::steady_clock::now();
+		times.emplace_back(std::chrono::duration<double, std::micro>(end - start).count());
+	}
+	return times;
+}
+
+template <typename Scenario>
+Result run(Options const& opts, std::size_t entities, std::size_t threads)
+{
+	mantra::Scheduler scheduler{threads > 1 ? threads - 1 : 0};
+	return summarize(run_world<Scenario>(entities, opts.seed, scheduler, opts.warmup, opts.frames));
+}
+
+template <typename Scenario>
+int main(char const* name, int argc, char** argv)
+{
+	auto opts = parse_options(argc, argv);
+
+	std::cout << name << " (" << opts.frames << " frames, times in us)\n";
+	std::cout << std::setw(10) << "entities" << std::setw(9) << "threads" << std::setw(12) << "mean"
+	          << std::setw(12) << "p50" << std::setw(12) << "p90" << std::setw(12) << "p99"
+	          << std::setw(12) << "max" << std::setw(12) << "efficiency" << '\n';
+	std::cout << std::fixed << std::setprecision(1);
+
+	for (auto entities : opts.entities)
+	{
+		double base{0};
+		for (auto threads : opts.threads)
+		{
+			auto res = run<Scenario>(opts, entities, threads);
+			if (base == 0)
+				base = res.mean * static_cast<double>(threads);
+			std::cout << std::setw(10) << entities << std::setw(9) << threads << std::setw(12) << res.mean
+			          << std::setw(12) << res.p50 << std::setw(12) << res.p90 << std::setw(12) << res.p99
+			          << std::setw(12) << res.max << std::setw(11)
+			          << 100 * base / (res.mean * static_cast<double>(threads)) << "%\n";
+		}
+	}
+	return EXIT_SUCCESS;
+}
+
+} // namespace bench
+
+#endif // Header guard
@@ -0,0 +1,173 @@
+// Particle emitter benchmark
+//
+// The components are
+//  - a position
+//  - a velocity
+//  - a lifetime, in frames
+//  - an emitter, spawning particles at a given rate
+//
+// The systems are
+// - the emission system. It creates new particles around each emitter
+// - the gravity system. It applies gravity to the velocity of the particles
+// - the movement system. It integrates the velocity into the position
+// - the lifetime system. It decrements the lifetime of the particles and destroys them when it reaches 0
+//
+// Particles live for a fixed number of frames and the emission rate is chosen so that the population stays
+// around the requested entity count. Every frame, about 1/60th of the particles are destroyed and as many
+// are created, which stresses entity and component slot recycling. The gravity and movement loops run in
+// parallel.
+
+#include <random>
+
+#include <mantra/System.hpp>
+#include <mantra/World.hpp>
+
+#include "harness.hpp"
+
+struct Position
+{
+	float x, y, z;
+};
+
+struct Velocity
+{
+	float x, y, z;
+};
+
+using Lifetime = int;
+
+struct Emitter
+{
+	float rate;
+	float pending;
+};
+
+namespace
+{
+
+int constexpr lifetime{60};
+std::size_t constexpr particles_per_emitter{1000};
+
+} // namespace
+
+class EmitSys : public mantra::System<Emitter, Position>
+{
+	public:
+	explicit EmitSys(unsigned seed) : rng{seed}, spread{-1.f, 1.f} {}
+
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		for (auto& entity : wv.entities())
+		{
+			auto& e = entity.template get_component<Emitter>();
+			auto p = entity.template get_component<Position>();
+			for (e.pending += e.rate; e.pending >= 1.f; e.pending -= 1.f)
+			{
+				wv.template create_entity<Position, Velocity, Lifetime>(
+					mantra::forward_as_tuple(Position{p}),
+					mantra::forward_as_tuple(Velocity{spread(rng), 2.f + spread(rng), spread(rng)}),
+					mantra::forward_as_tuple(lifetime));
+			}
+		}
+	}
+
+	private:
+	std::mt19937 rng;
+	std::uniform_real_distribution<float> spread;
+};
+
+class GravitySys : public mantra::System<Velocity, Lifetime>
+{
+	public:
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		wv.parallel_for_each([](auto& entity)
+		{
+			entity.template get_component<Velocity>().y -= 0.05f;
+		});
+	}
+};
+
+class MoveSys : public mantra::System<Position, Velocity>
+{
+	public:
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		wv.parallel_for_each([](auto& entity)
+		{
+			auto& p = entity.template get_component<Position>();
+			auto const& v = entity.template get_component<Velocity>();
+			p.x += v.x;
+			p.y += v.y;
+			p.z += v.z;
+		});
+	}
+};
+
+class LifetimeSys : public mantra::System<Lifetime>
+{
+	public:
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		for (auto& entity : wv.entities())
+		{
+			if (--entity.template get_component<Lifetime>() <= 0)
+				entity.destroy();
+		}
+	}
+};
+
+class Particles
+{
+	using World = mantra::World<mantra::ComponentList<Position, Velocity, Lifetime, Emitter>,
+	                            mantra::SystemList<EmitSys, GravitySys, MoveSys, LifetimeSys>>;
+
+	public:
+	Particles(std::size_t n, unsigned seed, mantra::Scheduler& scheduler)
+		: world{mantra::forward_as_tuple(unsigned{seed}), mantra::forward_as_tuple(),
+		        mantra::forward_as_tuple(), mantra::forward_as_tuple()}
+	{
+		std::mt19937 rng{seed};
+		std::uniform_real_distribution<float> pos{-100.f, 100.f};
+		std::uniform_real_distribution<float> vel{-1.f, 1.f};
+		std::uniform_int_distribution<int> life{1, lifetime};
+
+		auto emitters = n / particles_per_emitter + 1;
+		auto rate = static_cast<float>(n) / static_cast<float>(emitters * lifetime);
+
+		world.set_scheduler(&scheduler);
+		world.reserve_entities(n + emitters);
+		world.reserve_components<Position>(n + emitters);
+		world.reserve_components<Velocity>(n);
+		world.reserve_components<Lifetime>(n);
+		for (std::size_t i{0}; i < emitters; ++i)
+		{
+			world.create_entity<Emitter, Position>(mantra::forward_as_tuple(Emitter{rate, 0.f}),
+			                                       mantra::forward_as_tuple(Position{pos(rng), 0.f, pos(rng)}));
+		}
+		for (std::size_t i{0}; i < n; ++i)
+		{
+			world.create_entity<Position, Velocity, Lifetime>(
+				mantra::forward_as_tuple(Position{pos(rng), pos(rng), pos(rng)}),
+				mantra::forward_as_tuple(Velocity{vel(rng), vel(rng), vel(rng)}),
+				mantra::forward_as_tuple(life(rng)));
+		}
+	}
+
+	void frame()
+	{
+		world.update();
+	}
+
+	private:
+	World world;
+};
+
+int main(int argc, char** argv)
+{
+	return bench::main<Particles>("particles", argc, argv);
+}
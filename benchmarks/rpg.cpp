@@ -0,0 +1,305 @@
+// RPG-style benchmark
+//
+// A world with 30 component types and 25 systems, closer to the shape of a real game than the other
+// scenarios. Entities are built from a handful of archetypes (players, monsters, NPCs, projectiles and
+// props) sharing different subsets of the components.
+//
+// Most systems blend their primary component with their secondary components, which gives each system a
+// realistic access pattern without caring too much about game logic. The 25 systems form 6 stages of the
+// parallel update, and the blending loops run in parallel too. A few systems make structural changes every
+// frame : buffs and debuffs are added and removed, and projectiles are destroyed and respawned. Positions are
+// double-buffered, and the rendering reads those of the previous frame.
+
+#include <random>
+
+#include <mantra/System.hpp>
+#include <mantra/World.hpp>
+
+#include "harness.hpp"
+
+#define RPG_COMPONENT(name) struct name { float v; }
+
+RPG_COMPONENT(Position);
+RPG_COMPONENT(Velocity);
+RPG_COMPONENT(Health);
+RPG_COMPONENT(Mana);
+RPG_COMPONENT(Stamina);
+RPG_COMPONENT(Armor);
+RPG_COMPONENT(Strength);
+RPG_COMPONENT(Agility);
+RPG_COMPONENT(Intellect);
+RPG_COMPONENT(Experience);
+RPG_COMPONENT(Level);
+RPG_COMPONENT(Gold);
+RPG_COMPONENT(Inventory);
+RPG_COMPONENT(Target);
+RPG_COMPONENT(Threat);
+RPG_COMPONENT(Aggro);
+RPG_COMPONENT(Faction);
+RPG_COMPONENT(Brain);
+RPG_COMPONENT(Path);
+RPG_COMPONENT(Animation);
+RPG_COMPONENT(Sprite);
+RPG_COMPONENT(Sound);
+RPG_COMPONENT(Buff);
+RPG_COMPONENT(Debuff);
+RPG_COMPONENT(Cooldown);
+RPG_COMPONENT(Regen);
+RPG_COMPONENT(Poison);
+RPG_COMPONENT(Projectile);
+RPG_COMPONENT(Shield);
+RPG_COMPONENT(Lifetime);
+
+#undef RPG_COMPONENT
+
+namespace mantra
+{
+
+template <>
+struct storage_traits<Position>
+{
+	using storage = DoubleBufferedStorage;
+};
+
+} // namespace mantra
+
+namespace
+{
+
+template <typename E, typename... Cs>
+float sum(E const& entity)
+{
+	float res{0};
+	(void)std::initializer_list<int>{(res += entity.template get_component<Cs>().v, 0)...};
+	return res;
+}
+
+} // namespace
+
+// Blends the primary component with the secondary components
+template <typename P, typename... Cs>
+class BlendSys : public mantra::System<P, Cs...>
+{
+	public:
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		wv.parallel_for_each([](auto& entity)
+		{
+			auto& p = entity.template get_component<P>();
+			p.v = 0.99f * p.v + 0.001f * sum<std::decay_t<decltype(entity)>, Cs...>(entity);
+		});
+	}
+};
+
+// Grants a buff when the threat gets too high
+class BuffSys : public mantra::System<Threat, Aggro>
+{
+	public:
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		for (auto& entity : wv.entities())
+		{
+			auto& threat = entity.template get_component<Threat>();
+			threat.v += 0.1f;
+			if (threat.v > 5.f)
+			{
+				threat.v = 0;
+				if (!entity.template has_components<Buff>())
+					entity.template add_component<Buff>(Buff{10.f});
+			}
+		}
+	}
+};
+
+// Removes the buffs when they wear off
+class BuffDecaySys : public mantra::System<Buff>
+{
+	public:
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		for (auto& entity : wv.entities())
+		{
+			if ((entity.template get_component<Buff>().v -= 1.f) <= 0)
+				entity.template remove_components<Buff>();
+		}
+	}
+};
+
+// Poisons the entities when a cooldown expires
+class PoisonSys : public mantra::System<Cooldown, Faction>
+{
+	public:
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		for (auto& entity : wv.entities())
+		{
+			auto& cd = entity.template get_component<Cooldown>();
+			if ((cd.v -= 1.f) <= 0)
+			{
+				cd.v = 30.f;
+				if (!entity.template has_components<Debuff, Poison>())
+					entity.template add_components<Debuff, Poison>(mantra::forward_as_tuple(Debuff{5.f}),
+					                                               mantra::forward_as_tuple(Poison{1.f}));
+			}
+		}
+	}
+};
+
+// Removes the poison when the debuff wears off
+class DebuffSys : public mantra::System<Debuff, Poison>
+{
+	public:
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		for (auto& entity : wv.entities())
+		{
+			if ((entity.template get_component<Debuff>().v -= 1.f) <= 0)
+				entity.template remove_components<Debuff, Poison>();
+		}
+	}
+};
+
+// Destroys the expired projectiles and respawns them
+class ProjectileSys : public mantra::System<Lifetime, Projectile>
+{
+	public:
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		std::size_t expired{0};
+		for (auto& entity : wv.entities())
+		{
+			if ((entity.template get_component<Lifetime>().v -= 1.f) <= 0)
+			{
+				entity.destroy();
+				++expired;
+			}
+		}
+		for (std::size_t i{0}; i < expired; ++i)
+		{
+			wv.template create_entity<Position, Velocity, Projectile, Lifetime, Sprite>(
+				mantra::forward_as_tuple(Position{0}), mantra::forward_as_tuple(Velocity{1}),
+				mantra::forward_as_tuple(Projectile{1}), mantra::forward_as_tuple(Lifetime{20}),
+				mantra::forward_as_tuple(Sprite{0}));
+		}
+	}
+};
+
+// Reads the visible entities without writing anything, at their position of the previous frame
+class RenderSys : public mantra::System<void, mantra::Previous<Position>, Sprite>
+{
+	public:
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		checksum = 0;
+		for (auto& entity : wv.entities())
+		{
+			checksum += entity.template get_previous<Position>().v +
+			            sum<std::decay_t<decltype(entity)>, Sprite>(entity);
+		}
+	}
+
+	private:
+	float checksum{0};
+};
+
+using Components = mantra::ComponentList<Position, Velocity, Health, Mana, Stamina, Armor, Strength, Agility,
+                                         Intellect, Experience, Level, Gold, Inventory, Target, Threat, Aggro,
+                                         Faction, Brain, Path, Animation, Sprite, Sound, Buff, Debuff,
+                                         Cooldown, Regen, Poison, Projectile, Shield, Lifetime>;
+
+using Systems = mantra::SystemList<
+	BlendSys<Brain, Target, Threat, Faction>,
+	BlendSys<Target, Position, Faction>,
+	BlendSys<Path, Brain, Position>,
+	BlendSys<Velocity, Path, Agility>,
+	BlendSys<Position, Velocity>,
+	BuffSys,
+	BuffDecaySys,
+	PoisonSys,
+	DebuffSys,
+	BlendSys<Health, Regen, Armor, Level>,
+	BlendSys<Mana, Regen, Intellect>,
+	BlendSys<Stamina, Regen, Strength, Agility>,
+	BlendSys<Shield, Armor, Buff>,
+	BlendSys<Regen, Level>,
+	BlendSys<Armor, Strength, Level>,
+	BlendSys<Experience, Level, Target>,
+	BlendSys<Level, Experience>,
+	BlendSys<Gold, Experience, Inventory>,
+	BlendSys<Inventory, Strength>,
+	BlendSys<Aggro, Health, Faction>,
+	BlendSys<Animation, Velocity, Brain>,
+	BlendSys<Sprite, Animation, Position>,
+	BlendSys<Sound, Animation, Position>,
+	ProjectileSys,
+	RenderSys>;
+
+template <typename... Ts, typename W>
+void spawn(W& world)
+{
+	world.template create_entity<Ts...>(mantra::forward_as_tuple(Ts{1.f})...);
+}
+
+class Rpg
+{
+	using World = mantra::World<Components, Systems>;
+
+	public:
+	Rpg(std::size_t n, unsigned seed, mantra::Scheduler& scheduler) : world{}
+	{
+		std::mt19937 rng{seed};
+		std::discrete_distribution<int> archetype{1, 40, 20, 30, 9};
+		std::uniform_real_distribution<float> life{1.f, 20.f};
+
+		world.set_scheduler(&scheduler);
+		world.reserve_entities(n);
+		for (std::size_t i{0}; i < n; ++i)
+		{
+			switch (archetype(rng))
+			{
+				case 0: // Player
+					spawn<Position, Velocity, Health, Mana, Stamina, Armor, Strength, Agility, Intellect,
+					      Experience, Level, Gold, Inventory, Target, Path, Animation, Sprite, Sound, Regen,
+					      Shield>(world);
+					break;
+				case 1: // Monster
+					spawn<Position, Velocity, Health, Armor, Strength, Agility, Level, Target, Threat, Aggro,
+					      Faction, Brain, Path, Animation, Sprite, Regen, Cooldown>(world);
+					break;
+				case 2: // NPC
+					spawn<Position, Health, Level, Gold, Inventory, Faction, Brain, Animation, Sprite,
+					      Sound>(world);
+					break;
+				case 3: // Projectile
+					world.create_entity<Position, Velocity, Projectile, Lifetime, Sprite>(
+						mantra::forward_as_tuple(Position{0}), mantra::forward_as_tuple(Velocity{1}),
+						mantra::forward_as_tuple(Projectile{1}), mantra::forward_as_tuple(Lifetime{life(rng)}),
+						mantra::forward_as_tuple(Sprite{0}));
+					break;
+				default: // Prop
+					spawn<Position, Sprite>(world);
+					break;
+			}
+		}
+	}
+
+	void frame()
+	{
+		world.update();
+	}
+
+	private:
+	World world;
+};
+
+int main(int argc, char** argv)
+{
+	return bench::main<Rpg>("rpg", argc, argv);
+}
@@ -33,7 +33,10 @@
 #ifndef MANTRA_ENTITYHANDLE_HPP
 #define MANTRA_ENTITYHANDLE_HPP
 
-#include "impl/Entity.hpp"
+#include "impl/Commands.hpp"
+#include "impl/Registry.hpp"
+#include "impl/TimingWheel.hpp"
+#include "impl/Trace.hpp"
 
 namespace mantra
 {
@@ -48,20 +51,28 @@ namespace mantra
  * \tparam C Secondary component types
  * 
  * \note Instances are created and returned by the library and should not be created directly by the user.
+ * \note The structural changes (`destroy`, `add_component(s)`, `remove_components`) made through the handles of
+ * a system running concurrently with other systems are deferred until the end of its stage, and so are the
+ * entities it creates, whose handles only accept structural changes. See `World::update`.
+ * \note The delayed changes (`destroy_after`, `add_after`, `remove_after`) are counted in frames, and fired at the
+ * start of the frame they are due, before any system runs. They are dropped if the entity is destroyed before.
  */
 template <typename W, typename P, typename... C>
 class EntityHandle final
 #ifndef NDEBUG
 //! \cond
-	: public impl::DebugHandle<typename W::Components>
+	: public impl::DebugHandle<typename impl::WorldCont<typename W::Components, typename W::Systems,
+	                                                  typename W::Resources, typename W::Index>::Data>
 //! \endcond
 #endif
 {
-	using WC = impl::WorldCont<typename W::Components, typename W::Systems>;
+	using WC = impl::WorldCont<typename W::Components, typename W::Systems, typename W::Resources,
+	                           typename W::Index>;
 
 	public:
 	//! \cond
-	EntityHandle(typename WC::EntCont&, std::size_t);
+	EntityHandle(typename WC::Data&, typename WC::Recorder&, typename WC::Timers&, std::size_t,
+	             impl::Commands* = nullptr);
 	//! \endcond
 
 	/**
@@ -99,10 +110,10 @@ class EntityHandle final
 
 #ifndef DOXYGEN_ONLY
 	template <typename T>
-	std::enable_if_t<impl::is_any<P, T, void>{}, T>& get_component() noexcept;
+	std::enable_if_t<impl::is_any<P, T, void>{}, impl::Reference<T>> get_component() noexcept;
 
 	template <typename T>
-	std::enable_if_t<!std::is_pointer<T>{}, T> const& get_component() const noexcept;
+	std::enable_if_t<!std::is_pointer<T>{}, impl::ConstReference<T>> get_component() const noexcept;
 
 	template <typename T>
 	std::enable_if_t<std::is_pointer<T>{}, std::remove_pointer_t<T>> const* const&
@@ -113,7 +124,7 @@ class EntityHandle final
 	 * 
 	 * \tparam T Type of the component
 	 * \pre The handle is valid
-	 * \return A reference to the component
+	 * \return A reference to the component, or a proxy if `T` uses `SoAStorage`
 	 * \note Only available if `T` is the primary component type or if there is no primary component.
 	 */
 	template <typename T>
@@ -124,7 +135,7 @@ class EntityHandle final
 	 * 
 	 * \tparam T Type of the component
 	 * \pre The handle is valid
-	 * \return A constant reference to the component
+	 * \return A constant reference to the component, or a proxy if `T` uses `SoAStorage`
 	 * \note Only available if `T` is not a pointer type.
 	 */
 	template <typename T>
@@ -142,6 +153,52 @@ class EntityHandle final
 	std::remove_pointer_t<T> const* const& get_component() const noexcept;
 #endif // DOXYGEN_ONLY
 
+#ifndef DOXYGEN_ONLY
+	template <typename T>
+	std::enable_if_t<impl::is_any<P, T, void>{}, T*> find_component() noexcept;
+
+	template <typename T>
+	T const* find_component() const noexcept;
+#else
+	/**
+	 * \brief Retreive a component the entity may not have
+	 * 
+	 * Meant for the components a system declares with `Maybe`.
+	 * 
+	 * \tparam T Type of the component. It must not be a pointer nor use `SoAStorage`
+	 * \pre The handle is valid
+	 * \return A pointer to the component, or `nullptr` if the entity doesn't have it
+	 * \note Only available if `T` is the primary component type or if there is no primary component.
+	 */
+	template <typename T>
+	T* find_component() noexcept;
+
+	/**
+	 * \brief Retreive a component the entity may not have
+	 * 
+	 * Meant for the components a system declares with `Maybe`.
+	 * 
+	 * \tparam T Type of the component. It must not be a pointer nor use `SoAStorage`
+	 * \pre The handle is valid
+	 * \return A constant pointer to the component, or `nullptr` if the entity doesn't have it
+	 */
+	template <typename T>
+	T const* find_component() const noexcept;
+#endif // DOXYGEN_ONLY
+
+	/**
+	 * \brief Retreive the value a component had at the end of the previous frame
+	 *
+	 * Meant for the components a system declares with `Previous`. Components added during the current frame
+	 * read their initial value.
+	 *
+	 * \tparam T Type of the component. It must use `DoubleBufferedStorage`
+	 * \pre The handle is valid
+	 * \return A constant reference to the copy of the component
+	 */
+	template <typename T>
+	T const& get_previous() const noexcept;
+
 	/**
 	 * \brief Query the presence of components
 	 * 
@@ -194,6 +251,44 @@ class EntityHandle final
 	template <typename... Ts>
 	void remove_components();
 
+	/**
+	 * \brief Destroy the associated entity after a number of frames
+	 *
+	 * \param ticks Number of frames. The entity is destroyed at the start of the `ticks`-th next frame
+	 * \pre The handle is valid
+	 * \pre `ticks` is not 0
+	 */
+	void destroy_after(std::size_t ticks);
+
+	/**
+	 * \brief Add a component after a number of frames
+	 *
+	 * Unlike `add_component`, the entity may already have the component when the change is due. The change is
+	 * then dropped : the component keeps its value and `args` are discarded.
+	 *
+	 * \tparam T Type of the component
+	 * \param ticks Number of frames. The component is added at the start of the `ticks`-th next frame
+	 * \param args Parameters to construct the component, which are copied until then. They must be copy
+	 * constructible, since `World::fork` and `World::keep_history` copy the pending changes
+	 * \pre The handle is valid
+	 * \pre `ticks` is not 0
+	 */
+	template <typename T, typename... Args>
+	void add_after(std::size_t ticks, Args&&... args);
+
+	/**
+	 * \brief Remove components after a number of frames
+	 *
+	 * Only the components the entity still has by then are removed.
+	 *
+	 * \tparam Ts Types of the components
+	 * \param ticks Number of frames. The components are removed at the start of the `ticks`-th next frame
+	 * \pre The handle is valid
+	 * \pre `ticks` is not 0
+	 */
+	template <typename... Ts>
+	void remove_after(std::size_t ticks);
+
 	/**
 	 * \brief Equality comparison operator
 	 * 
@@ -203,9 +298,9 @@ class EntityHandle final
 	friend bool operator==(mantra::EntityHandle<W, P, C...> const& l,
 	                       mantra::EntityHandle<W, P, C...> const& r) noexcept
 	{
-		assert(l.valid_ && r.valid_ && "Entities aren't valid");
+		assert(l.valid_() && r.valid_() && "Entities aren't valid");
 
-		return &l.entities_ == &r.entities_ && l.index_ == r.index_;
+		return &l.data_ == &r.data_ && l.index_ == r.index_;
 	}
 	
 	/**
@@ -217,14 +312,28 @@ class EntityHandle final
 	friend bool operator!=(mantra::EntityHandle<W, P, C...> const& l,
 	                       mantra::EntityHandle<W, P, C...> const& r) noexcept
 	{
-		assert(l.valid_ && r.valid_ && "Entities aren't valid");
+		assert(l.valid_() && r.valid_() && "Entities aren't valid");
 
 		return !(l == r);
 	}
 
 	private:
-	typename WC::EntCont& entities_;
+	template <typename>
+	friend class ShardedWorld;
+
+	bool pending_() const noexcept;
+	template <typename F>
+	void defer_(F&&);
+	template <typename F>
+	void schedule_(std::size_t, F&&);
+	template <typename T>
+	static void remove_present_(typename WC::Data&, typename WC::Recorder&, std::size_t);
+
+	typename WC::Data& data_;
+	typename WC::Recorder& recorder_;
+	typename WC::Timers& timers_;
 	std::size_t index_;
+	impl::Commands* commands_;
 };
 
 } // namespace mantra
@@ -0,0 +1,251 @@
+/*****
+ * Copyright Benoit Vey (2016)
+ *
+ * benoit.vey@etu.upmc.fr
+ *
+ * This software is governed by the CeCILL-B license under French law and
+ * abiding by the rules of distribution of free software.  You can  use, 
+ * modify and/ or redistribute the software under the terms of the CeCILL-B
+ * license as circulated by CEA, CNRS and INRIA at the following URL
+ * "http://www.cecill.info". 
+ *
+ * As a counterpart to the access to the source code and  rights to copy,
+ * modify and redistribute granted by the license, users are provided only
+ * with a limited warranty  and the software's author,  the holder of the
+ * economic rights,  and the successive licensors  have only  limited
+ * liability. 
+ *
+ * In this respect, the user's attention is drawn to the risks associated
+ * with loading,  using,  modifying and/or developing or reproducing the
+ * software by the user in light of its specific status of free software,
+ * that may mean  that it is complicated to manipulate,  and  that  also
+ * therefore means  that it is reserved for developers  and  experienced
+ * professionals having in-depth computer knowledge. Users are therefore
+ * encouraged to load and test the software's suitability as regards their
+ * requirements in conditions enabling the security of their systems and/or 
+ * data to be ensured and,  more generally, to use and operate it in the 
+ * same conditions as regards security. 
+ *
+ * The fact that you are presently reading this means that you have had
+ * knowledge of the CeCILL-B license and that you accept its terms.
+ *****/
+
+#ifndef MANTRA_MEMORYRESOURCE_HPP
+#define MANTRA_MEMORYRESOURCE_HPP
+
+#include <cstddef>
+#include <vector>
+
+namespace mantra
+{
+
+/**
+ * \brief Source of memory for the storage of a `World`
+ *
+ * Every internal container of a `World` allocates through the resource given to its constructor. This
+ * follows the interface of `std::pmr::memory_resource`, which isn't available in C++14.
+ *
+ * \sa `default_resource`, `MonotonicResource`, `AlignedResource`
+ */
+class MemoryResource
+{
+	public:
+	/**
+	 * \brief `MemoryResource` is default constructible
+	 */
+	MemoryResource() = default;
+
+	/**
+	 * \brief `MemoryResource` is default copy constructible
+	 */
+	MemoryResource(MemoryResource const&) = default;
+	/**
+	 * \brief `MemoryResource` is default copy assignable
+	 */
+	MemoryResource& operator=(MemoryResource const&) = default;
+
+	/**
+	 * \brief Destructor
+	 */
+	virtual ~MemoryResource() = default;
+
+	/**
+	 * \brief Allocate memory
+	 *
+	 * \param bytes Size of the block
+	 * \param alignment Alignment of the block. Must be a power of 2
+	 * \return A pointer to the block
+	 */
+	void* allocate(std::size_t bytes, std::size_t alignment = alignof(std::max_align_t));
+
+	/**
+	 * \brief Deallocate memory
+	 *
+	 * \param p Pointer to the block
+	 * \param bytes Size of the block
+	 * \param alignment Alignment of the block
+	 * \pre The block was obtained by `allocate(bytes, alignment)` on this resource or on an equal resource
+	 */
+	void deallocate(void* p, std::size_t bytes, std::size_t alignment = alignof(std::max_align_t));
+
+	/**
+	 * \brief Compare two resources
+	 *
+	 * \return True if memory allocated by one resource can be deallocated by the other, false otherwise
+	 */
+	bool is_equal(MemoryResource const& other) const noexcept;
+
+	private:
+	virtual void* do_allocate(std::size_t bytes, std::size_t alignment) = 0;
+	virtual void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) = 0;
+	virtual bool do_is_equal(MemoryResource const& other) const noexcept = 0;
+};
+
+/**
+ * \brief Resource used when none is specified
+ *
+ * \return A resource using the global `operator new` and `operator delete`
+ */
+MemoryResource* default_resource() noexcept;
+
+/**
+ * \brief Arena resource
+ *
+ * Memory is carved out of large blocks obtained from an upstream resource. Deallocation does nothing, and
+ * every block is given back at once when the resource is destroyed or when `release` is called. A whole
+ * `World` can be created and destroyed with a handful of large allocations this way.
+ *
+ * \note Storage that grows leaves its previous buffers in the arena until it is released. Reserving
+ * entities and components up front avoids this.
+ * \note The resource isn't thread-safe.
+ */
+class MonotonicResource final : public MemoryResource
+{
+	public:
+	/**
+	 * \brief Constructor
+	 *
+	 * \param block_size Size of the first block. Each new block is twice as large as the previous one
+	 * \param upstream Resource providing the blocks
+	 */
+	explicit MonotonicResource(std::size_t block_size = 64 * 1024,
+	                           MemoryResource* upstream = default_resource());
+
+	/**
+	 * \brief `MonotonicResource` is not copy constructible
+	 */
+	MonotonicResource(MonotonicResource const&) = delete;
+	/**
+	 * \brief `MonotonicResource` is not copy assignable
+	 */
+	MonotonicResource& operator=(MonotonicResource const&) = delete;
+
+	/**
+	 * \brief Destructor
+	 *
+	 * Releases every block.
+	 */
+	~MonotonicResource() override;
+
+	/**
+	 * \brief Give every block back to the upstream resource
+	 *
+	 * \pre No object is still using memory from this resource
+	 */
+	void release();
+
+	private:
+	struct Block
+	{
+		void* data;
+		std::size_t size;
+	};
+
+	void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+	void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override;
+	bool do_is_equal(MemoryResource const& other) const noexcept override;
+
+	MemoryResource* upstream_;
+	std::vector<Block> blocks_;
+	std::size_t next_size_;
+	char* current_;
+	std::size_t remaining_;
+};
+
+/**
+ * \brief Use of huge pages by an `AlignedResource`
+ */
+enum class HugePages
+{
+	none,        //!< Only regular pages are used
+	transparent, //!< Large blocks are advised to the kernel as candidates for transparent huge pages
+	reserved     //!< Large blocks are mapped from the reserved huge pages, or fall back to `transparent`
+};
+
+/**
+ * \brief Cache line aligned resource
+ *
+ * Every block is aligned to 64 bytes and its size is rounded up to a multiple of 64 bytes, so that two
+ * blocks, and thus two component pools, never share a cache line.
+ *
+ * Blocks of at least `threshold` bytes can be mapped directly from the system, aligned on 2 MiB boundaries
+ * and backed by huge pages, which reduces TLB misses when iterating over large worlds. Explicit huge pages
+ * (`MAP_HUGETLB`) must be reserved by the administrator. When none are left, or when the kernel doesn't
+ * support transparent huge pages, the blocks silently use regular pages. Huge pages are only available on
+ * POSIX systems, elsewhere every block comes from the upstream resource.
+ *
+ * \note The resource is thread-safe if the upstream resource is.
+ */
+class AlignedResource final : public MemoryResource
+{
+	public:
+	/**
+	 * \brief Constructor
+	 *
+	 * \param pages Use of huge pages for large blocks
+	 * \param threshold Size from which blocks are mapped with huge pages
+	 * \param upstream Resource providing the other blocks
+	 */
+	explicit AlignedResource(HugePages pages = HugePages::none, std::size_t threshold = 2 * 1024 * 1024,
+	                         MemoryResource* upstream = default_resource());
+
+	/**
+	 * \brief `AlignedResource` is not copy constructible
+	 */
+	AlignedResource(AlignedResource const&) = delete;
+	/**
+	 * \brief `AlignedResource` is not copy assignable
+	 */
+	AlignedResource& operator=(AlignedResource const&) = delete;
+
+	/**
+	 * \brief `AlignedResource` is default destructible
+	 *
+	 * \pre No object is still using memory from this resource
+	 */
+	~AlignedResource() override = default;
+
+	/**
+	 * \brief Use of huge pages
+	 *
+	 * \return The `HugePages` given to the constructor
+	 */
+	HugePages huge_pages() const noexcept;
+
+	private:
+	bool mapped_(std::size_t bytes, std::size_t alignment) const noexcept;
+
+	void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+	void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override;
+	bool do_is_equal(MemoryResource const& other) const noexcept override;
+
+	MemoryResource* upstream_;
+	HugePages pages_;
+	std::size_t threshold_;
+};
+
+} // namespace mantra
+
+#include "impl/MemoryResourceImpl.hpp"
+
+#endif // Header guard
@@ -0,0 +1,261 @@
+/*****
+ * Copyright Benoit Vey (2016)
+ *
+ * benoit.vey@etu.upmc.fr
+ *
+ * This software is governed by the CeCILL-B license under French law and
+ * abiding by the rules of distribution of free software.  You can  use, 
+ * modify and/ or redistribute the software under the terms of the CeCILL-B
+ * license as circulated by CEA, CNRS and INRIA at the following URL
+ * "http://www.cecill.info". 
+ *
+ * As a counterpart to the access to the source code and  rights to copy,
+ * modify and redistribute granted by the license, users are provided only
+ * with a limited warranty  and the software's author,  the holder of the
+ * economic rights,  and the successive licensors  have only  limited
+ * liability. 
+ *
+ * In this respect, the user's attention is drawn to the risks associated
+ * with loading,  using,  modifying and/or developing or reproducing the
+ * software by the user in light of its specific status of free software,
+ * that may mean  that it is complicated to manipulate,  and  that  also
+ * therefore means  that it is reserved for developers  and  experienced
+ * professionals having in-depth computer knowledge. Users are therefore
+ * encouraged to load and test the software's suitability as regards their
+ * requirements in conditions enabling the security of their systems and/or 
+ * data to be ensured and,  more generally, to use and operate it in the 
+ * same conditions as regards security. 
+ *
+ * The fact that you are presently reading this means that you have had
+ * knowledge of the CeCILL-B license and that you accept its terms.
+ *****/
+
+#ifndef MANTRA_SCHEDULER_HPP
+#define MANTRA_SCHEDULER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mantra
+{
+
+class TaskGroup;
+
+//! \cond
+namespace impl
+{
+
+// A task runs fn(context, begin, end) and then counts itself out of its group
+struct Task
+{
+	void (*fn)(void*, std::size_t, std::size_t);
+	void* context;
+	std::size_t begin;
+	std::size_t end;
+	TaskGroup* group;
+};
+
+} // namespace impl
+//! \endcond
+
+/**
+ * \brief Set of tasks run by a `Scheduler`
+ *
+ * Tasks are added to a group with `Scheduler::spawn`, and `Scheduler::wait` returns once every task of the group
+ * has run. A group can also be given a continuation with `Scheduler::then`, which is spawned when the last task of
+ * the group finishes.
+ *
+ * \note A group can be reused once it has been waited for. It must not be destroyed while some of its tasks are
+ * pending.
+ */
+class TaskGroup
+{
+	public:
+	/**
+	 * \brief Constructor
+	 */
+	TaskGroup() noexcept;
+
+	/**
+	 * \brief `TaskGroup` is not copy constructible
+	 */
+	TaskGroup(TaskGroup const&) = delete;
+	/**
+	 * \brief `TaskGroup` is not copy assignable
+	 */
+	TaskGroup& operator=(TaskGroup const&) = delete;
+
+	/**
+	 * \brief Destructor
+	 *
+	 * \pre No task of the group is pending
+	 */
+	~TaskGroup();
+
+	private:
+	friend class Scheduler;
+
+	// Tasks not finished yet, plus one until the group is closed by wait or then
+	std::atomic<std::size_t> pending_;
+	// Set once the group is complete and its continuation spawned, after which nothing touches the group
+	std::atomic<bool> done_;
+	bool open_;
+	impl::Task continuation_;
+};
+
+/**
+ * \brief Work-stealing task scheduler
+ *
+ * Runs tasks on a fixed set of worker threads. Each worker has its own task queue : it runs the tasks it spawns
+ * in last in, first out order, and steals the oldest tasks of the other queues when its own is empty. Tasks spawned
+ * from other threads go to a shared queue. Idle workers go to sleep until tasks are spawned.
+ *
+ * A thread waiting for a group runs tasks too, so a scheduler without workers runs everything in the waiting thread.
+ * Several worlds can share a scheduler, see `World::set_scheduler`.
+ *
+ * ~~~~{.cpp}
+ * mantra::Scheduler scheduler{3};
+ * mantra::TaskGroup group;
+ * scheduler.spawn(group, [&]{ simulate(left); });
+ * scheduler.spawn(group, [&]{ simulate(right); });
+ * scheduler.wait(group);
+ * ~~~~
+ *
+ * \note Tasks must not throw.
+ */
+class Scheduler
+{
+	public:
+	/**
+	 * \brief Constructor
+	 *
+	 * \param workers Number of worker threads
+	 */
+	explicit Scheduler(std::size_t workers = default_workers());
+
+	/**
+	 * \brief Constructor
+	 *
+	 * Pins the `i`th worker to the CPU `cpus[i % cpus.size()]`. Affinity is ignored on platforms which don't
+	 * support it.
+	 *
+	 * \param workers Number of worker threads
+	 * \param cpus Indices of the CPUs the workers run on. If empty, workers aren't pinned
+	 */
+	Scheduler(std::size_t workers, std::vector<unsigned> const& cpus);
+
+	/**
+	 * \brief `Scheduler` is not copy constructible
+	 */
+	Scheduler(Scheduler const&) = delete;
+	/**
+	 * \brief `Scheduler` is not copy assignable
+	 */
+	Scheduler& operator=(Scheduler const&) = delete;
+
+	/**
+	 * \brief Destructor
+	 *
+	 * Stops and joins the workers.
+	 *
+	 * \pre No task is pending
+	 */
+	~Scheduler();
+
+	/**
+	 * \brief Number of worker threads
+	 */
+	std::size_t workers() const noexcept;
+
+	/**
+	 * \brief Default number of worker threads
+	 *
+	 * \return The number of hardware threads minus one, for the thread waiting for the tasks
+	 */
+	static std::size_t default_workers() noexcept;
+
+	/**
+	 * \brief Run a task
+	 *
+	 * \param group The group of the task
+	 * \param f Callable object taking no parameter. It is copied or moved in the task
+	 * \pre `group` hasn't completed since it was last waited for
+	 */
+	template <typename F>
+	void spawn(TaskGroup& group, F&& f);
+
+	/**
+	 * \brief Run a task after every task of a group
+	 *
+	 * Closes `group` : once its last task finishes, `f` is spawned in `next`. `next` waits for `f` even if `f`
+	 * isn't spawned yet.
+	 *
+	 * \param group The group to wait for. Tasks of the group can still spawn tasks in it, but other threads can't
+	 * \param next The group of the continuation
+	 * \param f Callable object taking no parameter. It is copied or moved in the task
+	 * \pre `group` doesn't have a continuation yet and isn't being waited for
+	 */
+	template <typename F>
+	void then(TaskGroup& group, TaskGroup& next, F&& f);
+
+	/**
+	 * \brief Wait for a group
+	 *
+	 * Runs pending tasks, from any group, until every task of `group` and its continuation are spawned and finished.
+	 * The group can then be reused.
+	 *
+	 * \param group The group to wait for
+	 */
+	void wait(TaskGroup& group);
+
+	/**
+	 * \brief Parallel loop
+	 *
+	 * Splits `[0, n)` in ranges of `grain` indices and calls `f(begin, end)` for each range, concurrently, then waits
+	 * for every range to be processed.
+	 *
+	 * \param n Number of indices
+	 * \param grain Number of indices per task. Must be positive
+	 * \param f Callable object taking the bounds of a range
+	 */
+	template <typename F>
+	void parallel_for(std::size_t n, std::size_t grain, F&& f);
+
+	private:
+	struct Queue
+	{
+		std::mutex mutex;
+		std::deque<impl::Task> tasks;
+	};
+
+	std::size_t queue_() const noexcept;
+	void push_(impl::Task const&);
+	bool pop_(impl::Task&, std::size_t);
+	void execute_(impl::Task const&) noexcept;
+	void finish_(TaskGroup&);
+	void close_(TaskGroup&);
+	void work_(std::size_t);
+	void pin_(std::thread&, unsigned);
+
+	// One queue per worker, then the queue of the other threads
+	std::size_t workers_;
+	std::unique_ptr<Queue[]> queues_;
+	std::vector<std::thread> threads_;
+	std::atomic<std::size_t> queued_;
+	std::atomic<std::size_t> sleepers_;
+	std::atomic<bool> stop_;
+	std::mutex sleep_mutex_;
+	std::condition_variable wake_;
+};
+
+} // namespace mantra
+
+#include "impl/SchedulerImpl.hpp"
+
+#endif // Header guard
@@ -0,0 +1,242 @@
+/*****
+ * Copyright Benoit Vey (2016)
+ *
+ * benoit.vey@etu.upmc.fr
+ *
+ * This software is governed by the CeCILL-B license under French law and
+ * abiding by the rules of distribution of free software.  You can  use, 
+ * modify and/ or redistribute the software under the terms of the CeCILL-B
+ * license as circulated by CEA, CNRS and INRIA at the following URL
+ * "http://www.cecill.info". 
+ *
+ * As a counterpart to the access to the source code and  rights to copy,
+ * modify and redistribute granted by the license, users are provided only
+ * with a limited warranty  and the software's author,  the holder of the
+ * economic rights,  and the successive licensors  have only  limited
+ * liability. 
+ *
+ * In this respect, the user's attention is drawn to the risks associated
+ * with loading,  using,  modifying and/or developing or reproducing the
+ * software by the user in light of its specific status of free software,
+ * that may mean  that it is complicated to manipulate,  and  that  also
+ * therefore means  that it is reserved for developers  and  experienced
+ * professionals having in-depth computer knowledge. Users are therefore
+ * encouraged to load and test the software's suitability as regards their
+ * requirements in conditions enabling the security of their systems and/or 
+ * data to be ensured and,  more generally, to use and operate it in the 
+ * same conditions as regards security. 
+ *
+ * The fact that you are presently reading this means that you have had
+ * knowledge of the CeCILL-B license and that you accept its terms.
+ *****/
+
+#ifndef MANTRA_SHARDEDWORLD_HPP
+#define MANTRA_SHARDEDWORLD_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "Scheduler.hpp"
+#include "World.hpp"
+
+namespace mantra
+{
+
+/**
+ * \brief Several worlds of the same type, updated in parallel
+ *
+ * Splits a simulation in shards, such as the regions of a map, each being a world of its own with its own
+ * entities and systems. Entities move from one shard to another with `migrate`.
+ *
+ * ~~~~{.cpp}
+ * mantra::Scheduler scheduler;
+ * mantra::ShardedWorld<MyWorld> regions{4};
+ * regions.set_scheduler(&scheduler);
+ * auto e = regions.shard(0).create_entity<Position>(mantra::forward_as_tuple(Position{0, 0}));
+ * regions.migrate(e, 1);
+ * regions.update(); // Moves e to the second shard, then updates the 4 shards concurrently
+ * ~~~~
+ *
+ * \tparam W World type of the shards
+ *
+ * \note The shards must not be moved or assigned, since their handles and spawners refer to them.
+ */
+template <typename W>
+class ShardedWorld final
+{
+	public:
+	/**
+	 * \brief Handle passed to the remapping function of `apply_migrations`
+	 */
+	using Handle = decltype(std::declval<W&>().template create_entity<>());
+
+	/**
+	 * \brief Constructor
+	 *
+	 * Default-constructs the shards.
+	 *
+	 * \param shards Number of shards
+	 * \pre `shards > 0`
+	 */
+	explicit ShardedWorld(std::size_t shards);
+
+	/**
+	 * \brief Constructor
+	 *
+	 * Constructs the shards with `make`, for instance to give arguments to their systems or their own memory
+	 * resource.
+	 *
+	 * \param shards Number of shards
+	 * \param make Function taking the index of a shard and returning the shard by value
+	 * \pre `shards > 0`
+	 */
+	template <typename F>
+	ShardedWorld(std::size_t shards, F&& make);
+
+	/**
+	 * \brief `ShardedWorld` is not copy constructible
+	 */
+	ShardedWorld(ShardedWorld const&) = delete;
+	/**
+	 * \brief `ShardedWorld` is not copy assignable
+	 */
+	ShardedWorld& operator=(ShardedWorld const&) = delete;
+
+	/**
+	 * \brief `ShardedWorld` is default move constructible
+	 *
+	 * \note The shards aren't moved themselves, their handles stay valid.
+	 */
+	ShardedWorld(ShardedWorld&&) = default;
+	/**
+	 * \brief `ShardedWorld` is not move assignable
+	 */
+	ShardedWorld& operator=(ShardedWorld&&) = delete;
+
+	/**
+	 * \brief Number of shards
+	 */
+	std::size_t shards() const noexcept;
+
+	/**
+	 * \brief Access a shard
+	 *
+	 * \param i Index of the shard
+	 * \pre `i < shards()`
+	 * \return A reference to the shard
+	 */
+	W& shard(std::size_t i) noexcept;
+
+	/**
+	 * \brief Access a shard
+	 *
+	 * \param i Index of the shard
+	 * \pre `i < shards()`
+	 * \return A constant reference to the shard
+	 */
+	W const& shard(std::size_t i) const noexcept;
+
+	/**
+	 * \brief Move an entity to another shard
+	 *
+	 * The migration is queued, and applied with the other queued migrations by `apply_migrations` or the next
+	 * `update`. The entity is then created in the target shard with the components it has at that time, moved
+	 * from the source shard, and destroyed in the source shard. Its delayed changes (`destroy_after`, ...) are
+	 * dropped.
+	 *
+	 * \param entity A handle to an entity of one of the shards
+	 * \param target Index of the target shard
+	 * \pre The handle is valid, `target < shards()`, and no shard is being updated
+	 * \note Migrating an entity to its own shard does nothing. If an entity is migrated several times before
+	 * the migrations are applied, only the first migration is applied. Migrations of entities destroyed in the
+	 * meantime are dropped.
+	 */
+	template <typename P, typename... O>
+	void migrate(EntityHandle<W, P, O...> const& entity, std::size_t target);
+
+	/**
+	 * \brief Apply the queued migrations
+	 *
+	 * \return The number of migrated entities
+	 * \note The handles of the migrated entities in their source shard are invalidated.
+	 */
+	std::size_t apply_migrations();
+
+	/**
+	 * \brief Apply the queued migrations, and remap the handles of the migrated entities
+	 *
+	 * ~~~~{.cpp}
+	 * regions.apply_migrations([&](auto const& from, auto const& to){ lookup.replace(from, to); });
+	 * ~~~~
+	 *
+	 * \param remap Function called for each migrated entity with two constant `Handle` references : the handle
+	 * of the entity in its source shard, and its handle in the target shard. The entity is destroyed in its
+	 * source shard once `remap` returns, and its components there are left moved-from
+	 * \return The number of migrated entities
+	 * \note The handles of the migrated entities in their source shard are invalidated.
+	 */
+	template <typename F>
+	std::size_t apply_migrations(F&& remap);
+
+	/**
+	 * \brief Run a frame of every shard
+	 *
+	 * Applies the queued migrations, then updates the shards with `World::update`. The shards are updated
+	 * concurrently on the scheduler, if one is set.
+	 *
+	 * \note Shards sharing a memory resource need it to be thread-safe.
+	 */
+	void update();
+
+	/**
+	 * \brief Advance every shard by some time
+	 *
+	 * Applies the queued migrations, then updates the shards with `World::update(dt)`. The shards are updated
+	 * concurrently on the scheduler, if one is set.
+	 *
+	 * \param dt Time elapsed since the last update
+	 * \note Shards sharing a memory resource need it to be thread-safe.
+	 */
+	void update(double dt);
+
+	/**
+	 * \brief Set the scheduler of the shards
+	 *
+	 * The shards are updated concurrently on the scheduler, which is also set as the scheduler of each shard,
+	 * so that their systems run on it too.
+	 *
+	 * \param scheduler The scheduler, or `nullptr` to update the shards one after another in the calling
+	 * thread. It must outlive its use by the shards
+	 */
+	void set_scheduler(Scheduler* scheduler) noexcept;
+
+	/**
+	 * \brief Scheduler of the shards
+	 *
+	 * \return The scheduler set by `set_scheduler`, `nullptr` by default
+	 */
+	Scheduler* scheduler() const noexcept;
+
+	private:
+	// The generation tells whether the entity was destroyed since the migration was queued
+	struct Migration
+	{
+		std::size_t source;
+		std::size_t index;
+		std::uint32_t generation;
+		std::size_t target;
+	};
+
+	template <typename F>
+	void update_(F);
+
+	std::vector<W> shards_;
+	std::vector<Migration> migrations_;
+	Scheduler* scheduler_;
+};
+
+} // namespace mantra
+
+#include "impl/ShardedWorldImpl.hpp"
+
+#endif // Header guard
@@ -0,0 +1,171 @@
+/*****
+ * Copyright Benoit Vey (2016)
+ *
+ * benoit.vey@etu.upmc.fr
+ *
+ * This software is governed by the CeCILL-B license under French law and
+ * abiding by the rules of distribution of free software.  You can  use, 
+ * modify and/ or redistribute the software under the terms of the CeCILL-B
+ * license as circulated by CEA, CNRS and INRIA at the following URL
+ * "http://www.cecill.info". 
+ *
+ * As a counterpart to the access to the source code and  rights to copy,
+ * modify and redistribute granted by the license, users are provided only
+ * with a limited warranty  and the software's author,  the holder of the
+ * economic rights,  and the successive licensors  have only  limited
+ * liability. 
+ *
+ * In this respect, the user's attention is drawn to the risks associated
+ * with loading,  using,  modifying and/or developing or reproducing the
+ * software by the user in light of its specific status of free software,
+ * that may mean  that it is complicated to manipulate,  and  that  also
+ * therefore means  that it is reserved for developers  and  experienced
+ * professionals having in-depth computer knowledge. Users are therefore
+ * encouraged to load and test the software's suitability as regards their
+ * requirements in conditions enabling the security of their systems and/or 
+ * data to be ensured and,  more generally, to use and operate it in the 
+ * same conditions as regards security. 
+ *
+ * The fact that you are presently reading this means that you have had
+ * knowledge of the CeCILL-B license and that you accept its terms.
+ *****/
+
+#ifndef MANTRA_SNAPSHOT_HPP
+#define MANTRA_SNAPSHOT_HPP
+
+#include <cstdint>
+
+#include "impl/SnapshotRing.hpp"
+
+namespace mantra
+{
+
+/**
+ * \brief Read-only copy of components, as they were at the end of a frame
+ *
+ * Holds the components `Ts` of every entity owning all of them. While the snapshot exists, the world doesn't
+ * overwrite it. See `World::snapshots`.
+ *
+ * \tparam Ts Types of the components
+ *
+ * \note Instances are created and returned by `SnapshotReader::read`.
+ */
+template <typename... Ts>
+class Snapshot final
+{
+	using Buffer = typename impl::SnapshotRing<Ts...>::Buffer;
+
+	public:
+	//! \cond
+	explicit Snapshot(Buffer const*) noexcept;
+	//! \endcond
+
+	/**
+	 * \brief `Snapshot` is not copy constructible
+	 */
+	Snapshot(Snapshot const&) = delete;
+	/**
+	 * \brief `Snapshot` is not copy assignable
+	 */
+	Snapshot& operator=(Snapshot const&) = delete;
+
+	/**
+	 * \brief `Snapshot` is move constructible
+	 *
+	 * \note The moved-from snapshot is empty
+	 */
+	Snapshot(Snapshot&&) noexcept;
+	/**
+	 * \brief `Snapshot` is not move assignable
+	 */
+	Snapshot& operator=(Snapshot&&) = delete;
+
+	/**
+	 * \brief Destructor
+	 *
+	 * Lets the world reuse the snapshot.
+	 */
+	~Snapshot();
+
+	/**
+	 * \brief Whether the snapshot holds a frame
+	 *
+	 * \return False if no frame was completed since the snapshots were requested, true otherwise
+	 */
+	explicit operator bool() const noexcept;
+
+	/**
+	 * \brief Frame of the snapshot
+	 *
+	 * \pre The snapshot holds a frame
+	 * \return The number of frames completed by the world since the snapshots were requested, when the
+	 * snapshot was taken
+	 */
+	std::uint64_t frame() const noexcept;
+
+	/**
+	 * \brief Number of entities in the snapshot
+	 *
+	 * \return The number of entities owning all of `Ts`, or 0 if the snapshot holds no frame
+	 */
+	std::size_t size() const noexcept;
+
+	/**
+	 * \brief Retreive a component
+	 *
+	 * \tparam T Type of the component
+	 * \param i Position of the entity in the snapshot
+	 * \pre `i < size()`
+	 * \return A constant reference to the copy of the component
+	 */
+	template <typename T>
+	T const& get(std::size_t i) const noexcept;
+
+	/**
+	 * \brief Apply a function to every entity of the snapshot
+	 *
+	 * \param f A function taking constant references to `Ts`
+	 */
+	template <typename F>
+	void for_each(F&& f) const;
+
+	private:
+	Buffer const* buffer_;
+};
+
+/**
+ * \brief Access point to the snapshots of components taken by a world
+ *
+ * Readers can be copied and used from any thread.
+ *
+ * \tparam Ts Types of the components
+ *
+ * \note Instances are created and returned by `World::snapshots`.
+ */
+template <typename... Ts>
+class SnapshotReader final
+{
+	public:
+	//! \cond
+	explicit SnapshotReader(impl::SnapshotRing<Ts...>&) noexcept;
+	//! \endcond
+
+	/**
+	 * \brief Get the newest snapshot
+	 *
+	 * Never waits for the world.
+	 *
+	 * \return The snapshot of the last frame the world could publish, which is empty if no frame was completed
+	 * yet
+	 */
+	Snapshot<Ts...> read() const noexcept;
+
+	private:
+	impl::SnapshotRing<Ts...>* ring_;
+};
+
+} // namespace mantra
+
+#include "impl/SnapshotImpl.hpp"
+
+#endif // Header guard
@@ -0,0 +1,137 @@
+/*****
+ * Copyright Benoit Vey (2016)
+ *
+ * benoit.vey@etu.upmc.fr
+ *
+ * This software is governed by the CeCILL-B license under French law and
+ * abiding by the rules of distribution of free software.  You can  use, 
+ * modify and/ or redistribute the software under the terms of the CeCILL-B
+ * license as circulated by CEA, CNRS and INRIA at the following URL
+ * "http://www.cecill.info". 
+ *
+ * As a counterpart to the access to the source code and  rights to copy,
+ * modify and redistribute granted by the license, users are provided only
+ * with a limited warranty  and the software's author,  the holder of the
+ * economic rights,  and the successive licensors  have only  limited
+ * liability. 
+ *
+ * In this respect, the user's attention is drawn to the risks associated
+ * with loading,  using,  modifying and/or developing or reproducing the
+ * software by the user in light of its specific status of free software,
+ * that may mean  that it is complicated to manipulate,  and  that  also
+ * therefore means  that it is reserved for developers  and  experienced
+ * professionals having in-depth computer knowledge. Users are therefore
+ * encouraged to load and test the software's suitability as regards their
+ * requirements in conditions enabling the security of their systems and/or 
+ * data to be ensured and,  more generally, to use and operate it in the 
+ * same conditions as regards security. 
+ *
+ * The fact that you are presently reading this means that you have had
+ * knowledge of the CeCILL-B license and that you accept its terms.
+ *****/
+
+#ifndef MANTRA_SPAWNER_HPP
+#define MANTRA_SPAWNER_HPP
+
+#include "MemoryResource.hpp"
+#include "impl/Commands.hpp"
+#include "impl/SpawnQueue.hpp"
+#include "impl/utility.hpp"
+
+namespace mantra
+{
+
+/**
+ * \brief Creates entities in a world from another thread
+ *
+ * The entities are staged in a batch owned by the spawner, and handed over to the world by `submit`. The
+ * world creates the submitted entities at the start of its next `update`, before saving its state and
+ * firing the delayed changes, in the order in which the batches were submitted. Submitting never blocks:
+ * the world and its spawners don't share any lock.
+ *
+ * Each producer thread uses its own spawner. The staged entities have no handle and no index until the world
+ * creates them.
+ *
+ * \tparam W Associated World type
+ *
+ * \note Instances are created and returned by `World::spawner`.
+ * \note The world must outlive its spawners, and must not be moved or assigned while they exist.
+ */
+template <typename W>
+class Spawner final
+{
+	using WC = impl::WorldCont<typename W::Components, typename W::Systems, typename W::Resources,
+	                           typename W::Index>;
+	using Batch = typename WC::Spawns::Batch;
+
+	public:
+	//! \cond
+	Spawner(typename WC::Spawns&, MemoryResource*) noexcept;
+	//! \endcond
+
+	/**
+	 * \brief `Spawner` is not copy constructible
+	 */
+	Spawner(Spawner const&) = delete;
+	/**
+	 * \brief `Spawner` is not copy assignable
+	 */
+	Spawner& operator=(Spawner const&) = delete;
+
+	/**
+	 * \brief `Spawner` is move constructible
+	 */
+	Spawner(Spawner&&) noexcept;
+	/**
+	 * \brief `Spawner` is not move assignable
+	 */
+	Spawner& operator=(Spawner&&) = delete;
+
+	/**
+	 * \brief Destructor
+	 *
+	 * Submits the staged entities.
+	 */
+	~Spawner();
+
+	/**
+	 * \brief Stage a new entity
+	 *
+	 * Default-constructs the components when the world creates the entity.
+	 *
+	 * \tparam Ts Components the new entity will have
+	 */
+	template <typename... Ts>
+	void create_entity();
+
+	/**
+	 * \brief Stage a new entity
+	 *
+	 * Constructs the components with copies of `args` when the world creates the entity.
+	 *
+	 * \tparam Ts Components the new entity will have
+	 * \param args A pack of tuples holding the parameters to construct each component
+	 */
+	template <typename... Ts, typename... Args>
+	void create_entity(Args&&... args);
+
+	/**
+	 * \brief Hand the staged entities over to the world
+	 *
+	 * The world creates them at the start of its next `update`. Does nothing if no entity is staged.
+	 */
+	void submit() noexcept;
+
+	private:
+	Batch& staging_();
+
+	typename WC::Spawns* queue_;
+	MemoryResource* resource_;
+	Batch* batch_;
+};
+
+} // namespace mantra
+
+#include "impl/SpawnerImpl.hpp"
+
+#endif // Header guard
@@ -0,0 +1,226 @@
+/*****
+ * Copyright Benoit Vey (2016)
+ *
+ * benoit.vey@etu.upmc.fr
+ *
+ * This software is governed by the CeCILL-B license under French law and
+ * abiding by the rules of distribution of free software.  You can  use, 
+ * modify and/ or redistribute the software under the terms of the CeCILL-B
+ * license as circulated by CEA, CNRS and INRIA at the following URL
+ * "http://www.cecill.info". 
+ *
+ * As a counterpart to the access to the source code and  rights to copy,
+ * modify and redistribute granted by the license, users are provided only
+ * with a limited warranty  and the software's author,  the holder of the
+ * economic rights,  and the successive licensors  have only  limited
+ * liability. 
+ *
+ * In this respect, the user's attention is drawn to the risks associated
+ * with loading,  using,  modifying and/or developing or reproducing the
+ * software by the user in light of its specific status of free software,
+ * that may mean  that it is complicated to manipulate,  and  that  also
+ * therefore means  that it is reserved for developers  and  experienced
+ * professionals having in-depth computer knowledge. Users are therefore
+ * encouraged to load and test the software's suitability as regards their
+ * requirements in conditions enabling the security of their systems and/or 
+ * data to be ensured and,  more generally, to use and operate it in the 
+ * same conditions as regards security. 
+ *
+ * The fact that you are presently reading this means that you have had
+ * knowledge of the CeCILL-B license and that you accept its terms.
+ *****/
+
+#ifndef MANTRA_STORAGE_HPP
+#define MANTRA_STORAGE_HPP
+
+#include <cstddef>
+#include <type_traits>
+
+namespace mantra
+{
+
+/**
+ * \brief Contiguous storage policy
+ *
+ * Components are stored in a single growable array. This is the default policy for non-empty types.
+ *
+ * \note When the array grows past its capacity, every component is moved and references to components are
+ * invalidated.
+ */
+struct DenseStorage
+{};
+
+/**
+ * \brief Paged storage policy
+ *
+ * Components are stored in fixed-size pages allocated on demand. Growing the storage never moves existing
+ * components, so references to a component stay valid for the lifetime of the component, and growth costs
+ * a single page allocation. Pages are shared with the worlds forked from the owning world, and copied on
+ * first write access, see `World::fork`.
+ *
+ * \tparam N Number of components per page. Must be a power of 2
+ */
+template <std::size_t N = 1024>
+struct PagedStorage
+{
+	static_assert(N && !(N & (N - 1)), "The page size must be a power of 2");
+};
+
+/**
+ * \brief Sparse set storage policy
+ *
+ * Components are packed in a contiguous array, with a separate array mapping entities to their component.
+ * Removing a component moves the last component into the hole, so the array never has holes. Suited to
+ * components that are added and removed often.
+ *
+ * \note Removing a component invalidates references to the last component of the array.
+ */
+struct SparseSetStorage
+{};
+
+/**
+ * \brief Hash map storage policy
+ *
+ * Components are stored in a hash map indexed by entity. Suited to components that only a few entities own,
+ * since the memory used is proportional to the number of components rather than to the number of entities.
+ */
+struct HashMapStorage
+{};
+
+/**
+ * \brief Double-buffered storage policy
+ *
+ * Components are stored in an array indexed by entity, along with a copy of their value at the end of the
+ * previous frame. The copies are refreshed at the end of every `World::update`, and the systems declaring a
+ * `Previous` term read them instead of the components. Those systems don't wait for the primary system of
+ * the component, since it never writes to the copies. The component must be copyable.
+ *
+ * \note Memory is used twice for every entity index up to the highest owner.
+ */
+struct DoubleBufferedStorage
+{};
+
+/**
+ * \brief Tag storage policy
+ *
+ * Nothing is stored, only the presence of the component is recorded in the entities. Only available for
+ * empty types. This is the default policy for empty types.
+ *
+ * \note Every entity owning the component sees the same object.
+ */
+struct TagStorage
+{};
+
+/**
+ * \brief Singleton storage policy
+ *
+ * Storage for a single component, which at most one entity can own at a time. Suited to global data.
+ */
+struct SingletonStorage
+{};
+
+/**
+ * \brief Number of entities in a chunk
+ *
+ * Entities are split in chunks of consecutive indices for chunked iteration. Every field array of a
+ * `SoAStorage` holds a multiple of `chunk_size` elements and is aligned to `chunk_size` bytes, so the fields of
+ * a chunk always start on a 64 bytes boundary.
+ */
+std::size_t constexpr chunk_size{64};
+
+/**
+ * \brief Member of an aggregate component
+ *
+ * Describes a data member for `SoAStorage`. The `MANTRA_MEMBER(T, m)` macro spells `Member<decltype(&T::m), &T::m>`.
+ *
+ * \tparam M Pointer to member type
+ * \tparam ptr Pointer to the member
+ */
+template <typename M, M ptr>
+struct Member;
+
+//! \cond
+template <typename T, typename F, F T::*ptr>
+struct Member<F T::*, ptr>
+{
+	using Class = T;
+	using Type = F;
+
+	static F& get(T& object) noexcept
+	{
+		return object.*ptr;
+	}
+
+	static F const& get(T const& object) noexcept
+	{
+		return object.*ptr;
+	}
+};
+//! \endcond
+
+#define MANTRA_MEMBER(T, m) ::mantra::Member<decltype(&T::m), &T::m>
+
+/**
+ * \brief Struct-of-arrays storage policy
+ *
+ * Each listed member of the component is stored in its own array, indexed by entity and aligned for vector
+ * instructions. Chunked iteration from a `WorldView` then gives direct access to the fields of whole chunks
+ * of entities. The members must be trivially copyable and the component default constructible.
+ *
+ * Since no component object exists in memory, `get_component` returns a proxy instead of a reference. The
+ * proxy converts to the component and can be assigned from it, which gathers and scatters every field, and
+ * `get<I>()` gives a reference to the `I`th listed field.
+ *
+ * ~~~~{.cpp}
+ * namespace mantra
+ * {
+ * template <>
+ * struct storage_traits<Velocity>
+ * {
+ *     using storage = SoAStorage<MANTRA_MEMBER(Velocity, x), MANTRA_MEMBER(Velocity, y)>;
+ * };
+ * }
+ * ~~~~
+ *
+ * \tparam M `Member`s of the component. Members that are not listed are not stored
+ * \note Memory is used for every entity index up to the highest owner, so this policy suits components that
+ * most entities own.
+ */
+template <typename... M>
+struct SoAStorage
+{
+	static_assert(sizeof...(M) > 0, "No members supplied");
+};
+
+/**
+ * \brief Storage customisation point
+ *
+ * Specialise this template to select how a component type is stored. The specialisation must define a type
+ * named `storage`, which is one of the storage policies. By default, empty types use `TagStorage` and other
+ * types use `DenseStorage`.
+ *
+ * ~~~~{.cpp}
+ * namespace mantra
+ * {
+ * template <>
+ * struct storage_traits<Position>
+ * {
+ *     using storage = PagedStorage<4096>;
+ * };
+ * }
+ * ~~~~
+ *
+ * \tparam T The component type
+ */
+template <typename T>
+struct storage_traits
+{
+	/**
+	 * \brief Storage policy of `T`
+	 */
+	using storage = std::conditional_t<std::is_empty<T>{}, TagStorage, DenseStorage>;
+};
+
+} // namespace mantra
+
+#endif // Header guard
@@ -41,6 +41,58 @@
 namespace mantra
 {
 
+/**
+ * \brief Exclusion term of a system declaration
+ *
+ * The system won't see the entities having any of `T`.
+ *
+ * \tparam T Excluded component types
+ * \sa `System`
+ */
+template <typename... T>
+struct Without
+{};
+
+/**
+ * \brief Optional term of a system declaration
+ *
+ * The system sees entities whether they have `T` or not, and can read them with
+ * `EntityHandle::find_component`.
+ *
+ * \tparam T Optional component types. They are read-only
+ * \sa `System`
+ */
+template <typename... T>
+struct Maybe
+{};
+
+/**
+ * \brief Resource term of a system declaration
+ *
+ * The system can access the resources `T` with `WorldView::resource`. They are read-only, unless one of them
+ * is the primary type of the system, in which case the system has no primary component.
+ *
+ * \tparam T Resource types
+ * \sa `System`, `World`
+ */
+template <typename... T>
+struct Uses
+{};
+
+/**
+ * \brief Previous frame term of a system declaration
+ *
+ * The system only sees the entities having `T`, and reads the value `T` had at the end of the previous frame
+ * with `EntityHandle::get_previous`. It doesn't access the current value, so it can run alongside the primary
+ * system of `T` in the update stages.
+ *
+ * \tparam T Component type. It must use `DoubleBufferedStorage`
+ * \sa `System`, `World::update`
+ */
+template <typename T>
+struct Previous
+{};
+
 /**
  * \brief Helper class for systems
  * 
@@ -50,22 +102,28 @@ namespace mantra
  * \tparam P Primary component type. The primary component is the only writable component.
  * If `P` is void, there is no primary component and the system can't write to anything
  * \tparam C Secondary components types. Secondary components are read-only. The system will only be able to
- * access entities that possess all secondary components and the primary component, if any
+ * access entities that possess all secondary components and the primary component, if any. `C` can also
+ * contain `Without` and `Maybe` terms, to skip the entities having some components and to access components
+ * without requiring them, `Previous` terms, to read the components of the previous frame, and `Uses` terms, to
+ * access world resources
  * \note Inheriting from `System` is a convenience, but it is not mandatory. You can create your own isolated
  * class and provide
  * \arg A type named `Primary`, which can be `void`
  * \arg A type named `Components` defined as `ComponentList<C...>`, with `C` the list of components types
  * which should include `Primary` if it is not `void`, and should not include it if it is
+ * \arg Optionally, a type named `Terms`, as defined by `System`
  * \arg A function `void %update(WV&&)` with `WV` template
  */
 template <typename P, typename... C>
 class System
 {
+	using Split = impl::SplitTerms<impl::Pack<>, impl::Pack<>, impl::Pack<>, impl::Pack<>, C...>;
+
 	public:
 	//! \cond
 	using Primary = P;
-	using Components = std::conditional_t<std::is_same<P, void>{},
-	                                      impl::TypeList<C...>, impl::TypeList<P, C...>>;
+	using Components = typename Split::template Components<P>;
+	using Terms = typename Split::Terms;
 	//! \endcond
 
 	/**
@@ -36,10 +36,25 @@
 #include <algorithm>
 #include <array>
 #include <cassert>
+#include <cmath>
+#include <cstdint>
 #include <functional>
+#include <istream>
+#include <memory>
+#include <ostream>
 
 #include "EntityHandle.hpp"
+#include "MemoryResource.hpp"
+#include "Scheduler.hpp"
+#include "Snapshot.hpp"
+#include "Spawner.hpp"
 #include "tuple_create.hpp"
+#include "impl/History.hpp"
+#include "impl/Registry.hpp"
+#include "impl/Schedule.hpp"
+#include "impl/SpawnQueue.hpp"
+#include "impl/TimingWheel.hpp"
+#include "impl/Trace.hpp"
 
 /**
  * \brief Library namespace
@@ -59,6 +74,21 @@ using ComponentList = impl::TypeList<C...>;
 template <typename... S>
 using SystemList = impl::TypeList<S...>;
 
+/**
+ * \brief Helper type for resource sets
+ */
+template <typename... R>
+using ResourceList = impl::TypeList<R...>;
+
+/**
+ * \brief Helper type for schedules
+ *
+ * \tparam St The stages of the schedule, as `SystemList`s
+ * \sa `World::Schedule`
+ */
+template <typename... St>
+using StageList = impl::TypeList<St...>;
+
 //! \cond
 template <typename... C>
 using CL = ComponentList<C...>;
@@ -66,10 +96,33 @@ using CL = ComponentList<C...>;
 template <typename... S>
 using SL = SystemList<S...>;
 
-template <typename Comp, typename Sys>
+template <typename... R>
+using RL = ResourceList<R...>;
+
+template <typename Comp, typename Sys, typename Res = ResourceList<>, typename I = std::uint32_t>
 class World;
 //! \endcond
 
+/**
+ * \brief How a trace is replayed
+ *
+ * \sa `World::replay`
+ */
+enum class ReplayMode
+{
+	/**
+	 * \brief Apply every recorded operation, including the ones issued by systems, without updating the
+	 * systems. Frame markers are only counted
+	 */
+	operations,
+	/**
+	 * \brief Apply the operations issued from outside the systems and update the world on each frame
+	 * marker, with the systems that were due when recording. The operations issued by systems are skipped,
+	 * since the systems issue them again
+	 */
+	simulation
+};
+
 /**
  * \brief Main library class
  * 
@@ -77,16 +130,43 @@ class World;
  * 
  * \tparam C The set of components types.
  * \tparam S The set of systems types.
+ * \tparam R The set of resources types. Resources are world-wide objects, such as a clock or a random
+ * generator, which systems access with `WorldView::resource` if they declare them with `Uses`.
+ * \tparam I Unsigned integer type of the component keys stored in each entity record. A narrower type gives
+ * smaller records, but a component pool can't hold more components than `I` can count. Adding a component
+ * past that limit terminates the program.
  */
-template <typename... C, typename... S>
-class World<ComponentList<C...>, SystemList<S...>> final
+template <typename... C, typename... S, typename... R, typename I>
+class World<ComponentList<C...>, SystemList<S...>, ResourceList<R...>, I> final
 {
-	using Self = World<CL<C...>, SL<S...>>;
+	static_assert(sizeof...(C) > 0, "No component types supplied");
+
+	using Self = World<CL<C...>, SL<S...>, RL<R...>, I>;
 	public:
 	//! \cond
 	using Components = CL<C...>;
 	using Systems = SL<S...>;
+	using Resources = RL<R...>;
+	using Index = I;
 	//! \endcond
+
+	/**
+	 * \brief Stages of the parallel update
+	 *
+	 * A `StageList` of `SystemList`s, computed at compile time. Each system is placed in the stage following the
+	 * last stage holding an earlier system of `S` it conflicts with, two systems conflicting if one of them
+	 * writes its primary component or resource while the other accesses it. The systems of a stage can thus
+	 * run concurrently, and conflicting systems still run in the order of `S`. Reading a component through a
+	 * `Previous` term doesn't access it.
+	 *
+	 * ~~~~{.cpp}
+	 * static_assert(std::is_same<MyWorld::Schedule,
+	 *                            StageList<SystemList<MoveSys, AiSys>, SystemList<RenderSys>>>{}, "");
+	 * ~~~~
+	 *
+	 * \sa `update`
+	 */
+	using Schedule = impl::Schedule<S...>;
 	
 	/**
 	 * \brief Constructor
@@ -108,6 +188,29 @@ class World<ComponentList<C...>, SystemList<S...>> final
 	template <typename... Args>
 	World(Args&&... args);
 
+	/**
+	 * \brief Constructor
+	 *
+	 * Default-constructs the systems. Every internal container allocates from `resource`.
+	 *
+	 * \param resource A `MemoryResource`. It must outlive the world
+	 * \sa `create_world`
+	 */
+	template <typename MR>
+	World(std::allocator_arg_t, MR& resource);
+
+	/**
+	 * \brief Constructor
+	 *
+	 * Constructs the systems with `args`. Every internal container allocates from `resource`.
+	 *
+	 * \param resource A `MemoryResource`. It must outlive the world
+	 * \param args A pack of tuples holding the parameters to construct each system
+	 * \sa `create_world`
+	 */
+	template <typename MR, typename... Args>
+	World(std::allocator_arg_t, MR& resource, Args&&... args);
+
 	/**
 	 * \brief `World` is not copy constructible
 	 */
@@ -127,9 +230,28 @@ class World<ComponentList<C...>, SystemList<S...>> final
 	World& operator=(World&&) = default;
 
 	/**
-	 * \brief Destructor
+	 * \brief `World` is default destructible
+	 */
+	~World() = default;
+
+	/**
+	 * \brief Fork the world
+	 *
+	 * Creates a child world holding the same entities, components, systems and resources as this world, for
+	 * example to simulate speculative frames without disturbing it. Pages of components with `PagedStorage`
+	 * are shared between the two worlds until either of them gets write access to a component of the page
+	 * (mutable `get_component`, adding or removing a component), which then copies the page. Components with
+	 * other storage policies are copied by the fork, and so are the pending delayed changes.
+	 *
+	 * The two worlds are independent afterwards, and can be updated concurrently from different threads if
+	 * their memory resource is thread-safe.
+	 *
+	 * \return The child world. It allocates from the memory resource of this world, shares its scheduler and
+	 * determinism, doesn't record and keeps no history
+	 * \pre The components, systems and resources are copy constructible
+	 * \note The world must not be modified while it is being forked.
 	 */
-	~World();
+	World fork() const;
 
 	/**
 	 * \brief Create a new entity
@@ -156,15 +278,98 @@ class World<ComponentList<C...>, SystemList<S...>> final
 	template <typename... Ts, typename... Args>
 	EntityHandle<Self, void, C...> create_entity(Args&&... args);
 
+	/**
+	 * \brief Get a spawner, to create entities from another thread
+	 *
+	 * The spawner stages the entities and hands them over to the world, which creates them at the start of
+	 * its next `update`. See `Spawner`.
+	 *
+	 * ~~~~{.cpp}
+	 * auto spawner = world.spawner();
+	 * spawner.create_entity<Position>(mantra::forward_as_tuple(Position{0, 0})); // On a network thread
+	 * spawner.submit();
+	 * ~~~~
+	 *
+	 * \param resource The resource the spawner allocates the staged entities from. It must be thread-safe and
+	 * outlive the world
+	 * \return The spawner. Each thread should use its own
+	 * \note Spawners may be obtained and used from any thread, concurrently with `update`.
+	 */
+	Spawner<Self> spawner(MemoryResource* resource = default_resource()) noexcept;
+
+	/**
+	 * \brief Publish snapshots of components for other threads
+	 *
+	 * At the end of every `update`, the world copies the components `Ts` of the entities owning all of them
+	 * into one of `buffers` snapshots, which readers on other threads get with `SnapshotReader::read`. The
+	 * world never waits for the readers: it only writes a snapshot that isn't the newest and isn't being
+	 * read, and skips the frame if there is none. Readers never wait either, and always get the snapshot of
+	 * a whole frame.
+	 *
+	 * ~~~~{.cpp}
+	 * auto reader = world.snapshots<Position, Health>();
+	 * // On a UI thread
+	 * auto snapshot = reader.read();
+	 * snapshot.for_each([](Position const& p, Health const& h){draw(p, h);});
+	 * ~~~~
+	 *
+	 * \tparam Ts Types of the components. They must be copy constructible and not be pointers
+	 * \param buffers Number of snapshots. More snapshots let the world publish more frames while readers hold
+	 * older ones
+	 * \return A reader of the snapshots. It must not outlive the world
+	 * \pre `buffers >= 2`
+	 * \note Each call adds snapshots copied every frame. The reader should be shared rather than requested
+	 * again.
+	 */
+	template <typename... Ts>
+	SnapshotReader<Ts...> snapshots(std::size_t buffers = 3);
+
 	/**
 	 * \brief Run a frame of the world
 	 * 
 	 * Each system is updated once.
-	 * 
-	 * \note The systems are updated sequentially, in the order in which they appear in `S`.
+	 *
+	 * The entities submitted by spawners since the previous frame are created first (see `spawner`). Then, the
+	 * delayed changes due this frame (see `EntityHandle::destroy_after`) are applied, in a
+	 * deterministic order. Their cost only depends on the number of changes due, not on the number pending.
+	 *
+	 * Without a scheduler, the systems are updated sequentially, in the order in which they appear in `S`.
+	 * With a scheduler, they are updated stage by stage, as laid out by `Schedule`, and the systems of a stage
+	 * are updated concurrently. When a stage holds several systems, the structural changes they make (creating
+	 * and destroying entities, adding and removing components) and the messages they send are deferred until
+	 * every system of the stage is done, then applied system by system, in the order of `S`. Deferred changes
+	 * to an entity destroyed in the meantime are dropped. A deterministic world is always updated stage by
+	 * stage, see `set_deterministic`.
+	 *
+	 * Once every system is updated, the copies of the components using `DoubleBufferedStorage` are refreshed,
+	 * and the systems reading them through `Previous` terms see the values of this frame on the next one. The
+	 * snapshots requested with `snapshots` are taken last.
+	 *
+	 * \note The systems of a stage must not share any state besides the world, and the memory resource of the
+	 * world must be thread-safe.
+	 * \note The intervals set by `set_interval` are ignored, every system is updated.
+	 * \sa `set_scheduler`
 	 */
 	void update();
 
+	/**
+	 * \brief Run a frame of the world, advancing its clock
+	 *
+	 * Like `update()`, but only updates the systems which are due : those without an interval, and those whose
+	 * interval has elapsed since their last update. A system is updated at most once per frame, and its next
+	 * update is then one interval after the time it was due.
+	 *
+	 * ~~~~{.cpp}
+	 * world.set_interval<AiSys>(0.1); // 10 Hz
+	 * world.update(1.0 / 60);
+	 * ~~~~
+	 *
+	 * \param dt Time elapsed since the previous frame, in the unit of the intervals
+	 * \pre `dt` is not negative
+	 * \sa `set_interval`
+	 */
+	void update(double dt);
+
 	/**
 	 * \brief Send a message to a system
 	 * 
@@ -195,15 +400,265 @@ class World<ComponentList<C...>, SystemList<S...>> final
 	template <typename T>
 	void reserve_components(std::size_t n);
 
+	/**
+	 * \brief Keep the states of the last frames
+	 *
+	 * Before each `update`, the world saves its entities, components, resources and delayed changes (see
+	 * `EntityHandle::destroy_after`), keeping the last `frames` states for `rewind`. Saving a state forks the
+	 * components (see `fork`), so the cost of a frame depends on the storage of each component : the pages of
+	 * components with `PagedStorage` are shared with the saved state and only the pages written during the frame
+	 * get copied, components with `TagStorage` or `SingletonStorage` copy next to nothing, and components with
+	 * any other storage policy are copied whole every frame. Using `PagedStorage` for the large components keeps
+	 * their cost proportional to the memory each frame changes. Whatever the storages, every frame also copies
+	 * the entity records, the occupancy of each component (a few bytes per entity) and the delayed changes, so
+	 * saving a frame is at least linear in the number of entities.
+	 *
+	 * \param frames Number of states to keep. 0 disables the history and drops the saved states
+	 * \pre The components and resources are copy constructible
+	 * \note The systems aren't saved. State that must be rewound belongs in components or resources.
+	 */
+	void keep_history(std::size_t frames);
+
+	/**
+	 * \brief Number of frames which can be rewound
+	 */
+	std::size_t saved_frames() const noexcept;
+
+	/**
+	 * \brief Rewind the world
+	 *
+	 * Restores the entities, components, resources and delayed changes as they were before the last `frames`
+	 * updates, and resumes the slices (see `WorldView::for_each_slice`) and the intervals (see `set_interval`)
+	 * of the systems where they were then. The states saved after the restored one are dropped, and the next
+	 * `update` saves the restored state again.
+	 * Restoring only releases the pages written since the restored state was saved.
+	 *
+	 * \param frames Number of frames to rewind
+	 * \pre `frames <= saved_frames()`
+	 * \pre The world isn't recording
+	 * \note Entity handles obtained during the rewound frames are invalidated.
+	 */
+	void rewind(std::size_t frames);
+
+	/**
+	 * \brief Access a resource
+	 *
+	 * \tparam T Type of the resource
+	 * \return A reference to the resource
+	 */
+	template <typename T>
+	T& resource() noexcept;
+
+	/**
+	 * \brief Access a resource
+	 *
+	 * \tparam T Type of the resource
+	 * \return A constant reference to the resource
+	 */
+	template <typename T>
+	T const& resource() const noexcept;
+
+	/**
+	 * \brief Set the scheduler of the world
+	 *
+	 * The systems of a stage of the `Schedule` run concurrently on the scheduler of the world, and so do their
+	 * parallel loops, such as `WorldView::parallel_for_each`. Several worlds can share a scheduler.
+	 *
+	 * \param scheduler The scheduler, or `nullptr` to run everything in the thread updating the world. It must
+	 * outlive its use by the world
+	 */
+	void set_scheduler(Scheduler* scheduler) noexcept;
+
+	/**
+	 * \brief Scheduler of the world
+	 *
+	 * \return The scheduler set by `set_scheduler`, `nullptr` by default
+	 */
+	Scheduler* scheduler() const noexcept;
+
+	/**
+	 * \brief Make the updates deterministic
+	 *
+	 * A deterministic world gives the same results whether it has a scheduler or not, and whatever the number
+	 * of workers of the scheduler : the same entity indices, the same component slots and the same messages,
+	 * in the same order. It is updated stage by stage even without a scheduler, deferring the structural
+	 * changes and the messages of the stages holding several systems (see `update`), and the systems of a
+	 * stage still run concurrently when there is a scheduler.
+	 *
+	 * \param deterministic Whether the updates are deterministic. They aren't by default
+	 * \note `WorldView::parallel_for_each` is deterministic in any case. The systems must not depend on the
+	 * timing of other threads themselves.
+	 */
+	void set_deterministic(bool deterministic) noexcept;
+
+	/**
+	 * \brief Whether the updates are deterministic
+	 *
+	 * \sa `set_deterministic`
+	 */
+	bool deterministic() const noexcept;
+
+	/**
+	 * \brief Set the update interval of a system
+	 *
+	 * `update(double)` then updates `T` once every `interval`. Staggered systems sharing the same interval are
+	 * spread evenly over the interval, so that they don't all run on the same frame. Setting an interval
+	 * restarts the count of the systems it staggers with.
+	 *
+	 * \tparam T Type of the system
+	 * \param interval Time between two updates of `T`. 0, the default, updates `T` on every frame
+	 * \param staggered Whether to stagger `T` with the other staggered systems of the same interval
+	 * \pre `interval` is not negative
+	 */
+	template <typename T>
+	void set_interval(double interval, bool staggered = false) noexcept;
+
+	/**
+	 * \brief Update interval of a system
+	 *
+	 * \tparam T Type of the system
+	 * \sa `set_interval`
+	 */
+	template <typename T>
+	double interval() const noexcept;
+
+	/**
+	 * \brief Memory resource of the world
+	 *
+	 * \return The resource every internal container allocates from
+	 */
+	MemoryResource* memory_resource() const noexcept;
+
+	/**
+	 * \brief Start recording a trace
+	 *
+	 * Every `create_entity`, `add_component(s)`, `remove_components`, `destroy` and `message` call and every
+	 * frame is logged to `out` in a compact binary format, until `stop_recording` is called. Calls made by
+	 * the systems during `update` are logged too.
+	 *
+	 * \param out The stream receiving the trace. It must outlive the recording
+	 * \pre The world isn't already recording
+	 * \note Component and message values are only stored for trivially copyable types.
+	 * \sa `replay`
+	 */
+	void record(std::ostream& out);
+
+	/**
+	 * \brief Stop recording a trace
+	 *
+	 * \pre The world is recording
+	 */
+	void stop_recording();
+
+	/**
+	 * \brief Replay a trace
+	 *
+	 * Reads a trace produced by `record` on a world of the same type and applies it to this world.
+	 * Entities are recreated at the same indices as in the recorded world, so the world should be in the
+	 * same state as the recorded world was when the recording started (usually, freshly constructed).
+	 *
+	 * \tparam M Message types to replay. Messages of other types are skipped
+	 * \param in The stream holding the trace
+	 * \param mode What to do with the operations issued by systems
+	 * \return The number of frames replayed
+	 * \pre The trace was recorded from a world with the same components and systems
+	 * \note Components and messages that aren't trivially copyable are default-constructed.
+	 * \note If the trace is invalid or truncated, for instance because the recording process stopped before
+	 * `stop_recording`, the replay stops at the first invalid operation and sets the failbit of `in`. The
+	 * operations before it stay applied. An operation that doesn't fit the state of the world, such as adding
+	 * a component the entity already has, is invalid too.
+	 */
+	template <typename... M>
+	std::size_t replay(std::istream& in, ReplayMode mode = ReplayMode::operations);
+
 	private:
+	template <typename>
+	friend class ShardedWorld;
+
+	using Data = impl::Registry<I, C...>;
+	using Recorder = impl::TraceRecorder<CL<C...>, SL<S...>>;
+	using Timers = impl::TimingWheel<Data, Recorder>;
+	using Spawns = impl::SpawnQueue<Data, Recorder>;
+	// Replay the operations of a trace, and return false if they are invalid
+	using AddFn = bool (*)(Data&, std::size_t, std::string const&);
+	using RemoveFn = bool (*)(Data&, std::size_t);
+	using MessageFn = bool (*)(Self&, std::string const&);
+
+	// Snapshots of a set of components, type-erased
+	struct Snapshots
+	{
+		std::unique_ptr<void, void (*)(void*)> ring;
+		void (*capture)(void*, Data const&);
+	};
+
+	// elapsed is the time since the system was last due
+	struct Rate
+	{
+		double interval;
+		double elapsed;
+		bool staggered;
+	};
+
+	struct Frame
+	{
+		Data data;
+		impl::Tuple<R...> resources;
+		Timers timers;
+		std::array<std::size_t, sizeof...(S)> cursors;
+		std::array<Rate, sizeof...(S)> rates;
+	};
+
+	World(Data&&, impl::Tuple<S...> const&, impl::Tuple<R...> const&);
+
+	void frame_();
+	template <typename F>
+	void migrate_(std::size_t, Self&, F&);
+	void stagger_(double) noexcept;
+
+	template <typename... St>
+	void update_stages_(impl::TypeList<St...>);
+	template <typename T>
+	void update_stage_(impl::TypeList<T>);
+	template <typename... T>
+	void update_stage_(impl::TypeList<T...>);
 	template <typename T, typename P, typename... O>
-	void update_(impl::TypeList<O...>);
+	void update_(impl::TypeList<O...>, impl::Commands*);
+
+	template <typename T>
+	static bool replay_add_(Data&, std::size_t, std::string const&);
+	template <typename T>
+	static bool replay_add_(Data&, std::size_t, std::string const&, std::true_type);
+	template <typename T>
+	static bool replay_add_(Data&, std::size_t, std::string const&, std::false_type);
+	template <typename T>
+	static bool replay_remove_(Data&, std::size_t);
+	template <typename T, typename... M>
+	static std::array<MessageFn, sizeof...(M)> message_fns_();
+	template <typename T, typename A>
+	static MessageFn message_fn_(std::true_type);
+	template <typename T, typename A>
+	static MessageFn message_fn_(std::false_type);
+	template <typename T, typename A>
+	static bool replay_message_(Self&, std::string const&);
+	template <typename T, typename A>
+	static bool replay_message_(Self&, std::string const&, std::true_type);
+	template <typename T, typename A>
+	static bool replay_message_(Self&, std::string const&, std::false_type);
 
-	std::vector<impl::Entity<C...>> entities_;
-	impl::Tuple<std::vector<boost::optional<C>>...> components_;
+	Data data_;
 	impl::Tuple<S...> systems_;
+	impl::Tuple<R...> resources_;
 
-	std::array<std::vector<std::size_t>, sizeof...(C) + 1> free_caches_;
+	Recorder recorder_;
+	Timers timers_;
+	std::unique_ptr<Spawns> spawns_;
+	impl::Vector<Snapshots> snapshots_;
+	impl::History<Frame> history_;
+	Scheduler* scheduler_;
+	bool deterministic_;
+	std::array<std::size_t, sizeof...(S)> cursors_;
+	std::array<Rate, sizeof...(S)> rates_;
+	std::array<bool, sizeof...(S)> due_;
 };
 
 /**
@@ -219,6 +674,20 @@ auto create_world(ComponentList<C...>, SystemList<S...>, Args&&... args)
 	return World<CL<C...>, SL<S...>>{std::forward<Args>(args)...};
 }
 
+/**
+ * \brief Helper function to create a `World` allocating from a `MemoryResource`
+ *
+ * \tparam C The set of components types.
+ * \tparam S The set of systems types.
+ * \param resource A `MemoryResource`. It must outlive the world
+ * \param args A pack of tuples holding the parameters to construct each system
+ */
+template <typename R, typename... C, typename... S, typename... Args>
+auto create_world(std::allocator_arg_t, R& resource, ComponentList<C...>, SystemList<S...>, Args&&... args)
+{
+	return World<CL<C...>, SL<S...>>{std::allocator_arg, resource, std::forward<Args>(args)...};
+}
+
 } // namespace mantra
 
 #include "impl/WorldImpl.hpp"
@@ -35,12 +35,17 @@
 
 #include <algorithm>
 #include <array>
+#include <bitset>
 #include <cassert>
+#include <chrono>
+#include <cstdint>
 #include <functional>
 #include <tuple>
+#include <utility>
 #include <vector>
 
 #include "EntityHandle.hpp"
+#include "Scheduler.hpp"
 #include "impl/utility.hpp"
 
 namespace mantra
@@ -51,14 +56,19 @@ namespace mantra
  * 
  * \tparam W Associated `World` type
  * \tparam P Primary component type
- * \tparam C Secondary component types
+ * \tparam D Other declaration terms of the system : excluded components, optional components and resources
+ * \tparam C Accessible component types, including the optional ones
  * 
  * \note Instances are created and returned by the library and should not be created directly by the user.
  */
-template <typename W, typename P, typename... C>
+template <typename W, typename P, typename D, typename... C>
 class WorldView final
 {
-	using WC = impl::WorldCont<typename W::Components, typename W::Systems>;
+	static_assert(!sizeof...(C) || !impl::conjunction<impl::is_optional<C, D>...>{},
+	              "Queries need a required component");
+
+	using WC = impl::WorldCont<typename W::Components, typename W::Systems, typename W::Resources,
+	                           typename W::Index>;
 
 	class EntityIterator : public std::iterator<
 	                                std::forward_iterator_tag,
@@ -69,7 +79,7 @@ class WorldView final
 	{
 		public:
 		EntityIterator();
-		explicit EntityIterator(WorldView<W, P, C...>&);
+		explicit EntityIterator(WorldView<W, P, D, C...>&);
 		
 		EntityIterator(EntityIterator const&);
 
@@ -79,14 +89,14 @@ class WorldView final
 		EntityIterator& operator++();
 		EntityIterator operator++(int);
 
-		friend bool operator==(typename mantra::WorldView<W, P, C...>::EntityIterator const& l,
-		                       typename mantra::WorldView<W, P, C...>::EntityIterator const& r) noexcept
+		friend bool operator==(typename mantra::WorldView<W, P, D, C...>::EntityIterator const& l,
+		                       typename mantra::WorldView<W, P, D, C...>::EntityIterator const& r) noexcept
 		{
 			return l.view_ == r.view_ && l.index_ == r.index_;
 		}
 		
-		friend bool operator!=(typename mantra::WorldView<W, P, C...>::EntityIterator const& l,
-		                       typename mantra::WorldView<W, P, C...>::EntityIterator const& r) noexcept
+		friend bool operator!=(typename mantra::WorldView<W, P, D, C...>::EntityIterator const& l,
+		                       typename mantra::WorldView<W, P, D, C...>::EntityIterator const& r) noexcept
 		{
 			return !(l == r);
 		}
@@ -94,7 +104,7 @@ class WorldView final
 		private:
 		void find_next_();
 
-		WorldView<W, P, C...>* view_;
+		WorldView<W, P, D, C...>* view_;
 		boost::optional<EntityHandle<W, P, C...>> handle_;
 		std::size_t index_;
 	};
@@ -102,19 +112,175 @@ class WorldView final
 	class Entities
 	{
 		public:
-		explicit Entities(WorldView<W, P, C...>&);
+		explicit Entities(WorldView<W, P, D, C...>&);
 
 		EntityIterator begin();
 		EntityIterator end();
 
 		private:
-		WorldView<W, P, C...>& view_;
+		WorldView<W, P, D, C...>& view_;
+	};
+
+	template <typename T, std::size_t I>
+	using FieldPointer = std::conditional_t<impl::is_any<P, T, void>{},
+	                                        typename impl::PoolOf<T>::template Field<I>*,
+	                                        typename impl::PoolOf<T>::template Field<I> const*>;
+
+	template <typename T>
+	using DataPointer = std::conditional_t<impl::is_any<P, T, void>{}, T*, T const*>;
+
+	class ChunkIterator;
+
+	public:
+	/**
+	 * \brief Batch of consecutive entities
+	 *
+	 * Covers the entities with indices in `[begin(), begin() + size())`, of which the `count()` entities listed
+	 * by `ids()` are visible by the `WorldView`. Components are accessed as arrays holding the components of
+	 * the visible entities, in the order of `ids()`.
+	 *
+	 * Every array is aligned to 64 bytes and holds `chunk_size` elements. The elements past `count()` are
+	 * padding, with unspecified values, which may be read and written freely. Kernels can thus process whole
+	 * vectors, or whole chunks, without handling the remainder.
+	 *
+	 * \note Instances are created and returned by the library and should not be created directly by the user.
+	 */
+	class Chunk
+	{
+		public:
+		//! \cond
+		Chunk(WorldView<W, P, D, C...>*, std::size_t, std::size_t) noexcept;
+		//! \endcond
+
+		/**
+		 * \brief Index of the first entity of the chunk
+		 *
+		 * \return A multiple of `chunk_size`
+		 */
+		std::size_t begin() const noexcept;
+
+		/**
+		 * \brief Number of entities in the chunk
+		 *
+		 * \return `chunk_size`, except for the last chunk of the world
+		 */
+		std::size_t size() const noexcept;
+
+		/**
+		 * \brief Visible entities
+		 *
+		 * \return A bitset where the bit `i` is set if the entity `begin() + i` is visible
+		 */
+		std::uint64_t mask() const noexcept;
+
+		/**
+		 * \brief Number of visible entities
+		 *
+		 * \return A number between 1 and `size()`
+		 */
+		std::size_t count() const noexcept;
+
+		/**
+		 * \brief Indices of the visible entities
+		 *
+		 * \return A pointer to `count()` increasing entity indices
+		 */
+		std::size_t const* ids() const noexcept;
+
+		/**
+		 * \brief Access a component for the whole chunk
+		 *
+		 * \tparam T Type of the component. It must be trivially copyable, not a pointer, not optional, and not
+		 * use `SoAStorage`
+		 * \return A pointer to the components of the visible entities. The pointee is const unless `T` is the
+		 * primary component type.
+		 * \note The components are copied to an internal buffer on first access in the chunk, and the primary
+		 * components are copied back to the entities when iteration moves to another chunk or stops.
+		 */
+		template <typename T>
+		DataPointer<T> data() const;
+
+		/**
+		 * \brief Access a field of a component for the whole chunk
+		 *
+		 * \tparam T Type of the component. It must use `SoAStorage` and not be optional
+		 * \tparam I Index of the field in the member list of the storage
+		 * \return A pointer to the fields of the visible entities. The pointee is const unless `T` is the
+		 * primary component type.
+		 * \note When every entity of the chunk is visible, the pointer refers directly to the storage of the
+		 * field. Otherwise, the fields are copied like with `data()`.
+		 */
+		template <typename T, std::size_t I>
+		FieldPointer<T, I> field() const;
+
+		private:
+		friend class ChunkIterator;
+
+		WorldView<W, P, D, C...>* view_;
+		std::size_t begin_;
+		std::size_t size_;
+		std::uint64_t mask_;
+		std::size_t count_;
+		std::array<std::size_t, chunk_size> ids_;
+	};
+
+	private:
+	class ChunkIterator : public std::iterator<
+	                               std::forward_iterator_tag,
+	                               Chunk,
+	                               std::ptrdiff_t,
+	                               Chunk*,
+	                               Chunk&>
+	{
+		public:
+		ChunkIterator();
+		explicit ChunkIterator(WorldView<W, P, D, C...>&);
+
+		ChunkIterator(ChunkIterator const&) = default;
+
+		~ChunkIterator();
+
+		Chunk& operator*();
+		Chunk* operator->();
+
+		ChunkIterator& operator++();
+		ChunkIterator operator++(int);
+
+		friend bool operator==(typename mantra::WorldView<W, P, D, C...>::ChunkIterator const& l,
+		                       typename mantra::WorldView<W, P, D, C...>::ChunkIterator const& r) noexcept
+		{
+			return l.view_ == r.view_ && (!l.view_ || l.chunk_.begin() == r.chunk_.begin());
+		}
+
+		friend bool operator!=(typename mantra::WorldView<W, P, D, C...>::ChunkIterator const& l,
+		                       typename mantra::WorldView<W, P, D, C...>::ChunkIterator const& r) noexcept
+		{
+			return !(l == r);
+		}
+
+		private:
+		void find_next_(std::size_t);
+
+		WorldView<W, P, D, C...>* view_;
+		Chunk chunk_;
+	};
+
+	class Chunks
+	{
+		public:
+		explicit Chunks(WorldView<W, P, D, C...>&);
+
+		ChunkIterator begin();
+		ChunkIterator end();
+
+		private:
+		WorldView<W, P, D, C...>& view_;
 	};
 
 	public:
 	//! \cond
-	WorldView(typename WC::EntCont&, typename WC::CompCont&, typename WC::SysCont&,
-	          typename WC::Caches&) noexcept;
+	WorldView(typename WC::Data&, typename WC::SysCont&, typename WC::ResCont&, typename WC::Recorder&,
+	          typename WC::Timers&, Scheduler*, impl::Commands*, std::size_t*) noexcept;
 	//! \endcond
 
 	/**
@@ -136,9 +302,9 @@ class WorldView final
 	WorldView& operator=(WorldView&&) = delete;
 
 	/**
-	 * \brief `WorldView` is default destructible
+	 * \brief `WorldView` is destructible
 	 */
-	~WorldView() = default;
+	~WorldView();
 
 	/**
 	 * \brief Create a new entity
@@ -148,6 +314,8 @@ class WorldView final
 	 * \tparam Ts Components the new entity will have
 	 * \return An `EntityHandle` for the new entity
 	 * \note The return type of this function is complex. It is advised to use automatic type deduction.
+	 * \note If this system runs concurrently with other systems, the entity is created at the end of the stage,
+	 * see `World::update`.
 	 */
 	template <typename... Ts>
 	EntityHandle<W, P, C...> create_entity();
@@ -161,6 +329,8 @@ class WorldView final
 	 * \param args A pack of tuples holding the parameters to construct each component
 	 * \return An `EntityHandle` for the new entity
 	 * \note The return type of this function is complex. It is advised to use automatic type deduction.
+	 * \note If this system runs concurrently with other systems, the entity is created at the end of the stage,
+	 * see `World::update`.
 	 */
 	template <typename... Ts, typename... Args>
 	EntityHandle<W, P, C...> create_entity(Args&&... args);
@@ -175,6 +345,121 @@ class WorldView final
 	 */
 	Entities entities();
 
+	/**
+	 * \brief Chunked iteration interface
+	 *
+	 * Splits the entities in chunks of `chunk_size` consecutive indices, and gives access to the components of
+	 * the visible entities of each chunk as aligned arrays, to process them with vector instructions.
+	 *
+	 * ~~~~{.cpp}
+	 * for (auto& chunk : wv.chunks())
+	 * {
+	 *     auto p = chunk.template data<Position>();
+	 *     auto v = chunk.template data<Velocity>();
+	 *     #pragma omp simd
+	 *     for (std::size_t i = 0; i < chunk_size; ++i)
+	 *         p[i].x += v[i].x;
+	 * }
+	 * ~~~~
+	 *
+	 * \return An object with `begin()` and `end()` functions, which can be used to obtain iterators over the
+	 * chunks holding at least one entity visible by this `WorldView`.
+	 * \note The iterators meet the requirements of `ForwardIterator`.
+	 * \note Only the arrays of the last chunk reached are valid. Creating or destroying entities, or adding or
+	 * removing components, while iterating over chunks doesn't update the chunks already reached.
+	 */
+	Chunks chunks();
+
+	/**
+	 * \brief Parallel iteration over entities
+	 *
+	 * Calls `f` with an `EntityHandle` for every entity visible by this `WorldView`. The entities are split in
+	 * ranges of consecutive indices, which the `Scheduler` of the world processes concurrently. Without a
+	 * scheduler, the entities are processed in order by the calling thread.
+	 *
+	 * The structural changes (creating and destroying entities, adding and removing components) and the
+	 * messages issued by `f`, through the handles or through this `WorldView`, are buffered per range and
+	 * applied once every entity is processed, in the order of the entities. They thus have the same effect
+	 * whatever the number of threads. If this system runs concurrently with other systems, they are deferred
+	 * further, to the end of the stage (see `World::update`).
+	 *
+	 * ~~~~{.cpp}
+	 * wv.parallel_for_each([](auto& entity)
+	 * {
+	 *     entity.template get_component<Position>().x += entity.template get_component<Velocity>().x;
+	 * });
+	 * ~~~~
+	 *
+	 * \param f Callable object taking an `EntityHandle&`. It is called concurrently from several threads
+	 * \note Pages of the primary component shared with a forked world are copied up front.
+	 * \sa `World::set_scheduler`
+	 */
+	template <typename F>
+	void parallel_for_each(F f);
+
+	/**
+	 * \brief Time-sliced iteration over entities
+	 *
+	 * Calls `f` with an `EntityHandle` for at most `budget` entities visible by this `WorldView`, in order,
+	 * starting after the last entity processed by the previous slice of this system. The position is kept from
+	 * one frame to the next, so a system processing one slice per frame goes through all its entities in turn,
+	 * at a bounded cost per frame. Once the last entity is reached, the slice goes on with the first one, but
+	 * no entity is processed twice by the same slice.
+	 *
+	 * ~~~~{.cpp}
+	 * wv.for_each_slice(100, [](auto& entity)
+	 * {
+	 *     entity.template get_component<Path>() = find_path(entity.template get_component<Position>());
+	 * });
+	 * ~~~~
+	 *
+	 * \param budget Maximum number of entities to process
+	 * \param f Callable object taking an `EntityHandle&`
+	 * \return The number of entities processed
+	 */
+	template <typename F>
+	std::size_t for_each_slice(std::size_t budget, F f);
+
+	/**
+	 * \brief Time-sliced iteration over entities
+	 *
+	 * Like the other overload, but processes entities until `budget` has elapsed since the call. At least one
+	 * entity is processed, if there is any.
+	 *
+	 * \param budget Maximum duration of the slice, measured with `std::chrono::steady_clock`
+	 * \param f Callable object taking an `EntityHandle&`
+	 * \return The number of entities processed
+	 */
+	template <typename Rep, typename Period, typename F>
+	std::size_t for_each_slice(std::chrono::duration<Rep, Period> budget, F f);
+
+#ifndef DOXYGEN_ONLY
+	template <typename T>
+	std::enable_if_t<impl::is_any<P, T>{}, T&> resource() noexcept;
+
+	template <typename T>
+	T const& resource() const noexcept;
+#else
+	/**
+	 * \brief Access a resource
+	 *
+	 * \tparam T Type of the resource. The system must declare it with `Uses`
+	 * \return A reference to the resource
+	 * \note Only available if `T` is the primary type of the system.
+	 */
+	template <typename T>
+	T& resource() noexcept;
+
+	/**
+	 * \brief Access a resource
+	 *
+	 * \tparam T Type of the resource. The system must declare it with `Uses`
+	 * \return A constant reference to the resource
+	 */
+	template <typename T>
+	T const& resource() const noexcept;
+#endif // DOXYGEN_ONLY
+
 	/**
 	 * \brief Send a message to a system
 	 * 
@@ -182,7 +467,8 @@ class WorldView final
 	 * 
 	 * \tparam S The type of the system
 	 * \param arg The object to send
-	 * \note The message is handled immediately in the same thread.
+	 * \note The message is handled immediately in the same thread, unless this system runs concurrently with
+	 * other systems. It is then handled at the end of the stage, see `World::update`.
 	 */
 	template <typename S, typename A>
 	void message(A&& arg);
@@ -206,10 +492,42 @@ class WorldView final
 	void reserve_components(std::size_t n);
 
 	private:
-	typename WC::EntCont& entities_;
-	typename WC::CompCont& components_;
+	typename WC::Data& data_;
 	typename WC::SysCont& systems_;
-	typename WC::Caches& free_caches_;
+	typename WC::ResCont& resources_;
+	typename WC::Recorder& recorder_;
+	typename WC::Timers& timers_;
+	Scheduler* scheduler_;
+	impl::Commands* commands_;
+	std::size_t* cursor_;
+	std::size_t driver_;
+
+	impl::Commands* buffer_() const noexcept;
+	template <typename F>
+	void for_each_(std::size_t, std::size_t, F&, impl::Commands*);
+	template <typename F, typename Stop>
+	std::size_t for_each_slice_(F&, Stop);
+	void unshare_primary_(std::false_type) noexcept;
+	void unshare_primary_(std::true_type) noexcept;
+
+	static constexpr std::size_t chunk_slots_{impl::chunk_slots<C...>(sizeof...(C))};
+	static constexpr std::size_t chunk_bytes_{impl::chunk_bytes<C...>(sizeof...(C))};
+
+	std::pair<unsigned char*, bool> chunk_array_(Chunk const&, std::size_t, std::size_t);
+	void flush_chunk_();
+	void flush_chunk_(std::false_type) noexcept;
+	void flush_chunk_(std::true_type);
+	void flush_primary_(std::false_type);
+	void flush_primary_(std::true_type);
+	template <std::size_t... Is>
+	void flush_fields_(std::index_sequence<Is...>);
+	template <std::size_t I>
+	void flush_field_();
+
+	unsigned char* scratch_;
+	std::bitset<chunk_slots_ ? chunk_slots_ : 1> gathered_;
+	std::size_t chunk_begin_;
+	std::uint64_t chunk_mask_;
 };
 
 } // namespace mantra
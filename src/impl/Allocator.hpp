@@ -0,0 +1,110 @@
+/*****
+ * Copyright Benoit Vey (2016)
+ *
+ * benoit.vey@etu.upmc.fr
+ *
+ * This software is governed by the CeCILL-B license under French law and
+ * abiding by the rules of distribution of free software.  You can  use, 
+ * modify and/ or redistribute the software under the terms of the CeCILL-B
+ * license as circulated by CEA, CNRS and INRIA at the following URL
+ * "http://www.cecill.info". 
+ *
+ * As a counterpart to the access to the source code and  rights to copy,
+ * modify and redistribute granted by the license, users are provided only
+ * with a limited warranty  and the software's author,  the holder of the
+ * economic rights,  and the successive licensors  have only  limited
+ * liability. 
+ *
+ * In this respect, the user's attention is drawn to the risks associated
+ * with loading,  using,  modifying and/or developing or reproducing the
+ * software by the user in light of its specific status of free software,
+ * that may mean  that it is complicated to manipulate,  and  that  also
+ * therefore means  that it is reserved for developers  and  experienced
+ * professionals having in-depth computer knowledge. Users are therefore
+ * encouraged to load and test the software's suitability as regards their
+ * requirements in conditions enabling the security of their systems and/or 
+ * data to be ensured and,  more generally, to use and operate it in the 
+ * same conditions as regards security. 
+ *
+ * The fact that you are presently reading this means that you have had
+ * knowledge of the CeCILL-B license and that you accept its terms.
+ *****/
+
+#ifndef MANTRA_IMPL_ALLOCATOR_HPP
+#define MANTRA_IMPL_ALLOCATOR_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "../MemoryResource.hpp"
+
+namespace mantra
+{
+
+namespace impl
+{
+
+template <typename T>
+class Allocator
+{
+	public:
+	using value_type = T;
+	using propagate_on_container_move_assignment = std::true_type;
+	using propagate_on_container_swap = std::true_type;
+
+	Allocator() noexcept : resource_{default_resource()} {}
+	Allocator(MemoryResource* resource) noexcept : resource_{resource} {}
+	template <typename U>
+	Allocator(Allocator<U> const& other) noexcept : resource_{other.resource()} {}
+
+	T* allocate(std::size_t n)
+	{
+		return static_cast<T*>(resource_->allocate(n * sizeof(T), alignof(T)));
+	}
+
+	void deallocate(T* p, std::size_t n)
+	{
+		resource_->deallocate(p, n * sizeof(T), alignof(T));
+	}
+
+	MemoryResource* resource() const noexcept
+	{
+		return resource_;
+	}
+
+	private:
+	MemoryResource* resource_;
+};
+
+template <typename T, typename U>
+bool operator==(Allocator<T> const& l, Allocator<U> const& r) noexcept
+{
+	return l.resource() == r.resource() || l.resource()->is_equal(*r.resource());
+}
+
+template <typename T, typename U>
+bool operator!=(Allocator<T> const& l, Allocator<U> const& r) noexcept
+{
+	return !(l == r);
+}
+
+template <typename T>
+using Vector = std::vector<T, Allocator<T>>;
+
+// Makes room for one more element, so that the next emplace_back doesn't reallocate
+// The capacity doubles as with emplace_back itself, since reserving the exact size reallocates every time.
+template <typename T>
+void reserve_one(Vector<T>& vector)
+{
+	if (vector.size() == vector.capacity())
+		vector.reserve(std::max<std::size_t>(2 * vector.capacity(), 1));
+}
+
+} // namespace impl
+
+} // namespace mantra
+
+#endif // Header guard
@@ -0,0 +1,217 @@
+/*****
+ * Copyright Benoit Vey (2016)
+ *
+ * benoit.vey@etu.upmc.fr
+ *
+ * This software is governed by the CeCILL-B license under French law and
+ * abiding by the rules of distribution of free software.  You can  use, 
+ * modify and/ or redistribute the software under the terms of the CeCILL-B
+ * license as circulated by CEA, CNRS and INRIA at the following URL
+ * "http://www.cecill.info". 
+ *
+ * As a counterpart to the access to the source code and  rights to copy,
+ * modify and redistribute granted by the license, users are provided only
+ * with a limited warranty  and the software's author,  the holder of the
+ * economic rights,  and the successive licensors  have only  limited
+ * liability. 
+ *
+ * In this respect, the user's attention is drawn to the risks associated
+ * with loading,  using,  modifying and/or developing or reproducing the
+ * software by the user in light of its specific status of free software,
+ * that may mean  that it is complicated to manipulate,  and  that  also
+ * therefore means  that it is reserved for developers  and  experienced
+ * professionals having in-depth computer knowledge. Users are therefore
+ * encouraged to load and test the software's suitability as regards their
+ * requirements in conditions enabling the security of their systems and/or 
+ * data to be ensured and,  more generally, to use and operate it in the 
+ * same conditions as regards security. 
+ *
+ * The fact that you are presently reading this means that you have had
+ * knowledge of the CeCILL-B license and that you accept its terms.
+ *****/
+
+#ifndef MANTRA_IMPL_COMMANDS_HPP
+#define MANTRA_IMPL_COMMANDS_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "Allocator.hpp"
+#include "utility.hpp"
+
+namespace mantra
+{
+
+namespace impl
+{
+
+// Deferred commands own copies of their arguments, since the arguments of the original call are often
+// temporaries
+template <template <typename...> class T, typename... Us>
+Tuple<std::decay_t<Us>...> own(T<Us...>&& args)
+{
+	return Tuple<std::decay_t<Us>...>{get<Us>(std::move(args))...};
+}
+
+template <template <typename...> class T, typename... Us>
+Tuple<std::decay_t<Us>...> own(T<Us...> const& args)
+{
+	return Tuple<std::decay_t<Us>...>{get<Us>(args)...};
+}
+
+template <typename F, typename... Ts, std::size_t... Is>
+decltype(auto) unpack(F&& f, std::tuple<Ts...>& args, std::index_sequence<Is...>)
+{
+	return f(std::move(std::get<Is>(args))...);
+}
+
+template <typename F, typename... Ts>
+decltype(auto) unpack(F&& f, std::tuple<Ts...>& args)
+{
+	return unpack(std::forward<F>(f), args, std::index_sequence_for<Ts...>{});
+}
+
+// Structural changes and messages issued by a system while other systems run
+// The commands are applied in the order in which they were issued, once every system of the stage is done.
+// Entities created through the buffer get placeholder indices, with the high bit set, which the commands
+// resolve to the actual indices when they are applied.
+class Commands
+{
+	struct Command
+	{
+		// Applies the command if the buffer isn't null, then destroys it
+		void (*run)(Command*, Commands*);
+		Command* next;
+		std::size_t bytes;
+		std::size_t alignment;
+	};
+
+	template <typename F>
+	struct CommandOf : Command
+	{
+		template <typename G>
+		explicit CommandOf(G&& g) : Command{}, f{std::forward<G>(g)} {}
+
+		F f;
+	};
+
+	public:
+	static std::size_t constexpr pending_bit{~(~std::size_t{0} >> 1)};
+
+	explicit Commands(MemoryResource* resource) noexcept
+		: resource_{resource}, first_{nullptr}, last_{nullptr}, pending_{0}, created_{resource}
+	{}
+
+	Commands(Commands const&) = delete;
+	Commands& operator=(Commands const&) = delete;
+
+	Commands(Commands&& mv) noexcept
+		: resource_{mv.resource_}, first_{mv.first_}, last_{mv.last_}, pending_{mv.pending_},
+		  created_{std::move(mv.created_)}
+	{
+		mv.first_ = mv.last_ = nullptr;
+		mv.pending_ = 0;
+	}
+
+	Commands& operator=(Commands&&) = delete;
+
+	~Commands()
+	{
+		run_(nullptr);
+	}
+
+	bool empty() const noexcept
+	{
+		return !first_;
+	}
+
+	// f is called with the buffer, to resolve placeholder indices
+	template <typename F>
+	void push(F&& f)
+	{
+		using Node = CommandOf<std::decay_t<F>>;
+
+		auto node = new (resource_->allocate(sizeof(Node), alignof(Node))) Node{std::forward<F>(f)};
+		node->run = [](Command* cmd, Commands* commands)
+		{
+			auto self = static_cast<Node*>(cmd);
+			if (commands)
+				self->f(*commands);
+			self->~Node();
+		};
+		node->bytes = sizeof(Node);
+		node->alignment = alignof(Node);
+		(last_ ? last_->next : first_) = node;
+		last_ = node;
+	}
+
+	// Placeholder index of the next entity created through the buffer
+	std::size_t pending() noexcept
+	{
+		return pending_bit | pending_++;
+	}
+
+	// Called by the creation commands, in order, with the actual index of the created entity
+	void bind(std::size_t index)
+	{
+		created_.emplace_back(index);
+	}
+
+	std::size_t resolve(std::size_t index) const noexcept
+	{
+		if (!(index & pending_bit))
+			return index;
+		assert((index & ~pending_bit) < created_.size() && "(Dev) Entity not created yet");
+		return created_[index & ~pending_bit];
+	}
+
+	void apply()
+	{
+		run_(this);
+		pending_ = 0;
+		created_.clear();
+	}
+
+	private:
+	void run_(Commands* commands)
+	{
+		for (auto cmd = first_; cmd;)
+		{
+			auto next = cmd->next;
+			cmd->run(cmd, commands);
+			resource_->deallocate(cmd, cmd->bytes, cmd->alignment);
+			cmd = next;
+		}
+		first_ = last_ = nullptr;
+	}
+
+	MemoryResource* resource_;
+	Command* first_;
+	Command* last_;
+	std::size_t pending_;
+	Vector<std::size_t> created_;
+};
+
+// Buffer of the range of a parallel loop processed by the calling thread, which receives the commands issued
+// through the WorldView running the loop
+struct RangeCommands
+{
+	void const* data;
+	Commands* commands;
+};
+
+inline RangeCommands& range_commands() noexcept
+{
+	static thread_local RangeCommands range{nullptr, nullptr};
+	return range;
+}
+
+} // namespace impl
+
+} // namespace mantra
+
+#endif // Header guard
@@ -34,10 +34,10 @@
 #define MANTRA_IMPL_ENTITY_HPP
 
 #include <array>
-#include <vector>
-
-#include <boost/optional.hpp>
+#include <cstdint>
+#include <type_traits>
 
+#include "Pool.hpp"
 #include "utility.hpp"
 
 namespace mantra
@@ -46,106 +46,76 @@ namespace mantra
 namespace impl
 {
 
-class EntityKey;
-
 #ifndef NDEBUG
-template <typename... C>
-class Entity;
-
-template <typename C>
-class DebugHandle;
-
-template <typename... C>
-class DebugHandle<TypeList<C...>>
+// Handles remember the generation of their entity, which changes when the entity is destroyed
+// Handles to entities which aren't created yet, by deferred commands, are never valid.
+template <typename R>
+class DebugHandle
 {
 	public:
-	DebugHandle(std::vector<Entity<C...>>&, std::size_t);
-	
-	DebugHandle(DebugHandle const&);
+	DebugHandle(R const&, std::size_t) noexcept;
 
-	DebugHandle(DebugHandle&&);
+	DebugHandle(DebugHandle const&) = default;
 
-	~DebugHandle();
-	
-	void invalidate_() noexcept;
+	DebugHandle(DebugHandle&&) noexcept;
 
-	private:
-	std::vector<Entity<C...>>& entities_;
-	std::size_t index_;
+	~DebugHandle() = default;
 
 	protected:
-	bool valid_;
-};
+	bool valid_() const noexcept;
 
+	private:
+	R const* registry_;
+	std::size_t index_;
+	std::uint32_t generation_;
+	bool moved_;
+};
 #endif // NDEBUG
 
-template <typename... C>
+// Entity record
+// Only holds the keys of the components stored in slot keyed pools, narrowed to I, and a presence bit per
+// component type. The last bit tells whether the entity exists. Everything else is owned by the Registry.
+template <typename I, typename... C>
 class Entity
 {
-	using Comps = impl::Tuple<std::vector<boost::optional<C>>...>;
-	template <typename T>
-	using CompVec = std::vector<boost::optional<T>>;
-	using Caches = std::array<std::vector<std::size_t>, sizeof...(C) + 1>;
-
-	public:
-	Entity(Comps&, Caches&, std::size_t);
-
-	Entity(Entity const&) = delete;
-	Entity& operator=(Entity const&) = delete;
+	static_assert(std::is_integral<I>{} && std::is_unsigned<I>{}, "Invalid index type");
 
-	Entity(Entity&&) noexcept;
+	using Word = std::conditional_t<(sizeof...(C) < 8), std::uint8_t,
+	             std::conditional_t<(sizeof...(C) < 16), std::uint16_t,
+	             std::conditional_t<(sizeof...(C) < 32), std::uint32_t, std::uint64_t>>>;
 
-	~Entity();
+	static std::size_t constexpr word_bits{8 * sizeof(Word)};
+	static std::size_t constexpr exists_bit{sizeof...(C)};
 
-	template <typename... Ts>
-	void create(TypeList<Ts...>);
-	template <typename... Ts, typename... Args>
-	void create(TypeList<Ts...>, Args&&...);
+	public:
+	Entity() noexcept;
 
-	void destroy();
+	void create() noexcept;
+	void destroy() noexcept;
 
 	operator bool() const noexcept;
 	bool operator!() const noexcept;
 
-	template <typename T>
-	T& get_component() noexcept;
-	template <typename T>
-	std::enable_if_t<!std::is_pointer<T>{}, T> const& get_component() const noexcept;
-	template <typename P>
-	std::enable_if_t<std::is_pointer<P>{}, std::remove_pointer_t<P>> const* const&
-		get_pointer() const noexcept;
-
 	template <typename... Ts>
 	bool has_components() const noexcept;
 
-	template <typename T, typename... Args>
-	void add_component(Args&&...);
-	template <typename... Ts>
-	void add_components();
-	template <typename... Ts, typename... Args>
-	void add_components(Args&&...);
-	
-	template <typename... Ts>
-	void remove_components();
-	
-#ifndef NDEBUG
-	void add_handle(DebugHandle<TypeList<C...>>*);
-	void remove_handle(DebugHandle<TypeList<C...>>*);
-	void invalidate_handles() noexcept;
-#endif // NDEBUG
+	template <typename T>
+	std::size_t key() const noexcept;
+
+	template <typename T>
+	void add(std::size_t) noexcept;
+	template <typename T>
+	void remove() noexcept;
 
 	private:
-	template <typename T, typename Tuple, typename... Ts>
-	void assign_comp_(CompVec<T>&, Tuple&&, TypeList<Ts...>);
+	template <typename T>
+	void store_key_(std::size_t, std::true_type) noexcept;
+	template <typename T>
+	void store_key_(std::size_t, std::false_type) noexcept;
+	bool test_(std::size_t) const noexcept;
 
-	Comps& comps_;
-	std::array<long, sizeof...(C)> comps_idx_;
-	Caches& free_caches_;
-#ifndef NDEBUG
-	std::vector<DebugHandle<TypeList<C...>>*> handles_;
-#endif // NDEBUG
-	std::size_t index_;
-	bool exists_;
+	std::array<I, slot_keys<PoolOf<C>...>(sizeof...(C))> keys_;
+	std::array<Word, (sizeof...(C) + word_bits) / word_bits> bits_;
 };
 
 } // namespace impl
@@ -39,42 +39,59 @@ namespace mantra
 {
 
 template <typename W, typename P, typename... C>
-EntityHandle<W, P, C...>::EntityHandle(typename WC::EntCont& entities, std::size_t index)
+EntityHandle<W, P, C...>::EntityHandle(typename WC::Data& data, typename WC::Recorder& recorder,
+                                       typename WC::Timers& timers, std::size_t index, impl::Commands* commands)
 	: 
 #ifndef NDEBUG
-	  impl::DebugHandle<typename W::Components>{entities, index},
+	  impl::DebugHandle<typename WC::Data>{data, index},
 #endif
-	  entities_{entities}, index_{index}
+	  data_{data}, recorder_{recorder}, timers_{timers}, index_{index}, commands_{commands}
 {
-	impl::validate_components(typename W::Components{}, impl::TypeList<C...>{});
+	// C is empty for the entities created by a system declaring only resources
+	static_assert(typename W::Components{}.template contains<impl::Stored<C>...>(), "Invalid component type");
 }
 
 template <typename W, typename P, typename... C>
 void EntityHandle<W, P, C...>::destroy()
 {
-	assert(this->valid_ && "Entity isn't valid");
+	assert((pending_() || this->valid_()) && "Entity isn't valid");
 
-	entities_[index_].destroy();
+	if (commands_)
+	{
+		defer_([](auto& data, auto& recorder, std::size_t index)
+		{
+			if (recorder.active())
+				recorder.destroy(index);
+			data.destroy(index);
+		});
+		return;
+	}
+
+	if (recorder_.active())
+		recorder_.destroy(index_);
+	data_.destroy(index_);
 }
 
 template <typename W, typename P, typename... C>
 template <typename T>
-std::enable_if_t<impl::is_any<P, T, void>{}, T>& EntityHandle<W, P, C...>::get_component() noexcept
+std::enable_if_t<impl::is_any<P, T, void>{}, impl::Reference<T>>
+	EntityHandle<W, P, C...>::get_component() noexcept
 {
 	impl::validate_component<T>(impl::TypeList<C...>{});
-	assert(this->valid_ && "Entity isn't valid");
+	assert(this->valid_() && "Entity isn't valid");
 
-	return entities_[index_].template get_component<T>();
+	return data_.template get_component<T>(index_);
 }
 
 template <typename W, typename P, typename... C>
 template <typename T>
-std::enable_if_t<!std::is_pointer<T>{}, T> const& EntityHandle<W, P, C...>::get_component() const noexcept
+std::enable_if_t<!std::is_pointer<T>{}, impl::ConstReference<T>>
+	EntityHandle<W, P, C...>::get_component() const noexcept
 {
 	impl::validate_component<T>(impl::TypeList<C...>{});
-	assert(this->valid_ && "Entity isn't valid");
+	assert(this->valid_() && "Entity isn't valid");
 
-	return entities_[index_].template get_component<T>();
+	return impl::as_const(data_).template get_component<T>(index_);
 }
 
 template <typename W, typename P, typename... C>
@@ -83,9 +100,45 @@ std::enable_if_t<std::is_pointer<T>{}, std::remove_pointer_t<T>> const* const&
 	EntityHandle<W, P, C...>::get_component() const noexcept
 {
 	impl::validate_component<T>(impl::TypeList<C...>{});
-	assert(this->valid_ && "Entity isn't valid");
+	assert(this->valid_() && "Entity isn't valid");
+
+	return data_.template get_pointer<T>(index_);
+}
+
+template <typename W, typename P, typename... C>
+template <typename T>
+std::enable_if_t<impl::is_any<P, T, void>{}, T*> EntityHandle<W, P, C...>::find_component() noexcept
+{
+	impl::validate_component<T>(impl::TypeList<C...>{});
+	static_assert(!std::is_pointer<T>{} && !impl::is_soa<impl::PoolOf<T>>{},
+	              "Pointer and struct-of-arrays components can't be retrieved as pointers");
+	assert(this->valid_() && "Entity isn't valid");
 
-	return entities_[index_].template get_pointer<T>();
+	return data_.template has_components<T>(index_) ? &data_.template get_component<T>(index_) : nullptr;
+}
+
+template <typename W, typename P, typename... C>
+template <typename T>
+T const* EntityHandle<W, P, C...>::find_component() const noexcept
+{
+	impl::validate_component<T>(impl::TypeList<C...>{});
+	static_assert(!std::is_pointer<T>{} && !impl::is_soa<impl::PoolOf<T>>{},
+	              "Pointer and struct-of-arrays components can't be retrieved as pointers");
+	assert(this->valid_() && "Entity isn't valid");
+
+	auto const& data = impl::as_const(data_);
+	return data.template has_components<T>(index_) ? &data.template get_component<T>(index_) : nullptr;
+}
+
+template <typename W, typename P, typename... C>
+template <typename T>
+T const& EntityHandle<W, P, C...>::get_previous() const noexcept
+{
+	impl::validate_component<Previous<T>>(impl::TypeList<C...>{});
+	static_assert(impl::is_double_buffered<impl::PoolOf<T>>{}, "Previous components need double-buffered storage");
+	assert(this->valid_() && "Entity isn't valid");
+
+	return data_.template get_previous<T>(index_);
 }
 
 template <typename W, typename P, typename... C>
@@ -93,9 +146,9 @@ template <typename... Ts>
 bool EntityHandle<W, P, C...>::has_components() const noexcept
 {
 	impl::validate_components(typename W::Components{}, impl::TypeList<Ts...>{});
-	assert(this->valid_ && "Entity isn't valid");
+	assert(this->valid_() && "Entity isn't valid");
 
-	return entities_[index_].template has_components<Ts...>();
+	return data_.template has_components<Ts...>(index_);
 }
 
 template <typename W, typename P, typename... C>
@@ -103,9 +156,23 @@ template <typename T, typename... Args>
 void EntityHandle<W, P, C...>::add_component(Args&&... args)
 {
 	impl::validate_component<T>(typename W::Components{});
-	assert(this->valid_ && "Entity isn't valid");
+	assert((pending_() || this->valid_()) && "Entity isn't valid");
+
+	if (commands_)
+	{
+		defer_([values = impl::Tuple<std::decay_t<Args>...>{std::forward<Args>(args)...}]
+		       (auto& data, auto& recorder, std::size_t index) mutable
+		{
+			data.template add_components<T>(index, std::move(values));
+			if (recorder.active())
+				recorder.template add<T>(data, index);
+		});
+		return;
+	}
 
-	return entities_[index_].template add_component<T>(std::forward<Args>(args)...);
+	data_.template add_component<T>(index_, std::forward<Args>(args)...);
+	if (recorder_.active())
+		recorder_.template add<T>(data_, index_);
 }
 
 template <typename W, typename P, typename... C>
@@ -113,9 +180,22 @@ template <typename... Ts>
 void EntityHandle<W, P, C...>::add_components()
 {
 	impl::validate_components(typename W::Components{}, impl::TypeList<Ts...>{});
-	assert(this->valid_ && "Entity isn't valid");
+	assert((pending_() || this->valid_()) && "Entity isn't valid");
 
-	entities_[index_].template add_components<Ts...>();
+	if (commands_)
+	{
+		defer_([](auto& data, auto& recorder, std::size_t index)
+		{
+			data.template add_components<Ts...>(index);
+			if (recorder.active())
+				recorder.template add<Ts...>(data, index);
+		});
+		return;
+	}
+
+	data_.template add_components<Ts...>(index_);
+	if (recorder_.active())
+		recorder_.template add<Ts...>(data_, index_);
 }
 
 template <typename W, typename P, typename... C>
@@ -123,9 +203,26 @@ template <typename... Ts, typename... Args>
 void EntityHandle<W, P, C...>::add_components(Args&&... args)
 {
 	impl::validate_components(typename W::Components{}, impl::TypeList<Ts...>{});
-	assert(this->valid_ && "Entity isn't valid");
+	assert((pending_() || this->valid_()) && "Entity isn't valid");
+
+	if (commands_)
+	{
+		defer_([values = std::make_tuple(impl::own(std::forward<Args>(args))...)]
+		       (auto& data, auto& recorder, std::size_t index) mutable
+		{
+			impl::unpack([&data, index](auto&&... a)
+			{
+				data.template add_components<Ts...>(index, std::forward<decltype(a)>(a)...);
+			}, values);
+			if (recorder.active())
+				recorder.template add<Ts...>(data, index);
+		});
+		return;
+	}
 
-	entities_[index_].template add_components<Ts...>(std::forward<Args>(args)...);
+	data_.template add_components<Ts...>(index_, std::forward<Args>(args)...);
+	if (recorder_.active())
+		recorder_.template add<Ts...>(data_, index_);
 }
 
 template <typename W, typename P, typename... C>
@@ -133,9 +230,139 @@ template <typename... Ts>
 void EntityHandle<W, P, C...>::remove_components()
 {
 	impl::validate_components(impl::TypeList<C...>{}, impl::TypeList<Ts...>{});
-	assert(this->valid_ && "Entity isn't valid");
+	assert((pending_() || this->valid_()) && "Entity isn't valid");
+
+	if (commands_)
+	{
+		defer_([](auto& data, auto& recorder, std::size_t index)
+		{
+			if (recorder.active())
+				recorder.template remove<Ts...>(index);
+			data.template remove_components<Ts...>(index);
+		});
+		return;
+	}
+
+	if (recorder_.active())
+		recorder_.template remove<Ts...>(index_);
+	data_.template remove_components<Ts...>(index_);
+}
+
+template <typename W, typename P, typename... C>
+void EntityHandle<W, P, C...>::destroy_after(std::size_t ticks)
+{
+	assert((pending_() || this->valid_()) && "Entity isn't valid");
+
+	schedule_(ticks, [](auto& data, auto& recorder, std::size_t index)
+	{
+		if (recorder.active())
+			recorder.destroy(index);
+		data.destroy(index);
+	});
+}
+
+// Whether the entity will own the component when the change is due can't be checked when it is scheduled, so the
+// precondition of add_component becomes a condition of the change
+template <typename W, typename P, typename... C>
+template <typename T, typename... Args>
+void EntityHandle<W, P, C...>::add_after(std::size_t ticks, Args&&... args)
+{
+	impl::validate_component<T>(typename W::Components{});
+	static_assert(impl::conjunction<std::is_copy_constructible<std::decay_t<Args>>...>{},
+	              "The arguments of a delayed component must be copy constructible");
+	assert((pending_() || this->valid_()) && "Entity isn't valid");
+
+	schedule_(ticks, [values = impl::Tuple<std::decay_t<Args>...>{std::forward<Args>(args)...}]
+	          (auto& data, auto& recorder, std::size_t index) mutable
+	{
+		if (data.template has_components<T>(index))
+			return;
+		data.template add_components<T>(index, std::move(values));
+		if (recorder.active())
+			recorder.template add<T>(data, index);
+	});
+}
+
+template <typename W, typename P, typename... C>
+template <typename... Ts>
+void EntityHandle<W, P, C...>::remove_after(std::size_t ticks)
+{
+	impl::validate_components(impl::TypeList<C...>{}, impl::TypeList<Ts...>{});
+	assert((pending_() || this->valid_()) && "Entity isn't valid");
+
+	schedule_(ticks, [](auto& data, auto& recorder, std::size_t index)
+	{
+		(void)impl::expand{(remove_present_<Ts>(data, recorder, index), 0)...};
+	});
+}
+
+template <typename W, typename P, typename... C>
+bool EntityHandle<W, P, C...>::pending_() const noexcept
+{
+	return index_ & impl::Commands::pending_bit;
+}
+
+// Changes deferred to the end of the stage target the entity created for a placeholder index, and are dropped
+// if the entity was destroyed in the meantime, by another system for instance
+template <typename W, typename P, typename... C>
+template <typename F>
+void EntityHandle<W, P, C...>::defer_(F&& f)
+{
+	commands_->push([&data = data_, &recorder = recorder_, index = index_, f = std::forward<F>(f)]
+	                (impl::Commands& commands) mutable
+	{
+		auto target = commands.resolve(index);
+		if (data[target])
+			f(data, recorder, target);
+	});
+}
+
+template <typename W, typename P, typename... C>
+template <typename T>
+void EntityHandle<W, P, C...>::remove_present_(typename WC::Data& data, typename WC::Recorder& recorder,
+                                               std::size_t index)
+{
+	if (!data.template has_components<T>(index))
+		return;
+	if (recorder.active())
+		recorder.template remove<T>(index);
+	data.template remove_components<T>(index);
+}
+
+// The change remembers the generation of the entity, and is dropped if the entity was destroyed before it is due.
+// It is recorded as issued by a system if it was scheduled by one, so that a simulation replay leaves it to the
+// systems scheduling it again.
+// From a system running concurrently with others, the change is scheduled when the commands of the stage are
+// applied, once the index of a pending entity is known.
+template <typename W, typename P, typename... C>
+template <typename F>
+void EntityHandle<W, P, C...>::schedule_(std::size_t ticks, F&& f)
+{
+	assert(ticks > 0 && "Changes are delayed by at least one frame");
+
+	auto timer = [from_system = recorder_.in_update(), f = std::forward<F>(f)](std::size_t index, auto generation)
+	{
+		return [index, generation, from_system, f](auto& data, auto& recorder) mutable
+		{
+			if (data.generation(index) != generation)
+				return;
+			auto in_update = recorder.in_update();
+			recorder.set_in_update(from_system);
+			f(data, recorder, index);
+			recorder.set_in_update(in_update);
+		};
+	};
+
+	if (commands_)
+	{
+		defer_([&timers = timers_, ticks, timer](auto& data, auto&, std::size_t index)
+		{
+			timers.schedule(ticks, timer(index, data.generation(index)));
+		});
+		return;
+	}
 
-	entities_[index_].template remove_components<Ts...>();
+	timers_.schedule(ticks, timer(index_, data_.generation(index_)));
 }
 
 } // namespace mantra
@@ -34,9 +34,8 @@
 #define MANTRA_IMPL_ENTITYIMPL_HPP
 
 #include <cassert>
-#include <functional>
-
-#include "../tuple_create.hpp"
+#include <exception>
+#include <limits>
 
 #include "Entity.hpp"
 
@@ -47,304 +46,124 @@ namespace impl
 {
 
 #ifndef NDEBUG
-template <typename... C>
-DebugHandle<TypeList<C...>>::DebugHandle(std::vector<Entity<C...>>& entities, std::size_t index)
-	: entities_{entities}, index_{index}, valid_{true}
-{
-	entities_[index_].add_handle(this);
-}
-	
-template <typename... C>
-DebugHandle<TypeList<C...>>::DebugHandle(DebugHandle const& cp)
-	: entities_{cp.entities_}, index_{cp.index_}, valid_{cp.valid_}
-{
-	if (valid_)
-		entities_[index_].add_handle(this);
-}
+template <typename R>
+DebugHandle<R>::DebugHandle(R const& registry, std::size_t index) noexcept
+	: registry_{&registry}, index_{index},
+	  generation_{index < registry.size() ? registry.generation(index) : 0}, moved_{false}
+{}
 
-template <typename... C>
-DebugHandle<TypeList<C...>>::DebugHandle(DebugHandle&& mv)
-	: entities_{mv.entities_}, index_{mv.index_}, valid_{mv.valid_}
+template <typename R>
+DebugHandle<R>::DebugHandle(DebugHandle&& mv) noexcept
+	: registry_{mv.registry_}, index_{mv.index_}, generation_{mv.generation_}, moved_{mv.moved_}
 {
-	if (valid_)
-	{
-		entities_[index_].remove_handle(&mv);
-		mv.valid_ = false;
-		entities_[index_].add_handle(this);
-	}
+	mv.moved_ = true;
 }
 
-template <typename... C>
-DebugHandle<TypeList<C...>>::~DebugHandle()
+template <typename R>
+bool DebugHandle<R>::valid_() const noexcept
 {
-	if (valid_)
-	{
-		entities_[index_].remove_handle(this);
-		valid_ = false;
-	}
-}
-	
-template <typename... C>
-void DebugHandle<TypeList<C...>>::invalidate_() noexcept
-{
-	valid_ = false;
+	return !moved_ && index_ < registry_->size() && registry_->generation(index_) == generation_;
 }
 #endif // NDEBUG
 
-template <typename... C>
-Entity<C...>::Entity(Comps& comps, Caches& caches, std::size_t idx) : comps_{comps}, comps_idx_{},
-	free_caches_{caches},
-#ifndef NDEBUG
-	handles_{},
-#endif // NDEBUG
-	index_{idx}, exists_{false}
-{
-	comps_idx_.fill(-1);
-}
+template <typename I, typename... C>
+Entity<I, C...>::Entity() noexcept
+	: keys_{}, bits_{}
+{}
 
-template <typename... C>
-Entity<C...>::Entity(Entity&& mv) noexcept : comps_{mv.comps_}, comps_idx_{std::move(mv.comps_idx_)},
-	free_caches_{mv.free_caches_},
-#ifndef NDEBUG
-	handles_{std::move(mv.handles_)},
-#endif // NDEBUG
-	index_{mv.index_}, exists_{mv.exists_}
+template <typename I, typename... C>
+void Entity<I, C...>::create() noexcept
 {
-	mv.exists_ = false;
-}
-
-template <typename... C>
-Entity<C...>::~Entity()
-{
-	if (exists_)
-		destroy();
-}
-
-template <typename... C>
-template <typename... Ts>
-void Entity<C...>::create(TypeList<Ts...> types)
-{
-	assert(!exists_ && "Entity already exists");
-
-	(void)expand
-	{(
-		assign_comp_(impl::get<CompVec<Ts>>(comps_), impl::Tuple<>{}, types)
-		, 0
-	)...};
-	exists_ = true;
-}
-
-template <typename... C>
-template <typename... Ts, typename... Args>
-void Entity<C...>::create(TypeList<Ts...> types, Args&&... args)
-{
-	assert(!exists_ && "Entity already exists");
+	assert(!*this && "Entity already exists");
 
-	(void)expand
-	{(
-		assign_comp_(impl::get<CompVec<Ts>>(comps_), std::forward<Args>(args), types), 0
-	)...};
-	exists_ = true;
+	bits_[exists_bit / word_bits] |= Word{1} << (exists_bit % word_bits);
 }
 
-template <typename... C>
-void Entity<C...>::destroy()
+template <typename I, typename... C>
+void Entity<I, C...>::destroy() noexcept
 {
-	assert(exists_ && "Entity doesn't exists");
-#ifndef NDEBUG	
-	invalidate_handles();
-#endif
-
-	auto it = std::begin(comps_idx_);
-	(void)expand
-	{(
-		*it != -1 ? (void)((impl::get<CompVec<C>>(comps_)[static_cast<std::size_t>(*it)] = boost::none)
-		          , free_caches_[impl::index_of<C, C...>()+1].emplace_back(*it++))
-		          : (void)++it, 0
-	)...};
-	std::fill(std::begin(comps_idx_), std::end(comps_idx_), -1);
-	exists_ = false;
-	free_caches_[0].emplace_back(index_);
-}
+	assert(*this && "Entity doesn't exists");
 
-template <typename... C>
-Entity<C...>::operator bool() const noexcept
-{
-	return exists_;
+	bits_.fill(0);
 }
 
-template <typename... C>
-bool Entity<C...>::operator!() const noexcept
+template <typename I, typename... C>
+Entity<I, C...>::operator bool() const noexcept
 {
-	return !exists_;
+	return test_(exists_bit);
 }
 
-template <typename... C>
-template <typename T>
-T& Entity<C...>::get_component() noexcept
+template <typename I, typename... C>
+bool Entity<I, C...>::operator!() const noexcept
 {
-	auto idx = comps_idx_[impl::index_of<T, C...>()];
-	assert(exists_ && "Entity doesn't exists");
-	assert((idx != -1) && "Entity doesn't have this component");
-
-	return impl::get<CompVec<T>>(comps_)[static_cast<std::size_t>(idx)].get();
+	return !test_(exists_bit);
 }
 
-template <typename... C>
-template <typename T>
-std::enable_if_t<!std::is_pointer<T>{}, T> const& Entity<C...>::get_component() const noexcept
-{
-	auto idx = comps_idx_[impl::index_of<T, C...>()];
-	assert(exists_ && "Entity doesn't exists");
-	assert((idx != -1) && "Entity doesn't have this component");
-
-	return impl::get<CompVec<T>>(comps_)[static_cast<std::size_t>(idx)].get();
-}
-
-template <typename... C>
-template <typename P>
-std::enable_if_t<std::is_pointer<P>{}, std::remove_pointer_t<P>> const* const&
-	Entity<C...>::get_pointer() const noexcept
-{
-	auto idx = comps_idx_[impl::index_of<P, C...>()];
-	assert(exists_ && "Entity doesn't exists");
-	assert((idx != -1) && "Entity doesn't have this component");
-
-	using T = std::remove_pointer_t<P>;
-
-	return *const_cast<T const**>(&impl::get<CompVec<P>>(comps_)[static_cast<std::size_t>(idx)].get());
-}
-
-template <typename... C>
+template <typename I, typename... C>
 template <typename... Ts>
-bool Entity<C...>::has_components() const noexcept
+bool Entity<I, C...>::has_components() const noexcept
 {
-	assert(exists_ && "Entity doesn't exists");
+	assert(*this && "Entity doesn't exists");
 
-	for (auto i : {impl::index_of<Ts, C...>()...})
+	for (auto i : {index_of<Ts, C...>()...})
 	{
-	if (comps_idx_[i] == -1)
-		return false;
+		if (!test_(i))
+			return false;
 	}
 	return true;
 }
 
-template <typename... C>
-template <typename T, typename... Args>
-void Entity<C...>::add_component(Args&&... args)
+template <typename I, typename... C>
+template <typename T>
+std::size_t Entity<I, C...>::key() const noexcept
 {
-	assert(exists_ && "Entity doesn't exists");
-#ifndef NDEBUG
-	assert((comps_idx_[impl::index_of<T, C...>()] == -1) && "Entity already has this component");
-#endif
+	static_assert(pool_key<PoolOf<T>>{} == PoolKey::slot, "(Dev) The key of this component isn't stored");
+	assert(test_(index_of<T, C...>()) && "Entity doesn't have this component");
 
-	assign_comp_(impl::get<CompVec<T>>(comps_), mantra::forward_as_tuple(std::forward<Args>(args)...),
-	             TypeList<T>{});
-}
-
-template <typename... C>
-template <typename... Ts>
-void Entity<C...>::add_components()
-{
-	assert(exists_ && "Entity doesn't exists");
-#ifndef NDEBUG	
-	(void)expand
-	{(
-		assert((comps_idx_[impl::index_of<Ts, C...>()] == -1) && "Entity already has this component"), 0
-	)...};
-#endif
-	(void)expand
-	{(
-		assign_comp_(impl::get<CompVec<Ts>>(comps_), impl::Tuple<>{}, TypeList<Ts...>{})
-		, 0
-	)...};
+	return keys_[slot_keys<PoolOf<C>...>(index_of<T, C...>())];
 }
 
-template <typename... C>
-template <typename... Ts, typename... Args>
-void Entity<C...>::add_components(Args&&... args)
+template <typename I, typename... C>
+template <typename T>
+void Entity<I, C...>::add(std::size_t key) noexcept
 {
-	assert(exists_ && "Entity doesn't exists");
-#ifndef NDEBUG	
-	(void)expand
-	{(
-		assert((comps_idx_[impl::index_of<Ts, C...>()] == -1) && "Entity already has this component"), 0
-	)...};
-#endif
+	assert(!test_(index_of<T, C...>()) && "Entity already has this component");
 
-	(void)expand
-	{(
-		assign_comp_(impl::get<CompVec<Ts>>(comps_), std::forward<Args>(args), TypeList<Ts...>{}), 0
-	)...};
+	auto i = index_of<T, C...>();
+	store_key_<T>(key, std::integral_constant<bool, pool_key<PoolOf<T>>{} == PoolKey::slot>{});
+	bits_[i / word_bits] |= static_cast<Word>(Word{1} << (i % word_bits));
 }
 
-template <typename... C>
-template <typename... Ts>
-void Entity<C...>::remove_components()
+template <typename I, typename... C>
+template <typename T>
+void Entity<I, C...>::remove() noexcept
 {
-	assert(exists_ && "Entity doesn't exists");
-#ifndef NDEBUG
-	(void)expand
-	{(
-		assert((comps_idx_[impl::index_of<Ts, C...>()] != -1) && "Entity doesn't have this component"), 0
-	)...};
-#endif
+	assert(test_(index_of<T, C...>()) && "Entity doesn't have this component");
 
-	(void)expand
-	{(
-		impl::get<CompVec<Ts>>(comps_)
-			[static_cast<std::size_t>(comps_idx_[impl::index_of<Ts, C...>()])] = boost::none,
-		free_caches_[impl::index_of<Ts, C...>()+1].emplace_back(comps_idx_[impl::index_of<Ts, C...>()]),
-		comps_idx_[impl::index_of<Ts, C...>()] = -1, 0
-	)...};
+	auto i = index_of<T, C...>();
+	bits_[i / word_bits] &= static_cast<Word>(~(Word{1} << (i % word_bits)));
 }
 
-#ifndef NDEBUG
-template <typename... C>
-void Entity<C...>::add_handle(DebugHandle<TypeList<C...>>* handle)
+// A truncated key would point to the component of another entity, so the limit is checked in every build type
+template <typename I, typename... C>
+template <typename T>
+void Entity<I, C...>::store_key_(std::size_t key, std::true_type) noexcept
 {
-	handles_.emplace_back(handle);
-}
+	if (key > std::numeric_limits<I>::max())
+		std::terminate();
 
-template <typename... C>
-void Entity<C...>::remove_handle(DebugHandle<TypeList<C...>>* handle)
-{
-	handles_.erase(std::remove(std::begin(handles_), std::end(handles_), handle), std::end(handles_));
+	keys_[slot_keys<PoolOf<C>...>(index_of<T, C...>())] = static_cast<I>(key);
 }
 
-template <typename... C>
-void Entity<C...>::invalidate_handles() noexcept
-{
-	for (auto elem : handles_)
-		elem->invalidate_();
-	handles_.clear();
-}
-#endif // NDEBUG
+template <typename I, typename... C>
+template <typename T>
+void Entity<I, C...>::store_key_(std::size_t, std::false_type) noexcept
+{}
 
-template <typename... C>
-template <typename T, typename Tuple, typename... Ts>
-void Entity<C...>::assign_comp_(CompVec<T>& comps, Tuple&& args, TypeList<Ts...>)
+template <typename I, typename... C>
+bool Entity<I, C...>::test_(std::size_t bit) const noexcept
 {
-	auto it = std::begin(comps);
-	if (!free_caches_[impl::index_of<T, C...>()+1].empty())
-	{
-		auto index = free_caches_[impl::index_of<T, C...>()+1].back();
-		free_caches_[impl::index_of<T, C...>()+1].pop_back();
-		it += static_cast<std::ptrdiff_t>(index);
-	}
-	else
-	{
-		it = std::find_if(std::begin(comps), std::end(comps),
-		                  [](auto const& e){return !e;});
-		if (it == std::end(comps))
-		{
-			comps.emplace_back();
-			it = std::end(comps) - 1;
-		}
-	}
-	invoke([it](auto&&... a){it->emplace(std::forward<decltype(a)>(a)...);},
-	       std::forward<Tuple>(args));
-	comps_idx_[impl::index_of<T, C...>()] = it - std::begin(comps);
+	return bits_[bit / word_bits] >> (bit % word_bits) & 1;
 }
 
 } // namespace impl
@@ -0,0 +1,122 @@
+/*****
+ * Copyright Benoit Vey (2016)
+ *
+ * benoit.vey@etu.upmc.fr
+ *
+ * This software is governed by the CeCILL-B license under French law and
+ * abiding by the rules of distribution of free software.  You can  use, 
+ * modify and/ or redistribute the software under the terms of the CeCILL-B
+ * license as circulated by CEA, CNRS and INRIA at the following URL
+ * "http://www.cecill.info". 
+ *
+ * As a counterpart to the access to the source code and  rights to copy,
+ * modify and redistribute granted by the license, users are provided only
+ * with a limited warranty  and the software's author,  the holder of the
+ * economic rights,  and the successive licensors  have only  limited
+ * liability. 
+ *
+ * In this respect, the user's attention is drawn to the risks associated
+ * with loading,  using,  modifying and/or developing or reproducing the
+ * software by the user in light of its specific status of free software,
+ * that may mean  that it is complicated to manipulate,  and  that  also
+ * therefore means  that it is reserved for developers  and  experienced
+ * professionals having in-depth computer knowledge. Users are therefore
+ * encouraged to load and test the software's suitability as regards their
+ * requirements in conditions enabling the security of their systems and/or 
+ * data to be ensured and,  more generally, to use and operate it in the 
+ * same conditions as regards security. 
+ *
+ * The fact that you are presently reading this means that you have had
+ * knowledge of the CeCILL-B license and that you accept its terms.
+ *****/
+
+#ifndef MANTRA_IMPL_HISTORY_HPP
+#define MANTRA_IMPL_HISTORY_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <utility>
+
+#include <boost/optional.hpp>
+
+#include "Allocator.hpp"
+
+namespace mantra
+{
+
+namespace impl
+{
+
+// Ring of the last states saved by a World, oldest first
+// When the ring is full, saving a state drops the oldest one.
+template <typename State>
+class History
+{
+	public:
+	explicit History(MemoryResource* resource) : states_{resource}, first_{0}, size_{0} {}
+
+	History(History const&) = delete;
+	History& operator=(History const&) = delete;
+
+	History(History&&) = default;
+	History& operator=(History&&) = default;
+
+	~History() = default;
+
+	std::size_t capacity() const noexcept
+	{
+		return states_.size();
+	}
+
+	std::size_t size() const noexcept
+	{
+		return size_;
+	}
+
+	// Keeps the newest states which fit
+	void resize(std::size_t capacity)
+	{
+		Vector<boost::optional<State>> states{states_.get_allocator()};
+		states.resize(capacity);
+		auto kept = std::min(capacity, size_);
+		for (std::size_t i{0}; i < kept; ++i)
+			states[i] = std::move(states_[(first_ + size_ - kept + i) % states_.size()]);
+		states_ = std::move(states);
+		first_ = 0;
+		size_ = kept;
+	}
+
+	void push(State&& state)
+	{
+		assert(capacity() && "(Dev) Saving a state without history");
+
+		states_[(first_ + size_) % states_.size()] = std::move(state);
+		if (size_ == states_.size())
+			first_ = (first_ + 1) % states_.size();
+		else
+			++size_;
+	}
+
+	// Removes the newest state
+	State pop()
+	{
+		assert(size_ && "(Dev) Popping an empty history");
+
+		auto& slot = states_[(first_ + --size_) % states_.size()];
+		State res{std::move(*slot)};
+		slot = boost::none;
+		return res;
+	}
+
+	private:
+	Vector<boost::optional<State>> states_;
+	std::size_t first_;
+	std::size_t size_;
+};
+
+} // namespace impl
+
+} // namespace mantra
+
+#endif // Header guard
@@ -0,0 +1,253 @@
+/*****
+ * Copyright Benoit Vey (2016)
+ *
+ * benoit.vey@etu.upmc.fr
+ *
+ * This software is governed by the CeCILL-B license under French law and
+ * abiding by the rules of distribution of free software.  You can  use, 
+ * modify and/ or redistribute the software under the terms of the CeCILL-B
+ * license as circulated by CEA, CNRS and INRIA at the following URL
+ * "http://www.cecill.info". 
+ *
+ * As a counterpart to the access to the source code and  rights to copy,
+ * modify and redistribute granted by the license, users are provided only
+ * with a limited warranty  and the software's author,  the holder of the
+ * economic rights,  and the successive licensors  have only  limited
+ * liability. 
+ *
+ * In this respect, the user's attention is drawn to the risks associated
+ * with loading,  using,  modifying and/or developing or reproducing the
+ * software by the user in light of its specific status of free software,
+ * that may mean  that it is complicated to manipulate,  and  that  also
+ * therefore means  that it is reserved for developers  and  experienced
+ * professionals having in-depth computer knowledge. Users are therefore
+ * encouraged to load and test the software's suitability as regards their
+ * requirements in conditions enabling the security of their systems and/or 
+ * data to be ensured and,  more generally, to use and operate it in the 
+ * same conditions as regards security. 
+ *
+ * The fact that you are presently reading this means that you have had
+ * knowledge of the CeCILL-B license and that you accept its terms.
+ *****/
+
+#ifndef MANTRA_IMPL_MEMORYRESOURCEIMPL_HPP
+#define MANTRA_IMPL_MEMORYRESOURCEIMPL_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <new>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#endif
+
+#include "../MemoryResource.hpp"
+
+namespace mantra
+{
+
+namespace impl
+{
+
+class NewDeleteResource final : public MemoryResource
+{
+	void* do_allocate(std::size_t bytes, std::size_t alignment) override
+	{
+		if (alignment <= alignof(std::max_align_t))
+			return ::operator new(bytes);
+
+		// Over-allocate and store the original pointer right before the aligned block
+		auto raw = static_cast<char*>(::operator new(bytes + alignment + sizeof(void*)));
+		auto addr = reinterpret_cast<std::uintptr_t>(raw + sizeof(void*));
+		auto aligned = reinterpret_cast<char*>((addr + alignment - 1) & ~(alignment - 1));
+		reinterpret_cast<void**>(aligned)[-1] = raw;
+		return aligned;
+	}
+
+	void do_deallocate(void* p, std::size_t, std::size_t alignment) override
+	{
+		if (alignment <= alignof(std::max_align_t))
+			::operator delete(p);
+		else
+			::operator delete(static_cast<void**>(p)[-1]);
+	}
+
+	bool do_is_equal(MemoryResource const& other) const noexcept override
+	{
+		return this == &other;
+	}
+};
+
+std::size_t constexpr cache_line{64};
+std::size_t constexpr huge_page{2 * 1024 * 1024};
+
+inline std::size_t round_up(std::size_t size, std::size_t alignment) noexcept
+{
+	return (size + alignment - 1) & ~(alignment - 1);
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+inline void* map_pages(std::size_t bytes, bool reserved)
+{
+	auto size = round_up(bytes, huge_page);
+#ifdef MAP_HUGETLB
+	if (reserved)
+	{
+		auto p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if (p != MAP_FAILED)
+			return p;
+	}
+#else
+	(void)reserved;
+#endif
+
+	// Map one more huge page and trim both ends, so the block starts on a huge page boundary
+	auto raw = ::mmap(nullptr, size + huge_page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (raw == MAP_FAILED)
+		throw std::bad_alloc{};
+	auto begin = reinterpret_cast<std::uintptr_t>(raw);
+	auto aligned = round_up(begin, huge_page);
+	if (aligned != begin)
+		::munmap(raw, aligned - begin);
+	::munmap(reinterpret_cast<void*>(aligned + size), begin + huge_page - aligned);
+
+	auto p = reinterpret_cast<void*>(aligned);
+#ifdef MADV_HUGEPAGE
+	::madvise(p, size, MADV_HUGEPAGE);
+#endif
+	return p;
+}
+
+inline void unmap_pages(void* p, std::size_t bytes) noexcept
+{
+	::munmap(p, round_up(bytes, huge_page));
+}
+#endif
+
+} // namespace impl
+
+inline void* MemoryResource::allocate(std::size_t bytes, std::size_t alignment)
+{
+	assert(alignment && !(alignment & (alignment - 1)) && "Alignment isn't a power of 2");
+
+	return do_allocate(bytes, alignment);
+}
+
+inline void MemoryResource::deallocate(void* p, std::size_t bytes, std::size_t alignment)
+{
+	do_deallocate(p, bytes, alignment);
+}
+
+inline bool MemoryResource::is_equal(MemoryResource const& other) const noexcept
+{
+	return do_is_equal(other);
+}
+
+inline MemoryResource* default_resource() noexcept
+{
+	static impl::NewDeleteResource resource{};
+	return &resource;
+}
+
+inline MonotonicResource::MonotonicResource(std::size_t block_size, MemoryResource* upstream)
+	: upstream_{upstream}, blocks_{}, next_size_{std::max<std::size_t>(block_size, 64)}, current_{nullptr},
+	  remaining_{0}
+{
+	assert(upstream_ && "No upstream resource");
+}
+
+inline MonotonicResource::~MonotonicResource()
+{
+	release();
+}
+
+inline void MonotonicResource::release()
+{
+	for (auto const& block : blocks_)
+		upstream_->deallocate(block.data, block.size);
+	blocks_.clear();
+	current_ = nullptr;
+	remaining_ = 0;
+}
+
+inline void* MonotonicResource::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+	auto padding = static_cast<std::size_t>(-reinterpret_cast<std::uintptr_t>(current_) & (alignment - 1));
+	if (!current_ || padding + bytes > remaining_)
+	{
+		auto size = std::max(next_size_, bytes + alignment);
+		auto data = upstream_->allocate(size);
+		blocks_.push_back({data, size});
+		next_size_ = size * 2;
+		current_ = static_cast<char*>(data);
+		remaining_ = size;
+		padding = static_cast<std::size_t>(-reinterpret_cast<std::uintptr_t>(current_) & (alignment - 1));
+	}
+
+	auto res = current_ + padding;
+	current_ = res + bytes;
+	remaining_ -= padding + bytes;
+	return res;
+}
+
+inline void MonotonicResource::do_deallocate(void*, std::size_t, std::size_t)
+{}
+
+inline bool MonotonicResource::do_is_equal(MemoryResource const& other) const noexcept
+{
+	return this == &other;
+}
+
+inline AlignedResource::AlignedResource(HugePages pages, std::size_t threshold, MemoryResource* upstream)
+	: upstream_{upstream}, pages_{pages}, threshold_{threshold}
+{
+	assert(upstream_ && "No upstream resource");
+}
+
+inline HugePages AlignedResource::huge_pages() const noexcept
+{
+	return pages_;
+}
+
+inline bool AlignedResource::mapped_(std::size_t bytes, std::size_t alignment) const noexcept
+{
+#if defined(__unix__) || defined(__APPLE__)
+	return pages_ != HugePages::none && bytes >= threshold_ && alignment <= impl::huge_page;
+#else
+	(void)bytes;
+	(void)alignment;
+	return false;
+#endif
+}
+
+inline void* AlignedResource::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+	bytes = impl::round_up(bytes, impl::cache_line);
+	alignment = std::max(alignment, impl::cache_line);
+#if defined(__unix__) || defined(__APPLE__)
+	if (mapped_(bytes, alignment))
+		return impl::map_pages(bytes, pages_ == HugePages::reserved);
+#endif
+	return upstream_->allocate(bytes, alignment);
+}
+
+inline void AlignedResource::do_deallocate(void* p, std::size_t bytes, std::size_t alignment)
+{
+	bytes = impl::round_up(bytes, impl::cache_line);
+	alignment = std::max(alignment, impl::cache_line);
+#if defined(__unix__) || defined(__APPLE__)
+	if (mapped_(bytes, alignment))
+		return impl::unmap_pages(p, bytes);
+#endif
+	upstream_->deallocate(p, bytes, alignment);
+}
+
+inline bool AlignedResource::do_is_equal(MemoryResource const& other) const noexcept
+{
+	return this == &other;
+}
+
+} // namespace mantra
+
+#endif // Header guard
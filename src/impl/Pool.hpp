@@ -0,0 +1,714 @@
+/*****
+ * Copyright Benoit Vey (2016)
+ *
+ * benoit.vey@etu.upmc.fr
+ *
+ * This software is governed by the CeCILL-B license under French law and
+ * abiding by the rules of distribution of free software.  You can  use, 
+ * modify and/ or redistribute the software under the terms of the CeCILL-B
+ * license as circulated by CEA, CNRS and INRIA at the following URL
+ * "http://www.cecill.info". 
+ *
+ * As a counterpart to the access to the source code and  rights to copy,
+ * modify and redistribute granted by the license, users are provided only
+ * with a limited warranty  and the software's author,  the holder of the
+ * economic rights,  and the successive licensors  have only  limited
+ * liability. 
+ *
+ * In this respect, the user's attention is drawn to the risks associated
+ * with loading,  using,  modifying and/or developing or reproducing the
+ * software by the user in light of its specific status of free software,
+ * that may mean  that it is complicated to manipulate,  and  that  also
+ * therefore means  that it is reserved for developers  and  experienced
+ * professionals having in-depth computer knowledge. Users are therefore
+ * encouraged to load and test the software's suitability as regards their
+ * requirements in conditions enabling the security of their systems and/or 
+ * data to be ensured and,  more generally, to use and operate it in the 
+ * same conditions as regards security. 
+ *
+ * The fact that you are presently reading this means that you have had
+ * knowledge of the CeCILL-B license and that you accept its terms.
+ *****/
+
+#ifndef MANTRA_IMPL_POOL_HPP
+#define MANTRA_IMPL_POOL_HPP
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+
+#include <boost/optional.hpp>
+
+#include "../Storage.hpp"
+#include "Allocator.hpp"
+#include "utility.hpp"
+
+namespace mantra
+{
+
+namespace impl
+{
+
+// Component storage
+// Every pool hands out a key when a component is created, and the component is then accessed through that
+// key until it is erased. Keys of erased components are recycled.
+// fork() copies a pool for a forked world. The copy allocates from the same memory resource and hands out
+// the same keys.
+template <typename T, typename Policy>
+class Pool;
+
+template <typename T>
+using PoolOf = Pool<T, typename storage_traits<T>::storage>;
+
+// What get_component returns : a plain reference, except for struct-of-arrays storage
+template <typename T>
+using Reference = typename PoolOf<T>::reference;
+
+template <typename T>
+using ConstReference = typename PoolOf<T>::const_reference;
+
+template <typename T>
+struct is_soa : std::false_type {};
+
+template <typename T, typename... M>
+struct is_soa<Pool<T, SoAStorage<M...>>> : std::true_type {};
+
+// What entities must remember to find their component in a pool : the slot key handed out by emplace, or
+// nothing when the key is the entity index or a constant
+enum class PoolKey
+{
+	slot,
+	entity,
+	none
+};
+
+template <typename Pool>
+struct pool_key : std::integral_constant<PoolKey, PoolKey::slot> {};
+
+template <typename T>
+struct pool_key<Pool<T, SparseSetStorage>> : std::integral_constant<PoolKey, PoolKey::entity> {};
+
+template <typename T>
+struct pool_key<Pool<T, HashMapStorage>> : std::integral_constant<PoolKey, PoolKey::entity> {};
+
+template <typename T>
+struct pool_key<Pool<T, DoubleBufferedStorage>> : std::integral_constant<PoolKey, PoolKey::entity> {};
+
+template <typename T, typename... M>
+struct pool_key<Pool<T, SoAStorage<M...>>> : std::integral_constant<PoolKey, PoolKey::entity> {};
+
+template <typename T>
+struct pool_key<Pool<T, TagStorage>> : std::integral_constant<PoolKey, PoolKey::none> {};
+
+template <typename T>
+struct pool_key<Pool<T, SingletonStorage>> : std::integral_constant<PoolKey, PoolKey::none> {};
+
+// Number of slot keys among the first n pools
+template <typename... Pools>
+constexpr std::size_t slot_keys(std::size_t n) noexcept
+{
+	bool const slots[]{false, pool_key<Pools>{} == PoolKey::slot...};
+	std::size_t res{0};
+	for (std::size_t i{0}; i < n; ++i)
+		res += slots[i + 1];
+	return res;
+}
+
+template <typename T>
+class Pool<T, DenseStorage>
+{
+	public:
+	using value_type = T;
+	using reference = T&;
+	using const_reference = T const&;
+
+	explicit Pool(Allocator<T> const&);
+
+	Pool(Pool const&) = delete;
+	Pool& operator=(Pool const&) = delete;
+
+	Pool(Pool&&) = default;
+	Pool& operator=(Pool&&) = default;
+
+	~Pool() = default;
+
+	Pool fork() const;
+
+	template <typename... Args>
+	std::size_t emplace(std::size_t, Args&&...);
+	void erase(std::size_t) noexcept;
+
+	T& get(std::size_t key) noexcept
+	{
+		return items_[key].get();
+	}
+
+	T const& get(std::size_t key) const noexcept
+	{
+		return items_[key].get();
+	}
+
+	void reserve(std::size_t);
+	std::size_t size() const noexcept;
+
+	private:
+	Vector<boost::optional<T>> items_;
+	Vector<std::size_t> free_;
+};
+
+// Pages can be shared between the pools of forked worlds. Every page counts its owners, and a shared page is
+// copied before its first modification, so the components of a shared page are the same in every owner, as
+// are the alive bits covering it.
+template <typename T, std::size_t N>
+class Pool<T, PagedStorage<N>>
+{
+	static_assert(N && !(N & (N - 1)), "The page size must be a power of 2");
+
+	using Slot = std::aligned_storage_t<sizeof(T), alignof(T)>;
+
+	struct Page
+	{
+		std::atomic<std::size_t> owners;
+		Slot slots[N];
+	};
+
+	public:
+	using value_type = T;
+	using reference = T&;
+	using const_reference = T const&;
+
+	explicit Pool(Allocator<T> const&);
+
+	Pool(Pool const&) = delete;
+	Pool& operator=(Pool const&) = delete;
+
+	Pool(Pool&&) noexcept;
+	Pool& operator=(Pool&&) noexcept;
+
+	~Pool();
+
+	Pool fork() const;
+
+	template <typename... Args>
+	std::size_t emplace(std::size_t, Args&&...);
+	void erase(std::size_t) noexcept;
+
+	T& get(std::size_t key) noexcept
+	{
+		return *reinterpret_cast<T*>(slot_(key));
+	}
+
+	T const& get(std::size_t key) const noexcept
+	{
+		return *reinterpret_cast<T const*>(&pages_[key / N]->slots[key % N]);
+	}
+
+	void reserve(std::size_t);
+	std::size_t size() const noexcept;
+
+	void unshare() noexcept;
+
+	private:
+	Slot* slot_(std::size_t key) noexcept
+	{
+		auto page = pages_[key / N];
+		if (page->owners.load(std::memory_order_acquire) != 1)
+			page = unshare_(key / N);
+		return &page->slots[key % N];
+	}
+
+	template <typename F>
+	void for_each_alive_(std::size_t, F) const;
+	Page* unshare_(std::size_t) noexcept;
+	void release_(Page*, std::size_t) noexcept;
+	void add_page_();
+	void clear_() noexcept;
+
+	Vector<Page*> pages_;
+	Vector<std::uint64_t> alive_;
+	Vector<std::size_t> free_;
+	std::size_t end_;
+	std::size_t count_;
+};
+
+// Keys are entity indices
+template <typename T>
+class Pool<T, SparseSetStorage>
+{
+	public:
+	using value_type = T;
+	using reference = T&;
+	using const_reference = T const&;
+
+	explicit Pool(Allocator<T> const&);
+
+	Pool(Pool const&) = delete;
+	Pool& operator=(Pool const&) = delete;
+
+	Pool(Pool&&) = default;
+	Pool& operator=(Pool&&) = default;
+
+	~Pool() = default;
+
+	Pool fork() const;
+
+	template <typename... Args>
+	std::size_t emplace(std::size_t, Args&&...);
+	void erase(std::size_t) noexcept;
+
+	T& get(std::size_t key) noexcept
+	{
+		return items_[sparse_[key]];
+	}
+
+	T const& get(std::size_t key) const noexcept
+	{
+		return items_[sparse_[key]];
+	}
+
+	void reserve(std::size_t);
+	std::size_t size() const noexcept;
+
+	private:
+	Vector<T> items_;
+	Vector<std::size_t> owners_;
+	Vector<std::size_t> sparse_;
+};
+
+// Keys are entity indices
+template <typename T>
+class Pool<T, HashMapStorage>
+{
+	using Map = std::unordered_map<std::size_t, T, std::hash<std::size_t>, std::equal_to<std::size_t>,
+	                               Allocator<std::pair<std::size_t const, T>>>;
+
+	public:
+	using value_type = T;
+	using reference = T&;
+	using const_reference = T const&;
+
+	explicit Pool(Allocator<T> const&);
+
+	Pool(Pool const&) = delete;
+	Pool& operator=(Pool const&) = delete;
+
+	Pool(Pool&&) = default;
+	Pool& operator=(Pool&&) = default;
+
+	~Pool() = default;
+
+	Pool fork() const;
+
+	template <typename... Args>
+	std::size_t emplace(std::size_t, Args&&...);
+	void erase(std::size_t) noexcept;
+
+	T& get(std::size_t key) noexcept
+	{
+		return items_.find(key)->second;
+	}
+
+	T const& get(std::size_t key) const noexcept
+	{
+		return items_.find(key)->second;
+	}
+
+	void reserve(std::size_t);
+	std::size_t size() const noexcept;
+
+	private:
+	Map items_;
+};
+
+// Keys are entity indices
+// previous_ holds a copy of every component of items_, taken by emplace and refreshed by publish. Only
+// publish writes to an existing copy, so the copies can be read while the components are written.
+template <typename T>
+class Pool<T, DoubleBufferedStorage>
+{
+	static_assert(std::is_copy_constructible<T>{} && std::is_copy_assignable<T>{},
+	              "Double-buffered components must be copyable");
+
+	public:
+	using value_type = T;
+	using reference = T&;
+	using const_reference = T const&;
+
+	explicit Pool(Allocator<T> const&);
+
+	Pool(Pool const&) = delete;
+	Pool& operator=(Pool const&) = delete;
+
+	Pool(Pool&&) = default;
+	Pool& operator=(Pool&&) = default;
+
+	~Pool() = default;
+
+	Pool fork() const;
+
+	template <typename... Args>
+	std::size_t emplace(std::size_t, Args&&...);
+	void erase(std::size_t) noexcept;
+
+	T& get(std::size_t key) noexcept
+	{
+		return items_[key].get();
+	}
+
+	T const& get(std::size_t key) const noexcept
+	{
+		return items_[key].get();
+	}
+
+	T const& previous(std::size_t key) const noexcept
+	{
+		return previous_[key].get();
+	}
+
+	void publish();
+
+	void reserve(std::size_t);
+	std::size_t size() const noexcept;
+
+	private:
+	Vector<boost::optional<T>> items_;
+	Vector<boost::optional<T>> previous_;
+	std::size_t count_;
+};
+
+template <typename T>
+class Pool<T, TagStorage>
+{
+	static_assert(std::is_empty<T>{}, "Tag storage is only available for empty types");
+
+	public:
+	using value_type = T;
+	using reference = T&;
+	using const_reference = T const&;
+
+	explicit Pool(Allocator<T> const&);
+
+	Pool(Pool const&) = delete;
+	Pool& operator=(Pool const&) = delete;
+
+	Pool(Pool&&) = default;
+	Pool& operator=(Pool&&) = default;
+
+	~Pool() = default;
+
+	Pool fork() const;
+
+	template <typename... Args>
+	std::size_t emplace(std::size_t, Args&&...);
+	void erase(std::size_t) noexcept;
+
+	T& get(std::size_t) noexcept
+	{
+		return tag_;
+	}
+
+	T const& get(std::size_t) const noexcept
+	{
+		return tag_;
+	}
+
+	void reserve(std::size_t) noexcept;
+	std::size_t size() const noexcept;
+
+	private:
+	T tag_;
+	std::size_t count_;
+};
+
+template <typename T>
+class Pool<T, SingletonStorage>
+{
+	public:
+	using value_type = T;
+	using reference = T&;
+	using const_reference = T const&;
+
+	explicit Pool(Allocator<T> const&);
+
+	Pool(Pool const&) = delete;
+	Pool& operator=(Pool const&) = delete;
+
+	Pool(Pool&&) = default;
+	Pool& operator=(Pool&&) = default;
+
+	~Pool() = default;
+
+	Pool fork() const;
+
+	template <typename... Args>
+	std::size_t emplace(std::size_t, Args&&...);
+	void erase(std::size_t) noexcept;
+
+	T& get(std::size_t) noexcept
+	{
+		return item_.get();
+	}
+
+	T const& get(std::size_t) const noexcept
+	{
+		return item_.get();
+	}
+
+	void reserve(std::size_t) noexcept;
+	std::size_t size() const noexcept;
+
+	private:
+	boost::optional<T> item_;
+};
+
+// Copies the pages shared with forked worlds, after which threads can write to different components of the
+// same page concurrently
+template <typename P>
+void unshare(P&) noexcept
+{}
+
+template <typename T, std::size_t N>
+void unshare(Pool<T, PagedStorage<N>>& pool) noexcept
+{
+	pool.unshare();
+}
+
+template <typename T>
+struct is_double_buffered : std::false_type {};
+
+template <typename T>
+struct is_double_buffered<Pool<T, DoubleBufferedStorage>> : std::true_type {};
+
+// Copies the current components to the previous ones, at the end of a frame
+template <typename P>
+void publish(P&) noexcept
+{}
+
+template <typename T>
+void publish(Pool<T, DoubleBufferedStorage>& pool)
+{
+	pool.publish();
+}
+
+// Proxies standing for a component split in field arrays
+template <typename Pool>
+class SoAConstRef
+{
+	using T = typename Pool::value_type;
+
+	public:
+	SoAConstRef(Pool const& pool, std::size_t key) noexcept : pool_{&pool}, key_{key} {}
+
+	operator T() const
+	{
+		return pool_->gather(key_);
+	}
+
+	template <std::size_t I>
+	typename Pool::template Field<I> const& get() const noexcept
+	{
+		return *pool_->template field<I>(key_);
+	}
+
+	private:
+	Pool const* pool_;
+	std::size_t key_;
+};
+
+template <typename Pool>
+class SoARef
+{
+	using T = typename Pool::value_type;
+
+	public:
+	SoARef(Pool& pool, std::size_t key) noexcept : pool_{&pool}, key_{key} {}
+
+	SoARef(SoARef const&) = default;
+
+	// Assignments write through, like references
+	SoARef const& operator=(SoARef const& other) const
+	{
+		return *this = static_cast<T>(other);
+	}
+
+	SoARef const& operator=(T const& value) const
+	{
+		pool_->scatter(key_, value);
+		return *this;
+	}
+
+	operator T() const
+	{
+		return pool_->gather(key_);
+	}
+
+	operator SoAConstRef<Pool>() const noexcept
+	{
+		return {*pool_, key_};
+	}
+
+	template <std::size_t I>
+	typename Pool::template Field<I>& get() const noexcept
+	{
+		return *pool_->template field<I>(key_);
+	}
+
+	private:
+	Pool* pool_;
+	std::size_t key_;
+};
+
+// Keys are entity indices
+// Every field array has the same capacity, a multiple of chunk_size, and is aligned to chunk_size bytes
+template <typename T, typename... M>
+class Pool<T, SoAStorage<M...>>
+{
+	static_assert(std::is_same<std::tuple<typename M::Class...>, std::tuple<std::conditional_t<true, T, M>...>>{},
+	              "The members must belong to the component type");
+	static_assert(std::is_default_constructible<T>{}, "Struct-of-arrays components must be default constructible");
+	static_assert(std::is_same<std::tuple<std::integral_constant<bool, std::is_trivially_copyable<typename M::Type>{}>...>,
+	                           std::tuple<std::conditional_t<true, std::true_type, M>...>>{},
+	              "Struct-of-arrays members must be trivially copyable");
+
+	using Fields = std::tuple<typename M::Type...>;
+
+	public:
+	using value_type = T;
+	using reference = SoARef<Pool>;
+	using const_reference = SoAConstRef<Pool>;
+
+	template <std::size_t I>
+	using Field = std::tuple_element_t<I, Fields>;
+
+	explicit Pool(Allocator<T> const&);
+
+	Pool(Pool const&) = delete;
+	Pool& operator=(Pool const&) = delete;
+
+	Pool(Pool&&) noexcept;
+	Pool& operator=(Pool&&) noexcept;
+
+	~Pool();
+
+	Pool fork() const;
+
+	template <typename... Args>
+	std::size_t emplace(std::size_t, Args&&...);
+	void erase(std::size_t) noexcept;
+
+	reference get(std::size_t key) noexcept
+	{
+		return {*this, key};
+	}
+
+	const_reference get(std::size_t key) const noexcept
+	{
+		return {*this, key};
+	}
+
+	template <std::size_t I>
+	Field<I>* field(std::size_t key) noexcept
+	{
+		return static_cast<Field<I>*>(fields_[I]) + key;
+	}
+
+	template <std::size_t I>
+	Field<I> const* field(std::size_t key) const noexcept
+	{
+		return static_cast<Field<I> const*>(fields_[I]) + key;
+	}
+
+	T gather(std::size_t) const;
+	void scatter(std::size_t, T const&) noexcept;
+
+	void reserve(std::size_t);
+	std::size_t size() const noexcept;
+
+	private:
+	template <std::size_t... Is>
+	T gather_(std::size_t, std::index_sequence<Is...>) const;
+	template <std::size_t... Is>
+	void scatter_(std::size_t, T const&, std::index_sequence<Is...>) noexcept;
+	template <std::size_t... Is>
+	void copy_(Pool&, std::index_sequence<Is...>) const noexcept;
+	template <std::size_t... Is>
+	void grow_(std::size_t, std::index_sequence<Is...>);
+	template <std::size_t... Is>
+	void clear_(std::index_sequence<Is...>) noexcept;
+
+	std::array<void*, sizeof...(M)> fields_;
+	Vector<std::uint64_t> alive_;
+	std::size_t capacity_;
+	std::size_t count_;
+};
+
+// Layout of the scratch space used to gather one chunk of components
+// Struct-of-arrays components are gathered field by field, other components as a whole. Every array holds
+// chunk_size elements, so with chunk_size == 64 every array of the scratch space is 64 bytes aligned.
+template <typename Pool>
+struct ChunkLayout
+{
+	static constexpr std::size_t slots{1};
+	static constexpr std::size_t bytes{chunk_size * sizeof(typename Pool::value_type)};
+
+	static constexpr std::size_t offset(std::size_t) noexcept
+	{
+		return 0;
+	}
+};
+
+template <typename... Fs>
+constexpr std::size_t chunk_fields_bytes(std::size_t n) noexcept
+{
+	std::size_t const sizes[]{0, sizeof(Fs)...};
+	std::size_t res{0};
+	for (std::size_t i{0}; i < n; ++i)
+		res += chunk_size * sizes[i + 1];
+	return res;
+}
+
+template <typename T, typename... M>
+struct ChunkLayout<Pool<T, SoAStorage<M...>>>
+{
+	static constexpr std::size_t slots{sizeof...(M)};
+	static constexpr std::size_t bytes{chunk_fields_bytes<typename M::Type...>(sizeof...(M))};
+
+	static constexpr std::size_t offset(std::size_t field) noexcept
+	{
+		return chunk_fields_bytes<typename M::Type...>(field);
+	}
+};
+
+// Sums of the slots and bytes of the layouts of the first n components. The arrays start with a sentinel, so that
+// they aren't empty for views without components
+template <typename... Ts>
+constexpr std::size_t chunk_slots(std::size_t n) noexcept
+{
+	std::size_t const slots[]{0, ChunkLayout<PoolOf<Stored<Ts>>>::slots...};
+	std::size_t res{0};
+	for (std::size_t i{0}; i < n; ++i)
+		res += slots[i + 1];
+	return res;
+}
+
+template <typename... Ts>
+constexpr std::size_t chunk_bytes(std::size_t n) noexcept
+{
+	std::size_t const bytes[]{0, ChunkLayout<PoolOf<Stored<Ts>>>::bytes...};
+	std::size_t res{0};
+	for (std::size_t i{0}; i < n; ++i)
+		res += bytes[i + 1];
+	return res;
+}
+
+} // namespace impl
+
+} // namespace mantra
+
+#include "PoolImpl.hpp"
+
+#endif // Header guard
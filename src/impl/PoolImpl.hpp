@@ -0,0 +1,728 @@
+/*****
+ * Copyright Benoit Vey (2016)
+ *
+ * benoit.vey@etu.upmc.fr
+ *
+ * This software is governed by the CeCILL-B license under French law and
+ * abiding by the rules of distribution of free software.  You can  use, 
+ * modify and/ or redistribute the software under the terms of the CeCILL-B
+ * license as circulated by CEA, CNRS and INRIA at the following URL
+ * "http://www.cecill.info". 
+ *
+ * As a counterpart to the access to the source code and  rights to copy,
+ * modify and redistribute granted by the license, users are provided only
+ * with a limited warranty  and the software's author,  the holder of the
+ * economic rights,  and the successive licensors  have only  limited
+ * liability. 
+ *
+ * In this respect, the user's attention is drawn to the risks associated
+ * with loading,  using,  modifying and/or developing or reproducing the
+ * software by the user in light of its specific status of free software,
+ * that may mean  that it is complicated to manipulate,  and  that  also
+ * therefore means  that it is reserved for developers  and  experienced
+ * professionals having in-depth computer knowledge. Users are therefore
+ * encouraged to load and test the software's suitability as regards their
+ * requirements in conditions enabling the security of their systems and/or 
+ * data to be ensured and,  more generally, to use and operate it in the 
+ * same conditions as regards security. 
+ *
+ * The fact that you are presently reading this means that you have had
+ * knowledge of the CeCILL-B license and that you accept its terms.
+ *****/
+
+#ifndef MANTRA_IMPL_POOLIMPL_HPP
+#define MANTRA_IMPL_POOLIMPL_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <initializer_list>
+#include <new>
+#include <utility>
+
+#include "Pool.hpp"
+
+namespace mantra
+{
+
+namespace impl
+{
+
+template <typename T>
+Pool<T, DenseStorage>::Pool(Allocator<T> const& alloc)
+	: items_{alloc}, free_{alloc}
+{}
+
+template <typename T>
+auto Pool<T, DenseStorage>::fork() const -> Pool
+{
+	static_assert(std::is_copy_constructible<T>{}, "Forked components must be copy constructible");
+
+	Pool res{items_.get_allocator()};
+	res.items_ = items_;
+	res.free_ = free_;
+	return res;
+}
+
+template <typename T>
+template <typename... Args>
+std::size_t Pool<T, DenseStorage>::emplace(std::size_t, Args&&... args)
+{
+	std::size_t key;
+	if (!free_.empty())
+	{
+		key = free_.back();
+		free_.pop_back();
+	}
+	else
+	{
+		key = items_.size();
+		items_.emplace_back();
+	}
+	items_[key].emplace(std::forward<Args>(args)...);
+	return key;
+}
+
+template <typename T>
+void Pool<T, DenseStorage>::erase(std::size_t key) noexcept
+{
+	assert(items_[key] && "(Dev) Erasing a dead component");
+
+	items_[key] = boost::none;
+	free_.emplace_back(key);
+}
+
+template <typename T>
+void Pool<T, DenseStorage>::reserve(std::size_t n)
+{
+	if (free_.size() < n)
+		items_.reserve(items_.size() + n - free_.size());
+}
+
+template <typename T>
+std::size_t Pool<T, DenseStorage>::size() const noexcept
+{
+	return items_.size() - free_.size();
+}
+
+template <typename T, std::size_t N>
+Pool<T, PagedStorage<N>>::Pool(Allocator<T> const& alloc)
+	: pages_{alloc}, alive_{alloc}, free_{alloc}, end_{0}, count_{0}
+{}
+
+template <typename T, std::size_t N>
+Pool<T, PagedStorage<N>>::Pool(Pool&& mv) noexcept
+	: pages_{std::move(mv.pages_)}, alive_{std::move(mv.alive_)}, free_{std::move(mv.free_)}, end_{mv.end_},
+	  count_{mv.count_}
+{
+	mv.pages_.clear();
+	mv.alive_.clear();
+	mv.end_ = 0;
+	mv.count_ = 0;
+}
+
+template <typename T, std::size_t N>
+auto Pool<T, PagedStorage<N>>::operator=(Pool&& mv) noexcept -> Pool&
+{
+	if (this != &mv)
+	{
+		clear_();
+		pages_ = std::move(mv.pages_);
+		alive_ = std::move(mv.alive_);
+		free_ = std::move(mv.free_);
+		end_ = mv.end_;
+		count_ = mv.count_;
+		mv.pages_.clear();
+		mv.alive_.clear();
+		mv.end_ = 0;
+		mv.count_ = 0;
+	}
+	return *this;
+}
+
+template <typename T, std::size_t N>
+Pool<T, PagedStorage<N>>::~Pool()
+{
+	clear_();
+}
+
+// The pages are shared, not copied
+template <typename T, std::size_t N>
+auto Pool<T, PagedStorage<N>>::fork() const -> Pool
+{
+	static_assert(std::is_copy_constructible<T>{}, "Forked components must be copy constructible");
+
+	Pool res{pages_.get_allocator()};
+	res.pages_ = pages_;
+	res.alive_ = alive_;
+	res.free_ = free_;
+	res.end_ = end_;
+	res.count_ = count_;
+	for (auto page : pages_)
+		page->owners.fetch_add(1, std::memory_order_relaxed);
+	return res;
+}
+
+template <typename T, std::size_t N>
+template <typename... Args>
+std::size_t Pool<T, PagedStorage<N>>::emplace(std::size_t, Args&&... args)
+{
+	std::size_t key;
+	if (!free_.empty())
+		key = free_.back();
+	else
+	{
+		if (end_ == pages_.size() * N)
+			add_page_();
+		key = end_;
+	}
+
+	::new (slot_(key)) T(std::forward<Args>(args)...);
+
+	if (!free_.empty())
+		free_.pop_back();
+	else
+		++end_;
+	alive_[key / 64] |= std::uint64_t{1} << (key % 64);
+	++count_;
+	return key;
+}
+
+template <typename T, std::size_t N>
+void Pool<T, PagedStorage<N>>::erase(std::size_t key) noexcept
+{
+	assert((alive_[key / 64] >> (key % 64) & 1) && "(Dev) Erasing a dead component");
+
+	// Destroying a trivially destructible component doesn't write to its page, which can stay shared
+	if (!std::is_trivially_destructible<T>{})
+		get(key).~T();
+	alive_[key / 64] &= ~(std::uint64_t{1} << (key % 64));
+	free_.emplace_back(key);
+	--count_;
+}
+
+template <typename T, std::size_t N>
+void Pool<T, PagedStorage<N>>::reserve(std::size_t n)
+{
+	while (pages_.size() * N - end_ + free_.size() < n)
+		add_page_();
+	free_.reserve(n);
+}
+
+template <typename T, std::size_t N>
+std::size_t Pool<T, PagedStorage<N>>::size() const noexcept
+{
+	return count_;
+}
+
+template <typename T, std::size_t N>
+void Pool<T, PagedStorage<N>>::unshare() noexcept
+{
+	for (std::size_t page{0}; page < pages_.size(); ++page)
+	{
+		if (pages_[page]->owners.load(std::memory_order_acquire) != 1)
+			unshare_(page);
+	}
+}
+
+// Calls f with the key of every alive component of a page
+template <typename T, std::size_t N>
+template <typename F>
+void Pool<T, PagedStorage<N>>::for_each_alive_(std::size_t page, F f) const
+{
+	auto const mask = ~std::uint64_t{0} >> (64 - std::min<std::size_t>(N, 64));
+	for (auto key = page * N; key < page * N + N; key = (key / 64 + 1) * 64)
+	{
+		for (auto bits = alive_[key / 64] >> (key % 64) & mask; bits; bits &= bits - 1)
+			f(key + count_trailing_zeros(bits));
+	}
+}
+
+// Copies a shared page, which this pool then owns alone
+// Allocation failures and exceptions thrown by the copy constructor of T terminate the program.
+template <typename T, std::size_t N>
+auto Pool<T, PagedStorage<N>>::unshare_(std::size_t page) noexcept -> Page*
+{
+	Allocator<Page> alloc{pages_.get_allocator()};
+	auto shared = pages_[page];
+	auto copy = alloc.allocate(1);
+	::new (&copy->owners) std::atomic<std::size_t>{1};
+	for_each_alive_(page, [shared, copy](std::size_t key)
+	{
+		::new (&copy->slots[key % N]) T(*reinterpret_cast<T const*>(&shared->slots[key % N]));
+	});
+	pages_[page] = copy;
+	release_(shared, page);
+	return copy;
+}
+
+// Gives up the ownership of a page, destroying it if no other pool owns it
+template <typename T, std::size_t N>
+void Pool<T, PagedStorage<N>>::release_(Page* ptr, std::size_t page) noexcept
+{
+	if (ptr->owners.fetch_sub(1, std::memory_order_acq_rel) != 1)
+		return;
+
+	for_each_alive_(page, [ptr](std::size_t key)
+	{
+		reinterpret_cast<T*>(&ptr->slots[key % N])->~T();
+	});
+	Allocator<Page> alloc{pages_.get_allocator()};
+	alloc.deallocate(ptr, 1);
+}
+
+template <typename T, std::size_t N>
+void Pool<T, PagedStorage<N>>::add_page_()
+{
+	Allocator<Page> alloc{pages_.get_allocator()};
+	reserve_one(pages_);
+	alive_.resize((pages_.size() * N + N + 63) / 64);
+	auto page = alloc.allocate(1);
+	::new (&page->owners) std::atomic<std::size_t>{1};
+	pages_.emplace_back(page);
+}
+
+template <typename T, std::size_t N>
+void Pool<T, PagedStorage<N>>::clear_() noexcept
+{
+	for (std::size_t page{0}; page < pages_.size(); ++page)
+		release_(pages_[page], page);
+	pages_.clear();
+	alive_.clear();
+	free_.clear();
+	end_ = 0;
+	count_ = 0;
+}
+
+template <typename T>
+Pool<T, SparseSetStorage>::Pool(Allocator<T> const& alloc)
+	: items_{alloc}, owners_{alloc}, sparse_{alloc}
+{}
+
+template <typename T>
+auto Pool<T, SparseSetStorage>::fork() const -> Pool
+{
+	static_assert(std::is_copy_constructible<T>{}, "Forked components must be copy constructible");
+
+	Pool res{items_.get_allocator()};
+	res.items_ = items_;
+	res.owners_ = owners_;
+	res.sparse_ = sparse_;
+	return res;
+}
+
+template <typename T>
+template <typename... Args>
+std::size_t Pool<T, SparseSetStorage>::emplace(std::size_t entity, Args&&... args)
+{
+	if (sparse_.size() <= entity)
+		sparse_.resize(entity + 1);
+	reserve_one(owners_);
+	items_.emplace_back(std::forward<Args>(args)...);
+	sparse_[entity] = owners_.size();
+	owners_.emplace_back(entity);
+	return entity;
+}
+
+template <typename T>
+void Pool<T, SparseSetStorage>::erase(std::size_t entity) noexcept
+{
+	auto index = sparse_[entity];
+	assert(index < owners_.size() && owners_[index] == entity && "(Dev) Erasing a dead component");
+
+	if (index + 1 != items_.size())
+	{
+		items_[index] = std::move(items_.back());
+		owners_[index] = owners_.back();
+		sparse_[owners_[index]] = index;
+	}
+	items_.pop_back();
+	owners_.pop_back();
+}
+
+template <typename T>
+void Pool<T, SparseSetStorage>::reserve(std::size_t n)
+{
+	items_.reserve(items_.size() + n);
+	owners_.reserve(owners_.size() + n);
+}
+
+template <typename T>
+std::size_t Pool<T, SparseSetStorage>::size() const noexcept
+{
+	return items_.size();
+}
+
+template <typename T>
+Pool<T, HashMapStorage>::Pool(Allocator<T> const& alloc)
+	: items_{typename Map::allocator_type{alloc}}
+{}
+
+template <typename T>
+auto Pool<T, HashMapStorage>::fork() const -> Pool
+{
+	static_assert(std::is_copy_constructible<T>{}, "Forked components must be copy constructible");
+
+	Pool res{items_.get_allocator()};
+	res.items_ = items_;
+	return res;
+}
+
+template <typename T>
+template <typename... Args>
+std::size_t Pool<T, HashMapStorage>::emplace(std::size_t entity, Args&&... args)
+{
+	items_.emplace(std::piecewise_construct, std::forward_as_tuple(entity),
+	               std::forward_as_tuple(std::forward<Args>(args)...));
+	return entity;
+}
+
+template <typename T>
+void Pool<T, HashMapStorage>::erase(std::size_t entity) noexcept
+{
+	auto erased = items_.erase(entity);
+	assert(erased && "(Dev) Erasing a dead component");
+	(void)erased;
+}
+
+template <typename T>
+void Pool<T, HashMapStorage>::reserve(std::size_t n)
+{
+	items_.reserve(items_.size() + n);
+}
+
+template <typename T>
+std::size_t Pool<T, HashMapStorage>::size() const noexcept
+{
+	return items_.size();
+}
+
+template <typename T>
+Pool<T, DoubleBufferedStorage>::Pool(Allocator<T> const& alloc)
+	: items_{alloc}, previous_{alloc}, count_{0}
+{}
+
+template <typename T>
+auto Pool<T, DoubleBufferedStorage>::fork() const -> Pool
+{
+	Pool res{items_.get_allocator()};
+	res.items_ = items_;
+	res.previous_ = previous_;
+	res.count_ = count_;
+	return res;
+}
+
+template <typename T>
+template <typename... Args>
+std::size_t Pool<T, DoubleBufferedStorage>::emplace(std::size_t entity, Args&&... args)
+{
+	if (items_.size() <= entity)
+	{
+		items_.resize(entity + 1);
+		previous_.resize(entity + 1);
+	}
+	items_[entity].emplace(std::forward<Args>(args)...);
+	previous_[entity].emplace(items_[entity].get());
+	++count_;
+	return entity;
+}
+
+template <typename T>
+void Pool<T, DoubleBufferedStorage>::erase(std::size_t entity) noexcept
+{
+	assert(entity < items_.size() && items_[entity] && "(Dev) Erasing a dead component");
+
+	items_[entity] = boost::none;
+	previous_[entity] = boost::none;
+	--count_;
+}
+
+// The copies are assigned rather than swapped with the components, since the writers of T update the
+// components in place and may leave some of them untouched
+template <typename T>
+void Pool<T, DoubleBufferedStorage>::publish()
+{
+	for (std::size_t i{0}; i < items_.size(); ++i)
+	{
+		if (items_[i])
+			previous_[i].get() = items_[i].get();
+	}
+}
+
+template <typename T>
+void Pool<T, DoubleBufferedStorage>::reserve(std::size_t n)
+{
+	if (count_ + n > items_.size())
+	{
+		items_.reserve(count_ + n);
+		previous_.reserve(count_ + n);
+	}
+}
+
+template <typename T>
+std::size_t Pool<T, DoubleBufferedStorage>::size() const noexcept
+{
+	return count_;
+}
+
+template <typename T>
+Pool<T, TagStorage>::Pool(Allocator<T> const&)
+	: tag_{}, count_{0}
+{}
+
+template <typename T>
+auto Pool<T, TagStorage>::fork() const -> Pool
+{
+	Pool res{Allocator<T>{}};
+	res.count_ = count_;
+	return res;
+}
+
+template <typename T>
+template <typename... Args>
+std::size_t Pool<T, TagStorage>::emplace(std::size_t, Args&&...)
+{
+	++count_;
+	return 0;
+}
+
+template <typename T>
+void Pool<T, TagStorage>::erase(std::size_t) noexcept
+{
+	assert(count_ && "(Dev) Erasing a dead component");
+
+	--count_;
+}
+
+template <typename T>
+void Pool<T, TagStorage>::reserve(std::size_t) noexcept
+{}
+
+template <typename T>
+std::size_t Pool<T, TagStorage>::size() const noexcept
+{
+	return count_;
+}
+
+template <typename T>
+Pool<T, SingletonStorage>::Pool(Allocator<T> const&)
+	: item_{}
+{}
+
+template <typename T>
+auto Pool<T, SingletonStorage>::fork() const -> Pool
+{
+	static_assert(std::is_copy_constructible<T>{}, "Forked components must be copy constructible");
+
+	Pool res{Allocator<T>{}};
+	res.item_ = item_;
+	return res;
+}
+
+template <typename T>
+template <typename... Args>
+std::size_t Pool<T, SingletonStorage>::emplace(std::size_t, Args&&... args)
+{
+	assert(!item_ && "The singleton component is already owned by an entity");
+
+	item_.emplace(std::forward<Args>(args)...);
+	return 0;
+}
+
+template <typename T>
+void Pool<T, SingletonStorage>::erase(std::size_t) noexcept
+{
+	assert(item_ && "(Dev) Erasing a dead component");
+
+	item_ = boost::none;
+}
+
+template <typename T>
+void Pool<T, SingletonStorage>::reserve(std::size_t) noexcept
+{}
+
+template <typename T>
+std::size_t Pool<T, SingletonStorage>::size() const noexcept
+{
+	return item_ ? 1 : 0;
+}
+
+template <typename T, typename... M>
+Pool<T, SoAStorage<M...>>::Pool(Allocator<T> const& alloc)
+	: fields_{}, alive_{alloc}, capacity_{0}, count_{0}
+{}
+
+template <typename T, typename... M>
+Pool<T, SoAStorage<M...>>::Pool(Pool&& mv) noexcept
+	: fields_{mv.fields_}, alive_{std::move(mv.alive_)}, capacity_{mv.capacity_}, count_{mv.count_}
+{
+	mv.fields_.fill(nullptr);
+	mv.alive_.clear();
+	mv.capacity_ = 0;
+	mv.count_ = 0;
+}
+
+template <typename T, typename... M>
+auto Pool<T, SoAStorage<M...>>::operator=(Pool&& mv) noexcept -> Pool&
+{
+	if (this != &mv)
+	{
+		clear_(std::index_sequence_for<M...>{});
+		fields_ = mv.fields_;
+		alive_ = std::move(mv.alive_);
+		capacity_ = mv.capacity_;
+		count_ = mv.count_;
+		mv.fields_.fill(nullptr);
+		mv.alive_.clear();
+		mv.capacity_ = 0;
+		mv.count_ = 0;
+	}
+	return *this;
+}
+
+template <typename T, typename... M>
+Pool<T, SoAStorage<M...>>::~Pool()
+{
+	clear_(std::index_sequence_for<M...>{});
+}
+
+template <typename T, typename... M>
+auto Pool<T, SoAStorage<M...>>::fork() const -> Pool
+{
+	Pool res{alive_.get_allocator()};
+	if (capacity_)
+		res.grow_(capacity_, std::index_sequence_for<M...>{});
+	copy_(res, std::index_sequence_for<M...>{});
+	res.alive_ = alive_;
+	res.count_ = count_;
+	return res;
+}
+
+template <typename T, typename... M>
+template <typename... Args>
+std::size_t Pool<T, SoAStorage<M...>>::emplace(std::size_t entity, Args&&... args)
+{
+	if (entity >= capacity_)
+		grow_(entity + 1, std::index_sequence_for<M...>{});
+	scatter(entity, T(std::forward<Args>(args)...));
+	alive_[entity / 64] |= std::uint64_t{1} << (entity % 64);
+	++count_;
+	return entity;
+}
+
+template <typename T, typename... M>
+void Pool<T, SoAStorage<M...>>::erase(std::size_t entity) noexcept
+{
+	assert(entity < capacity_ && (alive_[entity / 64] >> (entity % 64) & 1) && "(Dev) Erasing a dead component");
+
+	alive_[entity / 64] &= ~(std::uint64_t{1} << (entity % 64));
+	--count_;
+}
+
+template <typename T, typename... M>
+T Pool<T, SoAStorage<M...>>::gather(std::size_t key) const
+{
+	return gather_(key, std::index_sequence_for<M...>{});
+}
+
+template <typename T, typename... M>
+void Pool<T, SoAStorage<M...>>::scatter(std::size_t key, T const& value) noexcept
+{
+	scatter_(key, value, std::index_sequence_for<M...>{});
+}
+
+template <typename T, typename... M>
+void Pool<T, SoAStorage<M...>>::reserve(std::size_t n)
+{
+	if (count_ + n > capacity_)
+		grow_(count_ + n, std::index_sequence_for<M...>{});
+}
+
+template <typename T, typename... M>
+std::size_t Pool<T, SoAStorage<M...>>::size() const noexcept
+{
+	return count_;
+}
+
+template <typename T, typename... M>
+template <std::size_t... Is>
+T Pool<T, SoAStorage<M...>>::gather_(std::size_t key, std::index_sequence<Is...>) const
+{
+	T value{};
+	(void)std::initializer_list<int>
+	{(
+		M::get(value) = *field<Is>(key), 0
+	)...};
+	return value;
+}
+
+template <typename T, typename... M>
+template <std::size_t... Is>
+void Pool<T, SoAStorage<M...>>::scatter_(std::size_t key, T const& value, std::index_sequence<Is...>) noexcept
+{
+	(void)std::initializer_list<int>
+	{(
+		*field<Is>(key) = M::get(value), 0
+	)...};
+}
+
+template <typename T, typename... M>
+template <std::size_t... Is>
+void Pool<T, SoAStorage<M...>>::copy_(Pool& other, std::index_sequence<Is...>) const noexcept
+{
+	(void)std::initializer_list<int>
+	{(
+		capacity_ ? (void)std::memcpy(other.fields_[Is], fields_[Is], capacity_ * sizeof(Field<Is>)) : (void)0, 0
+	)...};
+}
+
+// Grows geometrically to at least n elements. New elements are zeroed so that chunked iteration never reads
+// indeterminate values.
+template <typename T, typename... M>
+template <std::size_t... Is>
+void Pool<T, SoAStorage<M...>>::grow_(std::size_t n, std::index_sequence<Is...>)
+{
+	auto capacity = std::max(n, 2 * capacity_);
+	capacity = (capacity + chunk_size - 1) / chunk_size * chunk_size;
+
+	auto resource = alive_.get_allocator().resource();
+	alive_.resize(capacity / 64);
+	std::array<void*, sizeof...(M)> fields{{
+		resource->allocate(capacity * sizeof(Field<Is>), std::max(chunk_size, alignof(Field<Is>)))...
+	}};
+	(void)std::initializer_list<int>
+	{(
+		capacity_ ? (void)std::memcpy(fields[Is], fields_[Is], capacity_ * sizeof(Field<Is>)) : (void)0,
+		(void)std::memset(static_cast<unsigned char*>(fields[Is]) + capacity_ * sizeof(Field<Is>), 0,
+		                  (capacity - capacity_) * sizeof(Field<Is>)),
+		capacity_ ? resource->deallocate(fields_[Is], capacity_ * sizeof(Field<Is>),
+		                                 std::max(chunk_size, alignof(Field<Is>))) : (void)0, 0
+	)...};
+	fields_ = fields;
+	capacity_ = capacity;
+}
+
+template <typename T, typename... M>
+template <std::size_t... Is>
+void Pool<T, SoAStorage<M...>>::clear_(std::index_sequence<Is...>) noexcept
+{
+	if (capacity_)
+	{
+		auto resource = alive_.get_allocator().resource();
+		(void)std::initializer_list<int>
+		{(
+			resource->deallocate(fields_[Is], capacity_ * sizeof(Field<Is>),
+			                     std::max(chunk_size, alignof(Field<Is>))), 0
+		)...};
+	}
+	fields_.fill(nullptr);
+	alive_.clear();
+	capacity_ = 0;
+	count_ = 0;
+}
+
+} // namespace impl
+
+} // namespace mantra
+
+#endif // Header guard
@@ -0,0 +1,213 @@
+/*****
+ * Copyright Benoit Vey (2016)
+ *
+ * benoit.vey@etu.upmc.fr
+ *
+ * This software is governed by the CeCILL-B license under French law and
+ * abiding by the rules of distribution of free software.  You can  use, 
+ * modify and/ or redistribute the software under the terms of the CeCILL-B
+ * license as circulated by CEA, CNRS and INRIA at the following URL
+ * "http://www.cecill.info". 
+ *
+ * As a counterpart to the access to the source code and  rights to copy,
+ * modify and redistribute granted by the license, users are provided only
+ * with a limited warranty  and the software's author,  the holder of the
+ * economic rights,  and the successive licensors  have only  limited
+ * liability. 
+ *
+ * In this respect, the user's attention is drawn to the risks associated
+ * with loading,  using,  modifying and/or developing or reproducing the
+ * software by the user in light of its specific status of free software,
+ * that may mean  that it is complicated to manipulate,  and  that  also
+ * therefore means  that it is reserved for developers  and  experienced
+ * professionals having in-depth computer knowledge. Users are therefore
+ * encouraged to load and test the software's suitability as regards their
+ * requirements in conditions enabling the security of their systems and/or 
+ * data to be ensured and,  more generally, to use and operate it in the 
+ * same conditions as regards security. 
+ *
+ * The fact that you are presently reading this means that you have had
+ * knowledge of the CeCILL-B license and that you accept its terms.
+ *****/
+
+#ifndef MANTRA_IMPL_REGISTRY_HPP
+#define MANTRA_IMPL_REGISTRY_HPP
+
+#include <array>
+#include <cstdint>
+#include <type_traits>
+
+#include "Allocator.hpp"
+#include "Entity.hpp"
+#include "Pool.hpp"
+#include "utility.hpp"
+
+namespace mantra
+{
+
+namespace impl
+{
+
+// Entities and components of a World
+// Owns the entity records, the component pools and the free entity indices. Entities are designated by
+// their index, handles and views only keep a reference to the registry.
+// Each component type also has a column bitset telling which entity indices own it, so queries intersect
+// 64 entities per word operation and jump straight to the matching ones. A summary bitset per column tells
+// which of its words are non zero, and queries follow the summary of their least populated component.
+// Queries take the Terms of their system : excluded columns are masked out, and optional columns aren't
+// intersected.
+// Every index also has a generation, bumped when its entity is destroyed, so that handles and delayed changes
+// can tell the entity they target from the ones created later at the same index.
+// fork() copies the records and bitsets and forks every pool, see Pool.
+template <typename I, typename... C>
+class Registry
+{
+	public:
+	using Record = Entity<I, C...>;
+
+	explicit Registry(MemoryResource*);
+
+	Registry(Registry const&) = delete;
+	Registry& operator=(Registry const&) = delete;
+
+	Registry(Registry&&) = default;
+	Registry& operator=(Registry&&) = default;
+
+	~Registry() = default;
+
+	Registry fork() const;
+
+	std::size_t acquire();
+	// Index the next acquire returns
+	std::size_t next_index() const noexcept
+	{
+		return free_entities_.empty() ? entities_.size() : free_entities_.back();
+	}
+
+	template <typename... Ts>
+	void create(std::size_t, TypeList<Ts...>);
+	template <typename... Ts, typename... Args>
+	void create(std::size_t, TypeList<Ts...>, Args&&...);
+
+	void destroy(std::size_t);
+	// Creates the entity at an index acquired from another registry, with the components of this one moved in
+	void move_to(std::size_t, Registry&, std::size_t);
+
+	// While held, destroyed entities aren't recycled, so that deferred commands targeting them can't reach the
+	// entities created in their place
+	void hold_recycling() noexcept;
+	void release_recycling();
+
+	Record const& operator[](std::size_t index) const noexcept
+	{
+		return entities_[index];
+	}
+
+	std::uint32_t generation(std::size_t index) const noexcept
+	{
+		return generations_[index];
+	}
+
+	template <typename... Ts>
+	bool has_components(std::size_t index) const noexcept
+	{
+		return entities_[index].template has_components<Ts...>();
+	}
+
+	template <typename T>
+	std::size_t count() const noexcept
+	{
+		return counts_[index_of<T, C...>()];
+	}
+
+	template <typename... Ts, typename... X, typename... M, typename U>
+	std::size_t plan(Terms<Without<X...>, Maybe<M...>, U>) const noexcept;
+	template <typename... Ts, typename... X, typename... M, typename U>
+	std::uint64_t matches(std::size_t, Terms<Without<X...>, Maybe<M...>, U>) const noexcept;
+	std::size_t next_word(std::size_t, std::size_t) const noexcept;
+	template <typename... Ts, typename F>
+	std::size_t find(std::size_t, std::size_t, F) const noexcept;
+
+	template <typename T>
+	Reference<T> get_component(std::size_t) noexcept;
+	template <typename T>
+	std::enable_if_t<!std::is_pointer<T>{}, ConstReference<T>> get_component(std::size_t) const noexcept;
+	template <typename P>
+	std::enable_if_t<std::is_pointer<P>{}, std::remove_pointer_t<P>> const* const&
+		get_pointer(std::size_t) const noexcept;
+	template <typename T>
+	T const& get_previous(std::size_t) const noexcept;
+
+	template <typename T, typename... Args>
+	void add_component(std::size_t, Args&&...);
+	template <typename... Ts>
+	void add_components(std::size_t);
+	template <typename... Ts, typename... Args>
+	void add_components(std::size_t, Args&&...);
+
+	template <typename... Ts>
+	void remove_components(std::size_t);
+
+	template <typename T>
+	PoolOf<T>& pool() noexcept
+	{
+		return get<PoolOf<T>>(components_);
+	}
+
+	template <typename T>
+	PoolOf<T> const& pool() const noexcept
+	{
+		return get<PoolOf<T>>(components_);
+	}
+
+	void publish();
+
+	std::size_t size() const noexcept;
+	void reserve(std::size_t);
+
+	MemoryResource* resource() const noexcept;
+
+	private:
+	template <typename>
+	using Column = Vector<std::uint64_t>;
+
+	template <typename T>
+	std::size_t key_(std::size_t) const noexcept;
+	template <typename T>
+	std::size_t key_(std::size_t, std::integral_constant<PoolKey, PoolKey::slot>) const noexcept;
+	template <typename T>
+	std::size_t key_(std::size_t, std::integral_constant<PoolKey, PoolKey::entity>) const noexcept;
+	template <typename T>
+	std::size_t key_(std::size_t, std::integral_constant<PoolKey, PoolKey::none>) const noexcept;
+
+	// Components which move_to copies from a constant reference instead of moving them
+	template <typename T>
+	using Copied = std::integral_constant<bool, std::is_trivially_copyable<T>{} && !std::is_pointer<T>{}>;
+
+	template <typename T, typename Tuple>
+	void assign_comp_(std::size_t, Tuple&&);
+	template <typename T>
+	void erase_comp_(std::size_t);
+	template <typename T>
+	void move_comp_(std::size_t, Registry&, std::size_t, std::true_type);
+	template <typename T>
+	void move_comp_(std::size_t, Registry&, std::size_t, std::false_type);
+
+	Vector<Record> entities_;
+	Vector<std::uint32_t> generations_;
+	Tuple<PoolOf<C>...> components_;
+	std::array<Vector<std::uint64_t>, sizeof...(C)> columns_;
+	std::array<Vector<std::uint64_t>, sizeof...(C)> summaries_;
+	std::array<std::size_t, sizeof...(C)> counts_;
+	Vector<std::size_t> free_entities_;
+	Vector<std::size_t> held_entities_;
+	bool holding_;
+};
+
+} // namespace impl
+
+} // namespace mantra
+
+#include "RegistryImpl.hpp"
+
+#endif // Header guard
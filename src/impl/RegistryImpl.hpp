@@ -0,0 +1,446 @@
+/*****
+ * Copyright Benoit Vey (2016)
+ *
+ * benoit.vey@etu.upmc.fr
+ *
+ * This software is governed by the CeCILL-B license under French law and
+ * abiding by the rules of distribution of free software.  You can  use, 
+ * modify and/ or redistribute the software under the terms of the CeCILL-B
+ * license as circulated by CEA, CNRS and INRIA at the following URL
+ * "http://www.cecill.info". 
+ *
+ * As a counterpart to the access to the source code and  rights to copy,
+ * modify and redistribute granted by the license, users are provided only
+ * with a limited warranty  and the software's author,  the holder of the
+ * economic rights,  and the successive licensors  have only  limited
+ * liability. 
+ *
+ * In this respect, the user's attention is drawn to the risks associated
+ * with loading,  using,  modifying and/or developing or reproducing the
+ * software by the user in light of its specific status of free software,
+ * that may mean  that it is complicated to manipulate,  and  that  also
+ * therefore means  that it is reserved for developers  and  experienced
+ * professionals having in-depth computer knowledge. Users are therefore
+ * encouraged to load and test the software's suitability as regards their
+ * requirements in conditions enabling the security of their systems and/or 
+ * data to be ensured and,  more generally, to use and operate it in the 
+ * same conditions as regards security. 
+ *
+ * The fact that you are presently reading this means that you have had
+ * knowledge of the CeCILL-B license and that you accept its terms.
+ *****/
+
+#ifndef MANTRA_IMPL_REGISTRYIMPL_HPP
+#define MANTRA_IMPL_REGISTRYIMPL_HPP
+
+#include <cassert>
+#include <iterator>
+#include <utility>
+
+#include "../tuple_create.hpp"
+
+#include "Registry.hpp"
+
+namespace mantra
+{
+
+namespace impl
+{
+
+template <typename I, typename... C>
+Registry<I, C...>::Registry(MemoryResource* resource)
+	: entities_{resource}, generations_{resource}, components_{Allocator<C>{resource}...},
+	  columns_{{Column<C>{resource}...}}, summaries_{{Column<C>{resource}...}}, counts_{}, free_entities_{resource},
+	  held_entities_{resource}, holding_{false}
+{}
+
+template <typename I, typename... C>
+auto Registry<I, C...>::fork() const -> Registry
+{
+	Registry res{resource()};
+	res.entities_ = entities_;
+	res.generations_ = generations_;
+	res.components_ = Tuple<PoolOf<C>...>{get<PoolOf<C>>(components_).fork()...};
+	res.columns_ = columns_;
+	res.summaries_ = summaries_;
+	res.counts_ = counts_;
+	res.free_entities_ = free_entities_;
+	return res;
+}
+
+// Every destroyed entity is in the free list, so dead records never need to be searched for
+template <typename I, typename... C>
+std::size_t Registry<I, C...>::acquire()
+{
+	if (!free_entities_.empty())
+	{
+		auto index = free_entities_.back();
+		free_entities_.pop_back();
+		return index;
+	}
+	auto index = entities_.size();
+	entities_.emplace_back();
+	generations_.emplace_back(0);
+	if (index % 64 == 0)
+	{
+		for (auto& column : columns_)
+			column.emplace_back(0);
+	}
+	if (index % (64 * 64) == 0)
+	{
+		for (auto& summary : summaries_)
+			summary.emplace_back(0);
+	}
+	return index;
+}
+
+template <typename I, typename... C>
+template <typename... Ts>
+void Registry<I, C...>::create(std::size_t index, TypeList<Ts...>)
+{
+	entities_[index].create();
+	(void)expand
+	{(
+		assign_comp_<Ts>(index, Tuple<>{}), 0
+	)...};
+}
+
+template <typename I, typename... C>
+template <typename... Ts, typename... Args>
+void Registry<I, C...>::create(std::size_t index, TypeList<Ts...>, Args&&... args)
+{
+	entities_[index].create();
+	(void)expand
+	{(
+		assign_comp_<Ts>(index, std::forward<Args>(args)), 0
+	)...};
+}
+
+template <typename I, typename... C>
+void Registry<I, C...>::destroy(std::size_t index)
+{
+	assert(entities_[index] && "Entity doesn't exists");
+
+	auto const& entity = entities_[index];
+	(void)expand
+	{(
+		entity.template has_components<C>() ? erase_comp_<C>(index) : (void)0, 0
+	)...};
+	entities_[index].destroy();
+	++generations_[index];
+	(holding_ ? held_entities_ : free_entities_).emplace_back(index);
+}
+
+// Struct-of-arrays components are gathered from their fields, and emplaced from the resulting value
+template <typename I, typename... C>
+void Registry<I, C...>::move_to(std::size_t index, Registry& target, std::size_t target_index)
+{
+	assert(entities_[index] && "Entity doesn't exists");
+
+	auto const& entity = entities_[index];
+	target.entities_[target_index].create();
+	(void)expand
+	{(
+		entity.template has_components<C>() ? move_comp_<C>(index, target, target_index, Copied<C>{}) : (void)0, 0
+	)...};
+}
+
+template <typename I, typename... C>
+void Registry<I, C...>::hold_recycling() noexcept
+{
+	holding_ = true;
+}
+
+template <typename I, typename... C>
+void Registry<I, C...>::release_recycling()
+{
+	free_entities_.insert(std::end(free_entities_), std::begin(held_entities_), std::end(held_entities_));
+	held_entities_.clear();
+	holding_ = false;
+}
+
+// Entities [64 * word, 64 * word + 64) owning all of Ts except M, and none of X
+template <typename I, typename... C>
+template <typename... Ts, typename... X, typename... M, typename U>
+std::uint64_t Registry<I, C...>::matches(std::size_t word, Terms<Without<X...>, Maybe<M...>, U>) const noexcept
+{
+	assert(word < columns_[0].size() && "(Dev) Word out of range");
+
+	auto bits = ~std::uint64_t{0};
+	(void)expand
+	{0, (
+		bits &= is_any<Ts, M...>{} ? ~std::uint64_t{0} : columns_[index_of<Stored<Ts>, C...>()][word], 0
+	)...};
+	(void)expand
+	{0, (
+		bits &= ~columns_[index_of<X, C...>()][word], 0
+	)...};
+	return bits;
+}
+
+// Column driving a query over Ts : the one of the required component owned by the fewest entities, or
+// sizeof...(C) if there is no required component
+template <typename I, typename... C>
+template <typename... Ts, typename... X, typename... M, typename U>
+std::size_t Registry<I, C...>::plan(Terms<Without<X...>, Maybe<M...>, U>) const noexcept
+{
+	std::array<std::size_t, sizeof...(Ts)> const columns{{
+		(is_any<Ts, M...>{} ? sizeof...(C) : index_of<Stored<Ts>, C...>())...
+	}};
+	auto res = sizeof...(C);
+	for (auto i : columns)
+	{
+		if (i != sizeof...(C) && (res == sizeof...(C) || counts_[i] < counts_[res]))
+			res = i;
+	}
+	return res;
+}
+
+// First word at or after word in which column has a set bit, or the number of words if there is none
+template <typename I, typename... C>
+std::size_t Registry<I, C...>::next_word(std::size_t column, std::size_t word) const noexcept
+{
+	auto const& summary = summaries_[column];
+	auto block = word / 64;
+	if (block >= summary.size())
+		return columns_[0].size();
+
+	auto bits = summary[block] & ~std::uint64_t{0} << word % 64;
+	while (!bits)
+	{
+		if (++block == summary.size())
+			return columns_[0].size();
+		bits = summary[block];
+	}
+	return 64 * block + count_trailing_zeros(bits);
+}
+
+// First entity at or after index owning all of Ts, or size() if there is none
+// Only the words in which the driving column has a set bit are intersected.
+template <typename I, typename... C>
+template <typename... Ts, typename F>
+std::size_t Registry<I, C...>::find(std::size_t index, std::size_t driver, F filter) const noexcept
+{
+	assert(driver < sizeof...(C) && "(Dev) Queries need a required component");
+
+	auto word = index / 64;
+	if (word >= columns_[0].size())
+		return size();
+
+	auto bits = matches<Ts...>(word, filter) & ~std::uint64_t{0} << index % 64;
+	while (!bits)
+	{
+		word = next_word(driver, word + 1);
+		if (word == columns_[0].size())
+			return size();
+		bits = matches<Ts...>(word, filter);
+	}
+	return 64 * word + count_trailing_zeros(bits);
+}
+
+template <typename I, typename... C>
+template <typename T>
+Reference<T> Registry<I, C...>::get_component(std::size_t index) noexcept
+{
+	assert(entities_[index] && "Entity doesn't exists");
+	assert(entities_[index].template has_components<T>() && "Entity doesn't have this component");
+
+	return pool<T>().get(key_<T>(index));
+}
+
+template <typename I, typename... C>
+template <typename T>
+std::enable_if_t<!std::is_pointer<T>{}, ConstReference<T>>
+	Registry<I, C...>::get_component(std::size_t index) const noexcept
+{
+	assert(entities_[index] && "Entity doesn't exists");
+	assert(entities_[index].template has_components<T>() && "Entity doesn't have this component");
+
+	return pool<T>().get(key_<T>(index));
+}
+
+template <typename I, typename... C>
+template <typename P>
+std::enable_if_t<std::is_pointer<P>{}, std::remove_pointer_t<P>> const* const&
+	Registry<I, C...>::get_pointer(std::size_t index) const noexcept
+{
+	assert(entities_[index] && "Entity doesn't exists");
+	assert(entities_[index].template has_components<P>() && "Entity doesn't have this component");
+
+	using T = std::remove_pointer_t<P>;
+
+	return *const_cast<T const**>(&pool<P>().get(key_<P>(index)));
+}
+
+template <typename I, typename... C>
+template <typename T>
+T const& Registry<I, C...>::get_previous(std::size_t index) const noexcept
+{
+	assert(entities_[index] && "Entity doesn't exists");
+	assert(entities_[index].template has_components<T>() && "Entity doesn't have this component");
+
+	return pool<T>().previous(key_<T>(index));
+}
+
+template <typename I, typename... C>
+template <typename T, typename... Args>
+void Registry<I, C...>::add_component(std::size_t index, Args&&... args)
+{
+	assert(entities_[index] && "Entity doesn't exists");
+
+	assign_comp_<T>(index, mantra::forward_as_tuple(std::forward<Args>(args)...));
+}
+
+template <typename I, typename... C>
+template <typename... Ts>
+void Registry<I, C...>::add_components(std::size_t index)
+{
+	assert(entities_[index] && "Entity doesn't exists");
+
+	(void)expand
+	{(
+		assign_comp_<Ts>(index, Tuple<>{}), 0
+	)...};
+}
+
+template <typename I, typename... C>
+template <typename... Ts, typename... Args>
+void Registry<I, C...>::add_components(std::size_t index, Args&&... args)
+{
+	assert(entities_[index] && "Entity doesn't exists");
+
+	(void)expand
+	{(
+		assign_comp_<Ts>(index, std::forward<Args>(args)), 0
+	)...};
+}
+
+template <typename I, typename... C>
+template <typename... Ts>
+void Registry<I, C...>::remove_components(std::size_t index)
+{
+	assert(entities_[index] && "Entity doesn't exists");
+
+	(void)expand
+	{(
+		erase_comp_<Ts>(index), 0
+	)...};
+}
+
+template <typename I, typename... C>
+void Registry<I, C...>::publish()
+{
+	(void)expand
+	{0, (
+		impl::publish(pool<C>()), 0
+	)...};
+}
+
+template <typename I, typename... C>
+std::size_t Registry<I, C...>::size() const noexcept
+{
+	return entities_.size();
+}
+
+template <typename I, typename... C>
+void Registry<I, C...>::reserve(std::size_t n)
+{
+	if (free_entities_.size() < n)
+	{
+		auto size = entities_.size() + n - free_entities_.size();
+		entities_.reserve(size);
+		generations_.reserve(size);
+		for (auto& column : columns_)
+			column.reserve((size + 63) / 64);
+		for (auto& summary : summaries_)
+			summary.reserve((size + 64 * 64 - 1) / (64 * 64));
+	}
+}
+
+template <typename I, typename... C>
+MemoryResource* Registry<I, C...>::resource() const noexcept
+{
+	return entities_.get_allocator().resource();
+}
+
+template <typename I, typename... C>
+template <typename T>
+std::size_t Registry<I, C...>::key_(std::size_t index) const noexcept
+{
+	return key_<T>(index, pool_key<PoolOf<T>>{});
+}
+
+template <typename I, typename... C>
+template <typename T>
+std::size_t Registry<I, C...>::key_(std::size_t index, std::integral_constant<PoolKey, PoolKey::slot>) const noexcept
+{
+	return entities_[index].template key<T>();
+}
+
+template <typename I, typename... C>
+template <typename T>
+std::size_t Registry<I, C...>::key_(std::size_t index,
+                                    std::integral_constant<PoolKey, PoolKey::entity>) const noexcept
+{
+	return index;
+}
+
+template <typename I, typename... C>
+template <typename T>
+std::size_t Registry<I, C...>::key_(std::size_t, std::integral_constant<PoolKey, PoolKey::none>) const noexcept
+{
+	return 0;
+}
+
+template <typename I, typename... C>
+template <typename T, typename Tuple>
+void Registry<I, C...>::assign_comp_(std::size_t index, Tuple&& args)
+{
+	auto& pool = this->template pool<T>();
+	auto key = invoke([&pool, index](auto&&... a){return pool.emplace(index, std::forward<decltype(a)>(a)...);},
+	                  std::forward<Tuple>(args));
+	entities_[index].template add<T>(key);
+
+	auto column = index_of<T, C...>();
+	auto word = index / 64;
+	columns_[column][word] |= std::uint64_t{1} << index % 64;
+	summaries_[column][word / 64] |= std::uint64_t{1} << word % 64;
+	++counts_[column];
+}
+
+template <typename I, typename... C>
+template <typename T>
+void Registry<I, C...>::erase_comp_(std::size_t index)
+{
+	pool<T>().erase(key_<T>(index));
+	entities_[index].template remove<T>();
+
+	auto column = index_of<T, C...>();
+	auto word = index / 64;
+	if (!(columns_[column][word] &= ~(std::uint64_t{1} << index % 64)))
+		summaries_[column][word / 64] &= ~(std::uint64_t{1} << word % 64);
+	--counts_[column];
+}
+
+// Trivially copyable components are read through a constant reference, which leaves the pages they share with
+// forks as they are, since copying them is the same as moving them
+template <typename I, typename... C>
+template <typename T>
+void Registry<I, C...>::move_comp_(std::size_t index, Registry& target, std::size_t target_index, std::true_type)
+{
+	target.template assign_comp_<T>(target_index, forward_as_tuple(as_const(*this).template get_component<T>(index)));
+}
+
+// Moving the other components needs write access to them
+template <typename I, typename... C>
+template <typename T>
+void Registry<I, C...>::move_comp_(std::size_t index, Registry& target, std::size_t target_index, std::false_type)
+{
+	target.template assign_comp_<T>(target_index, forward_as_tuple(std::move(get_component<T>(index))));
+}
+
+} // namespace impl
+
+} // namespace mantra
+
+#endif // Header guard
@@ -0,0 +1,151 @@
+/*****
+ * Copyright Benoit Vey (2016)
+ *
+ * benoit.vey@etu.upmc.fr
+ *
+ * This software is governed by the CeCILL-B license under French law and
+ * abiding by the rules of distribution of free software.  You can  use, 
+ * modify and/ or redistribute the software under the terms of the CeCILL-B
+ * license as circulated by CEA, CNRS and INRIA at the following URL
+ * "http://www.cecill.info". 
+ *
+ * As a counterpart to the access to the source code and  rights to copy,
+ * modify and redistribute granted by the license, users are provided only
+ * with a limited warranty  and the software's author,  the holder of the
+ * economic rights,  and the successive licensors  have only  limited
+ * liability. 
+ *
+ * In this respect, the user's attention is drawn to the risks associated
+ * with loading,  using,  modifying and/or developing or reproducing the
+ * software by the user in light of its specific status of free software,
+ * that may mean  that it is complicated to manipulate,  and  that  also
+ * therefore means  that it is reserved for developers  and  experienced
+ * professionals having in-depth computer knowledge. Users are therefore
+ * encouraged to load and test the software's suitability as regards their
+ * requirements in conditions enabling the security of their systems and/or 
+ * data to be ensured and,  more generally, to use and operate it in the 
+ * same conditions as regards security. 
+ *
+ * The fact that you are presently reading this means that you have had
+ * knowledge of the CeCILL-B license and that you accept its terms.
+ *****/
+
+#ifndef MANTRA_IMPL_SCHEDULE_HPP
+#define MANTRA_IMPL_SCHEDULE_HPP
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include "utility.hpp"
+
+namespace mantra
+{
+
+namespace impl
+{
+
+// Types a system reads or writes : its components, optional ones included, its resources and its primary type
+template <typename S, typename T, typename D = typename TermsOf<S>::type>
+struct accesses;
+
+template <typename S, typename T, typename X, typename M, typename... U>
+struct accesses<S, T, Terms<X, M, Uses<U...>>>
+	: std::integral_constant<bool, typename S::Components{}.template contains<T>() || is_any<T, U...>{} ||
+	                               std::is_same<T, typename S::Primary>{}>
+{};
+
+// Two systems conflict if one of them writes something the other accesses
+// Excluded components aren't accesses, since only structural changes modify them, and neither are the
+// Previous<T> components, whose copies are only written between frames.
+template <typename A, typename B>
+struct conflicts
+	: std::integral_constant<bool,
+	                         (!std::is_same<typename A::Primary, void>{} && accesses<B, typename A::Primary>{}) ||
+	                         (!std::is_same<typename B::Primary, void>{} && accesses<A, typename B::Primary>{})>
+{};
+
+template <std::size_t N>
+struct StageIndices
+{
+	std::size_t of[N + 1];
+	std::size_t count;
+};
+
+// Each system goes in the stage following the last stage holding an earlier system it conflicts with, so
+// conflicting systems keep their relative order and systems of a stage can run concurrently
+template <typename... S, std::size_t... Is>
+constexpr StageIndices<sizeof...(S)> stage_indices(std::index_sequence<Is...>) noexcept
+{
+	std::size_t constexpr n{sizeof...(S)};
+	bool const conflict[]{false, conflicts<TypeOf<Is / n, S...>, TypeOf<Is % n, S...>>{}...};
+
+	StageIndices<n> res{{}, 0};
+	for (std::size_t i{0}; i < n; ++i)
+	{
+		std::size_t stage{0};
+		for (std::size_t j{0}; j < i; ++j)
+		{
+			if (conflict[1 + i * n + j] && res.of[j] >= stage)
+				stage = res.of[j] + 1;
+		}
+		res.of[i] = stage;
+		if (stage >= res.count)
+			res.count = stage + 1;
+	}
+	return res;
+}
+
+template <typename... S>
+constexpr StageIndices<sizeof...(S)> stage_indices() noexcept
+{
+	return stage_indices<S...>(std::make_index_sequence<sizeof...(S) * sizeof...(S)>{});
+}
+
+template <typename...>
+struct Join;
+
+template <>
+struct Join<>
+{
+	using type = TypeList<>;
+};
+
+template <typename... Ts>
+struct Join<TypeList<Ts...>>
+{
+	using type = TypeList<Ts...>;
+};
+
+template <typename... Ts, typename... Us, typename... Ls>
+struct Join<TypeList<Ts...>, TypeList<Us...>, Ls...> : Join<TypeList<Ts..., Us...>, Ls...>
+{};
+
+// Systems of the stage K, in declaration order
+template <std::size_t K, typename L, typename Is>
+struct StageOf;
+
+template <std::size_t K, typename... S, std::size_t... Is>
+struct StageOf<K, TypeList<S...>, std::index_sequence<Is...>>
+	: Join<std::conditional_t<stage_indices<S...>().of[Is] == K, TypeList<S>, TypeList<>>...>
+{};
+
+template <typename L, typename Ks>
+struct ScheduleImpl;
+
+template <typename... S, std::size_t... Ks>
+struct ScheduleImpl<TypeList<S...>, std::index_sequence<Ks...>>
+{
+	using type = TypeList<typename StageOf<Ks, TypeList<S...>, std::index_sequence_for<S...>>::type...>;
+};
+
+// Stages of a system list, as a TypeList of TypeLists of systems
+template <typename... S>
+using Schedule = typename ScheduleImpl<TypeList<S...>,
+                                       std::make_index_sequence<stage_indices<S...>().count>>::type;
+
+} // namespace impl
+
+} // namespace mantra
+
+#endif // Header guard
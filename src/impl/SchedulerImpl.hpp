@@ -0,0 +1,311 @@
+/*****
+ * Copyright Benoit Vey (2016)
+ *
+ * benoit.vey@etu.upmc.fr
+ *
+ * This software is governed by the CeCILL-B license under French law and
+ * abiding by the rules of distribution of free software.  You can  use, 
+ * modify and/ or redistribute the software under the terms of the CeCILL-B
+ * license as circulated by CEA, CNRS and INRIA at the following URL
+ * "http://www.cecill.info". 
+ *
+ * As a counterpart to the access to the source code and  rights to copy,
+ * modify and redistribute granted by the license, users are provided only
+ * with a limited warranty  and the software's author,  the holder of the
+ * economic rights,  and the successive licensors  have only  limited
+ * liability. 
+ *
+ * In this respect, the user's attention is drawn to the risks associated
+ * with loading,  using,  modifying and/or developing or reproducing the
+ * software by the user in light of its specific status of free software,
+ * that may mean  that it is complicated to manipulate,  and  that  also
+ * therefore means  that it is reserved for developers  and  experienced
+ * professionals having in-depth computer knowledge. Users are therefore
+ * encouraged to load and test the software's suitability as regards their
+ * requirements in conditions enabling the security of their systems and/or 
+ * data to be ensured and,  more generally, to use and operate it in the 
+ * same conditions as regards security. 
+ *
+ * The fact that you are presently reading this means that you have had
+ * knowledge of the CeCILL-B license and that you accept its terms.
+ *****/
+
+#ifndef MANTRA_IMPL_SCHEDULERIMPL_HPP
+#define MANTRA_IMPL_SCHEDULERIMPL_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <type_traits>
+#include <utility>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "../Scheduler.hpp"
+
+namespace mantra
+{
+
+namespace impl
+{
+
+// Scheduler and queue of the worker running on the current thread, if any
+struct CurrentWorker
+{
+	Scheduler const* scheduler;
+	std::size_t queue;
+};
+
+inline CurrentWorker& current_worker() noexcept
+{
+	static thread_local CurrentWorker worker{nullptr, 0};
+	return worker;
+}
+
+template <typename F>
+void run_callable(void* context, std::size_t, std::size_t)
+{
+	std::unique_ptr<F> f{static_cast<F*>(context)};
+	(*f)();
+}
+
+template <typename F>
+void run_range(void* context, std::size_t begin, std::size_t end)
+{
+	(*static_cast<F*>(context))(begin, end);
+}
+
+} // namespace impl
+
+inline TaskGroup::TaskGroup() noexcept
+	: pending_{1}, done_{false}, open_{true}, continuation_{nullptr, nullptr, 0, 0, nullptr}
+{}
+
+inline TaskGroup::~TaskGroup()
+{
+	assert((done_ || (open_ && pending_ == 1)) && "Destroying a group with pending tasks");
+}
+
+inline Scheduler::Scheduler(std::size_t workers)
+	: Scheduler{workers, {}}
+{}
+
+inline Scheduler::Scheduler(std::size_t workers, std::vector<unsigned> const& cpus)
+	: workers_{workers}, queues_{new Queue[workers + 1]}, threads_{}, queued_{0}, sleepers_{0}, stop_{false}
+{
+	threads_.reserve(workers);
+	for (std::size_t i{0}; i < workers; ++i)
+	{
+		threads_.emplace_back(&Scheduler::work_, this, i);
+		if (!cpus.empty())
+			pin_(threads_.back(), cpus[i % cpus.size()]);
+	}
+}
+
+inline Scheduler::~Scheduler()
+{
+	assert(!queued_ && "Destroying a scheduler with pending tasks");
+
+	{
+		std::lock_guard<std::mutex> lock{sleep_mutex_};
+		stop_.store(true);
+	}
+	wake_.notify_all();
+	for (auto& thread : threads_)
+		thread.join();
+}
+
+inline std::size_t Scheduler::workers() const noexcept
+{
+	return workers_;
+}
+
+inline std::size_t Scheduler::default_workers() noexcept
+{
+	auto threads = std::thread::hardware_concurrency();
+	return threads > 1 ? threads - 1 : 0;
+}
+
+template <typename F>
+void Scheduler::spawn(TaskGroup& group, F&& f)
+{
+	assert(group.pending_.load(std::memory_order_relaxed) && "Spawning in a completed group");
+
+	using Fn = std::decay_t<F>;
+	auto fn = new Fn(std::forward<F>(f));
+	group.pending_.fetch_add(1, std::memory_order_relaxed);
+	push_({&impl::run_callable<Fn>, fn, 0, 0, &group});
+}
+
+template <typename F>
+void Scheduler::then(TaskGroup& group, TaskGroup& next, F&& f)
+{
+	assert(group.open_ && !group.continuation_.fn && "The group already has a continuation or is being waited for");
+	assert(next.pending_.load(std::memory_order_relaxed) && "Spawning in a completed group");
+
+	using Fn = std::decay_t<F>;
+	auto fn = new Fn(std::forward<F>(f));
+	next.pending_.fetch_add(1, std::memory_order_relaxed);
+	group.continuation_ = {&impl::run_callable<Fn>, fn, 0, 0, &next};
+	close_(group);
+}
+
+inline void Scheduler::wait(TaskGroup& group)
+{
+	if (group.open_)
+		close_(group);
+
+	auto queue = queue_();
+	impl::Task task;
+	while (!group.done_.load(std::memory_order_acquire))
+	{
+		if (pop_(task, queue))
+			execute_(task);
+		else
+			std::this_thread::yield();
+	}
+
+	group.pending_.store(1, std::memory_order_relaxed);
+	group.done_.store(false, std::memory_order_relaxed);
+	group.open_ = true;
+}
+
+// The ranges are pushed on the queue of the calling thread, which runs them from the last while the workers
+// steal them from the first
+template <typename F>
+void Scheduler::parallel_for(std::size_t n, std::size_t grain, F&& f)
+{
+	assert(grain && "The grain must be positive");
+
+	using Fn = std::remove_reference_t<F>;
+	auto context = const_cast<void*>(static_cast<void const*>(std::addressof(f)));
+	TaskGroup group;
+	for (std::size_t begin{0}; begin < n; begin += grain)
+	{
+		group.pending_.fetch_add(1, std::memory_order_relaxed);
+		push_({&impl::run_range<Fn>, context, begin, std::min(n, begin + grain), &group});
+	}
+	wait(group);
+}
+
+inline std::size_t Scheduler::queue_() const noexcept
+{
+	auto const& worker = impl::current_worker();
+	return worker.scheduler == this ? worker.queue : workers_;
+}
+
+// A sleeping worker registers in sleepers_ before checking queued_ under the mutex, and a pusher increments
+// queued_ before checking sleepers_, so either the worker sees the task or the pusher wakes it up
+inline void Scheduler::push_(impl::Task const& task)
+{
+	auto& queue = queues_[queue_()];
+	{
+		std::lock_guard<std::mutex> lock{queue.mutex};
+		queue.tasks.push_back(task);
+	}
+	queued_.fetch_add(1);
+	if (sleepers_.load())
+	{
+		std::lock_guard<std::mutex> lock{sleep_mutex_};
+		wake_.notify_one();
+	}
+}
+
+// Own queue from the back, then the other queues from the front
+inline bool Scheduler::pop_(impl::Task& task, std::size_t self)
+{
+	if (!queued_.load(std::memory_order_relaxed))
+		return false;
+
+	for (std::size_t i{0}; i <= workers_; ++i)
+	{
+		auto& queue = queues_[(self + i) % (workers_ + 1)];
+		std::lock_guard<std::mutex> lock{queue.mutex};
+		if (queue.tasks.empty())
+			continue;
+		if (i == 0 && self != workers_)
+		{
+			task = queue.tasks.back();
+			queue.tasks.pop_back();
+		}
+		else
+		{
+			task = queue.tasks.front();
+			queue.tasks.pop_front();
+		}
+		queued_.fetch_sub(1, std::memory_order_relaxed);
+		return true;
+	}
+	return false;
+}
+
+inline void Scheduler::execute_(impl::Task const& task) noexcept
+{
+	task.fn(task.context, task.begin, task.end);
+	finish_(*task.group);
+}
+
+// The thread completing the group spawns the continuation, then lets the waiting thread go
+inline void Scheduler::finish_(TaskGroup& group)
+{
+	if (group.pending_.fetch_sub(1, std::memory_order_acq_rel) != 1)
+		return;
+
+	auto continuation = group.continuation_;
+	group.continuation_.fn = nullptr;
+	group.done_.store(true, std::memory_order_release);
+	if (continuation.fn)
+		push_(continuation);
+}
+
+inline void Scheduler::close_(TaskGroup& group)
+{
+	group.open_ = false;
+	finish_(group);
+}
+
+// Workers yield for a while before sleeping, so that a burst of short tasks doesn't put them to sleep
+inline void Scheduler::work_(std::size_t index)
+{
+	impl::current_worker() = {this, index};
+
+	impl::Task task;
+	std::size_t idle{0};
+	while (!stop_.load())
+	{
+		if (pop_(task, index))
+		{
+			execute_(task);
+			idle = 0;
+		}
+		else if (++idle < 64)
+			std::this_thread::yield();
+		else
+		{
+			std::unique_lock<std::mutex> lock{sleep_mutex_};
+			sleepers_.fetch_add(1);
+			wake_.wait(lock, [this]{return stop_.load() || queued_.load();});
+			sleepers_.fetch_sub(1);
+			idle = 0;
+		}
+	}
+}
+
+inline void Scheduler::pin_(std::thread& thread, unsigned cpu)
+{
+#if defined(__linux__)
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+#else
+	(void)thread;
+	(void)cpu;
+#endif
+}
+
+} // namespace mantra
+
+#endif // Header guard
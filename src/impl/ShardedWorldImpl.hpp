@@ -0,0 +1,188 @@
+/*****
+ * Copyright Benoit Vey (2016)
+ *
+ * benoit.vey@etu.upmc.fr
+ *
+ * This software is governed by the CeCILL-B license under French law and
+ * abiding by the rules of distribution of free software.  You can  use, 
+ * modify and/ or redistribute the software under the terms of the CeCILL-B
+ * license as circulated by CEA, CNRS and INRIA at the following URL
+ * "http://www.cecill.info". 
+ *
+ * As a counterpart to the access to the source code and  rights to copy,
+ * modify and redistribute granted by the license, users are provided only
+ * with a limited warranty  and the software's author,  the holder of the
+ * economic rights,  and the successive licensors  have only  limited
+ * liability. 
+ *
+ * In this respect, the user's attention is drawn to the risks associated
+ * with loading,  using,  modifying and/or developing or reproducing the
+ * software by the user in light of its specific status of free software,
+ * that may mean  that it is complicated to manipulate,  and  that  also
+ * therefore means  that it is reserved for developers  and  experienced
+ * professionals having in-depth computer knowledge. Users are therefore
+ * encouraged to load and test the software's suitability as regards their
+ * requirements in conditions enabling the security of their systems and/or 
+ * data to be ensured and,  more generally, to use and operate it in the 
+ * same conditions as regards security. 
+ *
+ * The fact that you are presently reading this means that you have had
+ * knowledge of the CeCILL-B license and that you accept its terms.
+ *****/
+
+#ifndef MANTRA_IMPL_SHARDEDWORLDIMPL_HPP
+#define MANTRA_IMPL_SHARDEDWORLDIMPL_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <tuple>
+
+#include "../ShardedWorld.hpp"
+
+namespace mantra
+{
+
+template <typename W>
+ShardedWorld<W>::ShardedWorld(std::size_t shards) : ShardedWorld{shards, [](std::size_t){ return W{}; }}
+{}
+
+// The shards are never reallocated once constructed, since their handles refer to them
+template <typename W>
+template <typename F>
+ShardedWorld<W>::ShardedWorld(std::size_t shards, F&& make) : shards_{}, migrations_{}, scheduler_{nullptr}
+{
+	assert(shards > 0 && "No shard");
+
+	shards_.reserve(shards);
+	for (std::size_t i{0}; i < shards; ++i)
+		shards_.emplace_back(make(i));
+}
+
+template <typename W>
+std::size_t ShardedWorld<W>::shards() const noexcept
+{
+	return shards_.size();
+}
+
+template <typename W>
+W& ShardedWorld<W>::shard(std::size_t i) noexcept
+{
+	assert(i < shards_.size() && "Invalid shard");
+
+	return shards_[i];
+}
+
+template <typename W>
+W const& ShardedWorld<W>::shard(std::size_t i) const noexcept
+{
+	assert(i < shards_.size() && "Invalid shard");
+
+	return shards_[i];
+}
+
+template <typename W>
+template <typename P, typename... O>
+void ShardedWorld<W>::migrate(EntityHandle<W, P, O...> const& entity, std::size_t target)
+{
+	assert(target < shards_.size() && "Invalid shard");
+
+	auto source = std::find_if(std::begin(shards_), std::end(shards_),
+	                           [&entity](W const& shard){ return &shard.data_ == &entity.data_; });
+	assert(source != std::end(shards_) && "Entity isn't in a shard");
+	assert(entity.data_[entity.index_] && "Entity isn't valid");
+
+	auto i = static_cast<std::size_t>(source - std::begin(shards_));
+	if (i != target)
+		migrations_.push_back({i, entity.index_, entity.data_.generation(entity.index_), target});
+}
+
+template <typename W>
+std::size_t ShardedWorld<W>::apply_migrations()
+{
+	return apply_migrations([](Handle const&, Handle const&){});
+}
+
+// Only the first migration queued for an entity is kept : the stable sort by entity keeps it in front of the
+// later ones, which unique drops. The rest are then grouped by pair of shards, so that each pair of registries is
+// walked once.
+template <typename W>
+template <typename F>
+std::size_t ShardedWorld<W>::apply_migrations(F&& remap)
+{
+	auto same_entity = [](Migration const& l, Migration const& r)
+	{
+		return l.source == r.source && l.index == r.index && l.generation == r.generation;
+	};
+	std::stable_sort(std::begin(migrations_), std::end(migrations_), [](Migration const& l, Migration const& r)
+	{
+		return std::tie(l.source, l.index, l.generation) < std::tie(r.source, r.index, r.generation);
+	});
+	migrations_.erase(std::unique(std::begin(migrations_), std::end(migrations_), same_entity),
+	                  std::end(migrations_));
+	std::stable_sort(std::begin(migrations_), std::end(migrations_), [](Migration const& l, Migration const& r)
+	{
+		return l.source != r.source ? l.source < r.source : l.target < r.target;
+	});
+
+	std::size_t res{0};
+	for (auto const& migration : migrations_)
+	{
+		auto& source = shards_[migration.source];
+		if (!source.data_[migration.index] || source.data_.generation(migration.index) != migration.generation)
+			continue;
+		source.migrate_(migration.index, shards_[migration.target], remap);
+		++res;
+	}
+	migrations_.clear();
+	return res;
+}
+
+template <typename W>
+void ShardedWorld<W>::update()
+{
+	apply_migrations();
+	update_([](W& shard){ shard.update(); });
+}
+
+template <typename W>
+void ShardedWorld<W>::update(double dt)
+{
+	apply_migrations();
+	update_([dt](W& shard){ shard.update(dt); });
+}
+
+template <typename W>
+void ShardedWorld<W>::set_scheduler(Scheduler* scheduler) noexcept
+{
+	scheduler_ = scheduler;
+	for (auto& shard : shards_)
+		shard.set_scheduler(scheduler);
+}
+
+template <typename W>
+Scheduler* ShardedWorld<W>::scheduler() const noexcept
+{
+	return scheduler_;
+}
+
+// A shard waiting for its own parallel loops runs the tasks of the other shards meanwhile, see Scheduler::wait
+template <typename W>
+template <typename F>
+void ShardedWorld<W>::update_(F f)
+{
+	if (!scheduler_)
+	{
+		for (auto& shard : shards_)
+			f(shard);
+		return;
+	}
+
+	TaskGroup group;
+	for (auto& shard : shards_)
+		scheduler_->spawn(group, [&shard, &f]{ f(shard); });
+	scheduler_->wait(group);
+}
+
+} // namespace mantra
+
+#endif // Header guard
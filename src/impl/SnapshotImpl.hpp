@@ -0,0 +1,113 @@
+/*****
+ * Copyright Benoit Vey (2016)
+ *
+ * benoit.vey@etu.upmc.fr
+ *
+ * This software is governed by the CeCILL-B license under French law and
+ * abiding by the rules of distribution of free software.  You can  use, 
+ * modify and/ or redistribute the software under the terms of the CeCILL-B
+ * license as circulated by CEA, CNRS and INRIA at the following URL
+ * "http://www.cecill.info". 
+ *
+ * As a counterpart to the access to the source code and  rights to copy,
+ * modify and redistribute granted by the license, users are provided only
+ * with a limited warranty  and the software's author,  the holder of the
+ * economic rights,  and the successive licensors  have only  limited
+ * liability. 
+ *
+ * In this respect, the user's attention is drawn to the risks associated
+ * with loading,  using,  modifying and/or developing or reproducing the
+ * software by the user in light of its specific status of free software,
+ * that may mean  that it is complicated to manipulate,  and  that  also
+ * therefore means  that it is reserved for developers  and  experienced
+ * professionals having in-depth computer knowledge. Users are therefore
+ * encouraged to load and test the software's suitability as regards their
+ * requirements in conditions enabling the security of their systems and/or 
+ * data to be ensured and,  more generally, to use and operate it in the 
+ * same conditions as regards security. 
+ *
+ * The fact that you are presently reading this means that you have had
+ * knowledge of the CeCILL-B license and that you accept its terms.
+ *****/
+
+#ifndef MANTRA_IMPL_SNAPSHOTIMPL_HPP
+#define MANTRA_IMPL_SNAPSHOTIMPL_HPP
+
+#include "../Snapshot.hpp"
+
+namespace mantra
+{
+
+template <typename... Ts>
+Snapshot<Ts...>::Snapshot(Buffer const* buffer) noexcept
+	: buffer_{buffer}
+{}
+
+template <typename... Ts>
+Snapshot<Ts...>::Snapshot(Snapshot&& mv) noexcept
+	: buffer_{mv.buffer_}
+{
+	mv.buffer_ = nullptr;
+}
+
+template <typename... Ts>
+Snapshot<Ts...>::~Snapshot()
+{
+	if (buffer_)
+		impl::SnapshotRing<Ts...>::unpin(buffer_);
+}
+
+template <typename... Ts>
+Snapshot<Ts...>::operator bool() const noexcept
+{
+	return buffer_ != nullptr;
+}
+
+template <typename... Ts>
+std::uint64_t Snapshot<Ts...>::frame() const noexcept
+{
+	assert(buffer_ && "Empty snapshot");
+
+	return buffer_->frame;
+}
+
+template <typename... Ts>
+std::size_t Snapshot<Ts...>::size() const noexcept
+{
+	using First = impl::TypeOf<0, Ts...>;
+
+	return buffer_ ? std::get<impl::Vector<First>>(buffer_->items).size() : 0;
+}
+
+template <typename... Ts>
+template <typename T>
+T const& Snapshot<Ts...>::get(std::size_t i) const noexcept
+{
+	static_assert(impl::TypeList<Ts...>{}.template contains<T>(), "Invalid component type");
+	assert(i < size() && "Entity out of range");
+
+	return std::get<impl::Vector<T>>(buffer_->items)[i];
+}
+
+template <typename... Ts>
+template <typename F>
+void Snapshot<Ts...>::for_each(F&& f) const
+{
+	for (std::size_t i{0}, n = size(); i < n; ++i)
+		f(std::get<impl::Vector<Ts>>(buffer_->items)[i]...);
+}
+
+template <typename... Ts>
+SnapshotReader<Ts...>::SnapshotReader(impl::SnapshotRing<Ts...>& ring) noexcept
+	: ring_{&ring}
+{}
+
+template <typename... Ts>
+Snapshot<Ts...> SnapshotReader<Ts...>::read() const noexcept
+{
+	return Snapshot<Ts...>{ring_->pin()};
+}
+
+} // namespace mantra
+
+#endif // Header guard
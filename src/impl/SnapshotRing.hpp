@@ -0,0 +1,163 @@
+/*****
+ * Copyright Benoit Vey (2016)
+ *
+ * benoit.vey@etu.upmc.fr
+ *
+ * This software is governed by the CeCILL-B license under French law and
+ * abiding by the rules of distribution of free software.  You can  use, 
+ * modify and/ or redistribute the software under the terms of the CeCILL-B
+ * license as circulated by CEA, CNRS and INRIA at the following URL
+ * "http://www.cecill.info". 
+ *
+ * As a counterpart to the access to the source code and  rights to copy,
+ * modify and redistribute granted by the license, users are provided only
+ * with a limited warranty  and the software's author,  the holder of the
+ * economic rights,  and the successive licensors  have only  limited
+ * liability. 
+ *
+ * In this respect, the user's attention is drawn to the risks associated
+ * with loading,  using,  modifying and/or developing or reproducing the
+ * software by the user in light of its specific status of free software,
+ * that may mean  that it is complicated to manipulate,  and  that  also
+ * therefore means  that it is reserved for developers  and  experienced
+ * professionals having in-depth computer knowledge. Users are therefore
+ * encouraged to load and test the software's suitability as regards their
+ * requirements in conditions enabling the security of their systems and/or 
+ * data to be ensured and,  more generally, to use and operate it in the 
+ * same conditions as regards security. 
+ *
+ * The fact that you are presently reading this means that you have had
+ * knowledge of the CeCILL-B license and that you accept its terms.
+ *****/
+
+#ifndef MANTRA_IMPL_SNAPSHOTRING_HPP
+#define MANTRA_IMPL_SNAPSHOTRING_HPP
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <tuple>
+
+#include "Allocator.hpp"
+#include "utility.hpp"
+
+namespace mantra
+{
+
+namespace impl
+{
+
+// Copies of the components Ts of the entities owning all of them, taken by the thread updating a registry and
+// read by other threads
+// Each buffer counts its readers, and its high bit tells that the writer owns it. A reader increments the count
+// of the newest buffer, and backs off if the writer owns it or has published another buffer in the meantime.
+// The writer only takes a buffer which is neither the newest nor read, by swapping a zero count for the high
+// bit, and skips the frame if there is none. Neither side ever waits for the other, and the writer's cost is
+// the copy of the components.
+template <typename... Ts>
+class SnapshotRing
+{
+	static std::size_t constexpr none{~std::size_t{0}};
+	static std::size_t constexpr writing_bit{~(~std::size_t{0} >> 1)};
+
+	public:
+	struct Buffer
+	{
+		explicit Buffer(MemoryResource* resource) : readers{0}, frame{0}, items{Vector<Ts>{resource}...} {}
+
+		mutable std::atomic<std::size_t> readers;
+		std::uint64_t frame;
+		std::tuple<Vector<Ts>...> items;
+	};
+
+	SnapshotRing(MemoryResource* resource, std::size_t buffers)
+		: resource_{resource}, buffers_{static_cast<Buffer*>(resource->allocate(buffers * sizeof(Buffer),
+		                                                                        alignof(Buffer)))},
+		  count_{buffers}, latest_{none}, frames_{0}
+	{
+		assert(buffers >= 2 && "Snapshots need at least 2 buffers");
+
+		for (std::size_t i{0}; i < count_; ++i)
+			new (buffers_ + i) Buffer{resource};
+	}
+
+	SnapshotRing(SnapshotRing const&) = delete;
+	SnapshotRing& operator=(SnapshotRing const&) = delete;
+
+	~SnapshotRing()
+	{
+		for (std::size_t i{0}; i < count_; ++i)
+			buffers_[i].~Buffer();
+		resource_->deallocate(buffers_, count_ * sizeof(Buffer), alignof(Buffer));
+	}
+
+	// Called by the writer at the end of each frame
+	template <typename R>
+	void capture(R const& data)
+	{
+		++frames_;
+		auto latest = latest_.load(std::memory_order_relaxed);
+		for (std::size_t i{0}; i < count_; ++i)
+		{
+			std::size_t idle{0};
+			if (i == latest || !buffers_[i].readers.compare_exchange_strong(idle, writing_bit,
+			                                                                std::memory_order_acquire,
+			                                                                std::memory_order_relaxed))
+				continue;
+			fill_(buffers_[i], data);
+			buffers_[i].readers.fetch_and(~writing_bit, std::memory_order_release);
+			latest_.store(i, std::memory_order_release);
+			return;
+		}
+	}
+
+	// Newest buffer, or null if none was published yet
+	Buffer const* pin() noexcept
+	{
+		for (;;)
+		{
+			auto i = latest_.load(std::memory_order_acquire);
+			if (i == none)
+				return nullptr;
+			auto& buffer = buffers_[i];
+			auto readers = buffer.readers.fetch_add(1, std::memory_order_acquire);
+			if (!(readers & writing_bit) && latest_.load(std::memory_order_acquire) == i)
+				return &buffer;
+			buffer.readers.fetch_sub(1, std::memory_order_release);
+		}
+	}
+
+	static void unpin(Buffer const* buffer) noexcept
+	{
+		buffer->readers.fetch_sub(1, std::memory_order_release);
+	}
+
+	private:
+	template <typename R>
+	void fill_(Buffer& buffer, R const& data)
+	{
+		(void)expand{(std::get<Vector<Ts>>(buffer.items).clear(), 0)...};
+		auto driver = data.template plan<Ts...>(NoTerms{});
+		for (auto index = data.template find<Ts...>(0, driver, NoTerms{}); index < data.size();
+		     index = data.template find<Ts...>(index + 1, driver, NoTerms{}))
+		{
+			(void)expand{(std::get<Vector<Ts>>(buffer.items).emplace_back(data.template get_component<Ts>(index)),
+			              0)...};
+		}
+		buffer.frame = frames_;
+	}
+
+	MemoryResource* resource_;
+	Buffer* buffers_;
+	std::size_t count_;
+	std::atomic<std::size_t> latest_;
+	std::uint64_t frames_;
+};
+
+} // namespace impl
+
+} // namespace mantra
+
+#endif // Header guard
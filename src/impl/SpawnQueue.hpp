@@ -0,0 +1,232 @@
+/*****
+ * Copyright Benoit Vey (2016)
+ *
+ * benoit.vey@etu.upmc.fr
+ *
+ * This software is governed by the CeCILL-B license under French law and
+ * abiding by the rules of distribution of free software.  You can  use, 
+ * modify and/ or redistribute the software under the terms of the CeCILL-B
+ * license as circulated by CEA, CNRS and INRIA at the following URL
+ * "http://www.cecill.info". 
+ *
+ * As a counterpart to the access to the source code and  rights to copy,
+ * modify and redistribute granted by the license, users are provided only
+ * with a limited warranty  and the software's author,  the holder of the
+ * economic rights,  and the successive licensors  have only  limited
+ * liability. 
+ *
+ * In this respect, the user's attention is drawn to the risks associated
+ * with loading,  using,  modifying and/or developing or reproducing the
+ * software by the user in light of its specific status of free software,
+ * that may mean  that it is complicated to manipulate,  and  that  also
+ * therefore means  that it is reserved for developers  and  experienced
+ * professionals having in-depth computer knowledge. Users are therefore
+ * encouraged to load and test the software's suitability as regards their
+ * requirements in conditions enabling the security of their systems and/or 
+ * data to be ensured and,  more generally, to use and operate it in the 
+ * same conditions as regards security. 
+ *
+ * The fact that you are presently reading this means that you have had
+ * knowledge of the CeCILL-B license and that you accept its terms.
+ *****/
+
+#ifndef MANTRA_IMPL_SPAWNQUEUE_HPP
+#define MANTRA_IMPL_SPAWNQUEUE_HPP
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "../MemoryResource.hpp"
+
+namespace mantra
+{
+
+namespace impl
+{
+
+// Entities staged by other threads, created with Args once the owner of the queue publishes them
+// Each producer fills its own batch, allocated from its own resource, then hands the whole batch over by
+// pushing it on a lock-free list. The owner takes the whole list with a single exchange, so producers and
+// owner never wait for one another. Batches are published in the order they were submitted, and the entities
+// of a batch in the order they were staged.
+template <typename... Args>
+class SpawnQueue
+{
+	struct Entry
+	{
+		// Creates the entity if args isn't null, then destroys the entry
+		void (*run)(Entry*, std::tuple<Args&...>*);
+		Entry* next;
+		std::size_t bytes;
+		std::size_t alignment;
+	};
+
+	template <typename F>
+	struct EntryOf : Entry
+	{
+		template <typename G>
+		explicit EntryOf(G&& g) : Entry{}, f{std::forward<G>(g)} {}
+
+		F f;
+	};
+
+	public:
+	class Batch
+	{
+		public:
+		explicit Batch(MemoryResource* resource) noexcept
+			: resource_{resource}, first_{nullptr}, last_{nullptr}, next_{nullptr}
+		{}
+
+		Batch(Batch const&) = delete;
+		Batch& operator=(Batch const&) = delete;
+
+		~Batch()
+		{
+			run_(nullptr);
+		}
+
+		bool empty() const noexcept
+		{
+			return !first_;
+		}
+
+		MemoryResource* resource() const noexcept
+		{
+			return resource_;
+		}
+
+		template <typename F>
+		void push(F&& f)
+		{
+			using Node = EntryOf<std::decay_t<F>>;
+
+			auto node = new (resource_->allocate(sizeof(Node), alignof(Node))) Node{std::forward<F>(f)};
+			node->run = [](Entry* entry, std::tuple<Args&...>* args)
+			{
+				auto self = static_cast<Node*>(entry);
+				if (args)
+					unpack_(self->f, *args, std::index_sequence_for<Args...>{});
+				self->~Node();
+			};
+			node->bytes = sizeof(Node);
+			node->alignment = alignof(Node);
+			(last_ ? last_->next : first_) = node;
+			last_ = node;
+		}
+
+		private:
+		friend class SpawnQueue;
+
+		template <typename F, std::size_t... Is>
+		static void unpack_(F& f, std::tuple<Args&...>& args, std::index_sequence<Is...>)
+		{
+			f(std::get<Is>(args)...);
+		}
+
+		void run_(std::tuple<Args&...>* args)
+		{
+			for (auto entry = first_; entry;)
+			{
+				auto next = entry->next;
+				auto bytes = entry->bytes;
+				auto alignment = entry->alignment;
+				entry->run(entry, args);
+				resource_->deallocate(entry, bytes, alignment);
+				entry = next;
+			}
+			first_ = last_ = nullptr;
+		}
+
+		MemoryResource* resource_;
+		Entry* first_;
+		Entry* last_;
+		Batch* next_;
+	};
+
+	SpawnQueue() noexcept : head_{nullptr} {}
+
+	SpawnQueue(SpawnQueue const&) = delete;
+	SpawnQueue& operator=(SpawnQueue const&) = delete;
+
+	// Unpublished batches are dropped
+	~SpawnQueue()
+	{
+		for (auto batch = head_.load(std::memory_order_acquire); batch;)
+		{
+			auto next = batch->next_;
+			destroy_(batch);
+			batch = next;
+		}
+	}
+
+	// Batches are allocated from the resource they allocate their entries from
+	static Batch* make_batch(MemoryResource* resource)
+	{
+		return new (resource->allocate(sizeof(Batch), alignof(Batch))) Batch{resource};
+	}
+
+	static void destroy_batch(Batch* batch) noexcept
+	{
+		destroy_(batch);
+	}
+
+	// Takes ownership of the batch, from any thread
+	void submit(Batch* batch) noexcept
+	{
+		assert(batch && "(Dev) Submitting no batch");
+
+		batch->next_ = head_.load(std::memory_order_relaxed);
+		while (!head_.compare_exchange_weak(batch->next_, batch, std::memory_order_release,
+		                                    std::memory_order_relaxed))
+		{}
+	}
+
+	// Creates the staged entities, from the owner's thread
+	void publish(Args&... args)
+	{
+		auto batch = head_.exchange(nullptr, std::memory_order_acquire);
+		if (!batch)
+			return;
+
+		// The list holds the newest batch first
+		Batch* oldest{nullptr};
+		while (batch)
+		{
+			auto next = batch->next_;
+			batch->next_ = oldest;
+			oldest = batch;
+			batch = next;
+		}
+
+		std::tuple<Args&...> refs{args...};
+		for (batch = oldest; batch;)
+		{
+			auto next = batch->next_;
+			batch->run_(&refs);
+			destroy_(batch);
+			batch = next;
+		}
+	}
+
+	private:
+	static void destroy_(Batch* batch) noexcept
+	{
+		auto resource = batch->resource_;
+		batch->~Batch();
+		resource->deallocate(batch, sizeof(Batch), alignof(Batch));
+	}
+
+	std::atomic<Batch*> head_;
+};
+
+} // namespace impl
+
+} // namespace mantra
+
+#endif // Header guard
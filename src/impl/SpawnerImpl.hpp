@@ -0,0 +1,118 @@
+/*****
+ * Copyright Benoit Vey (2016)
+ *
+ * benoit.vey@etu.upmc.fr
+ *
+ * This software is governed by the CeCILL-B license under French law and
+ * abiding by the rules of distribution of free software.  You can  use, 
+ * modify and/ or redistribute the software under the terms of the CeCILL-B
+ * license as circulated by CEA, CNRS and INRIA at the following URL
+ * "http://www.cecill.info". 
+ *
+ * As a counterpart to the access to the source code and  rights to copy,
+ * modify and redistribute granted by the license, users are provided only
+ * with a limited warranty  and the software's author,  the holder of the
+ * economic rights,  and the successive licensors  have only  limited
+ * liability. 
+ *
+ * In this respect, the user's attention is drawn to the risks associated
+ * with loading,  using,  modifying and/or developing or reproducing the
+ * software by the user in light of its specific status of free software,
+ * that may mean  that it is complicated to manipulate,  and  that  also
+ * therefore means  that it is reserved for developers  and  experienced
+ * professionals having in-depth computer knowledge. Users are therefore
+ * encouraged to load and test the software's suitability as regards their
+ * requirements in conditions enabling the security of their systems and/or 
+ * data to be ensured and,  more generally, to use and operate it in the 
+ * same conditions as regards security. 
+ *
+ * The fact that you are presently reading this means that you have had
+ * knowledge of the CeCILL-B license and that you accept its terms.
+ *****/
+
+#ifndef MANTRA_IMPL_SPAWNERIMPL_HPP
+#define MANTRA_IMPL_SPAWNERIMPL_HPP
+
+#include "../Spawner.hpp"
+
+namespace mantra
+{
+
+template <typename W>
+Spawner<W>::Spawner(typename WC::Spawns& queue, MemoryResource* resource) noexcept
+	: queue_{&queue}, resource_{resource}, batch_{nullptr}
+{
+	assert(resource_ && "No memory resource");
+}
+
+template <typename W>
+Spawner<W>::Spawner(Spawner&& mv) noexcept
+	: queue_{mv.queue_}, resource_{mv.resource_}, batch_{mv.batch_}
+{
+	mv.batch_ = nullptr;
+}
+
+template <typename W>
+Spawner<W>::~Spawner()
+{
+	submit();
+}
+
+template <typename W>
+template <typename... Ts>
+void Spawner<W>::create_entity()
+{
+	impl::validate_components(typename W::Components{}, impl::TypeList<Ts...>{});
+
+	staging_().push([](auto& data, auto& recorder)
+	{
+		auto index = data.acquire();
+		data.create(index, impl::TypeList<Ts...>{});
+		if (recorder.active())
+			recorder.template create<Ts...>(data, index);
+	});
+}
+
+template <typename W>
+template <typename... Ts, typename... Args>
+void Spawner<W>::create_entity(Args&&... args)
+{
+	impl::validate_components(typename W::Components{}, impl::TypeList<Ts...>{});
+
+	staging_().push([values = std::make_tuple(impl::own(std::forward<Args>(args))...)]
+	                (auto& data, auto& recorder) mutable
+	{
+		auto index = data.acquire();
+		impl::unpack([&data, index](auto&&... a)
+		{
+			data.create(index, impl::TypeList<Ts...>{}, std::forward<decltype(a)>(a)...);
+		}, values);
+		if (recorder.active())
+			recorder.template create<Ts...>(data, index);
+	});
+}
+
+template <typename W>
+void Spawner<W>::submit() noexcept
+{
+	if (!batch_)
+		return;
+	if (batch_->empty())
+		WC::Spawns::destroy_batch(batch_);
+	else
+		queue_->submit(batch_);
+	batch_ = nullptr;
+}
+
+// The batch is allocated on the first staged entity, since the world takes ownership of it on submission
+template <typename W>
+auto Spawner<W>::staging_() -> Batch&
+{
+	if (!batch_)
+		batch_ = WC::Spawns::make_batch(resource_);
+	return *batch_;
+}
+
+} // namespace mantra
+
+#endif // Header guard
@@ -0,0 +1,288 @@
+/*****
+ * Copyright Benoit Vey (2016)
+ *
+ * benoit.vey@etu.upmc.fr
+ *
+ * This software is governed by the CeCILL-B license under French law and
+ * abiding by the rules of distribution of free software.  You can  use, 
+ * modify and/ or redistribute the software under the terms of the CeCILL-B
+ * license as circulated by CEA, CNRS and INRIA at the following URL
+ * "http://www.cecill.info". 
+ *
+ * As a counterpart to the access to the source code and  rights to copy,
+ * modify and redistribute granted by the license, users are provided only
+ * with a limited warranty  and the software's author,  the holder of the
+ * economic rights,  and the successive licensors  have only  limited
+ * liability. 
+ *
+ * In this respect, the user's attention is drawn to the risks associated
+ * with loading,  using,  modifying and/or developing or reproducing the
+ * software by the user in light of its specific status of free software,
+ * that may mean  that it is complicated to manipulate,  and  that  also
+ * therefore means  that it is reserved for developers  and  experienced
+ * professionals having in-depth computer knowledge. Users are therefore
+ * encouraged to load and test the software's suitability as regards their
+ * requirements in conditions enabling the security of their systems and/or 
+ * data to be ensured and,  more generally, to use and operate it in the 
+ * same conditions as regards security. 
+ *
+ * The fact that you are presently reading this means that you have had
+ * knowledge of the CeCILL-B license and that you accept its terms.
+ *****/
+
+#ifndef MANTRA_IMPL_TIMINGWHEEL_HPP
+#define MANTRA_IMPL_TIMINGWHEEL_HPP
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "../MemoryResource.hpp"
+
+namespace mantra
+{
+
+namespace impl
+{
+
+// Actions scheduled a number of ticks ahead, fired with Args when their tick comes
+// Hierarchical timing wheel : level l has 64 slots of 64^l ticks each. An action goes in the lowest level
+// whose range covers its delay, in the slot of its tick. Whenever a level wraps around, the next slot of the
+// level above is emptied into the lower levels. Advancing a tick thus costs the actions due, plus the actions
+// cascaded, each action being cascaded at most once per level. Delays beyond the range of the last level are
+// cascaded again until they fit.
+template <typename... Args>
+class TimingWheel
+{
+	struct Timer;
+
+	using Clone = Timer* (*)(Timer const*, MemoryResource*);
+
+	struct Timer
+	{
+		// Fires the action if args isn't null, then destroys it
+		void (*run)(Timer*, std::tuple<Args&...>*);
+		Clone clone;
+		Timer* next;
+		std::uint64_t due;
+		std::size_t bytes;
+		std::size_t alignment;
+	};
+
+	template <typename F>
+	struct TimerOf : Timer
+	{
+		template <typename G>
+		explicit TimerOf(G&& g) : Timer{}, f{std::forward<G>(g)} {}
+
+		F f;
+	};
+
+	struct Slot
+	{
+		Timer* first;
+		Timer* last;
+	};
+
+	static std::size_t constexpr slot_bits{6};
+	static std::size_t constexpr slots{std::size_t{1} << slot_bits};
+	static std::size_t constexpr levels{4};
+
+	public:
+	explicit TimingWheel(MemoryResource* resource) noexcept
+		: resource_{resource}, wheels_{}, now_{0}, size_{0}
+	{}
+
+	TimingWheel(TimingWheel const&) = delete;
+	TimingWheel& operator=(TimingWheel const&) = delete;
+
+	TimingWheel(TimingWheel&& mv) noexcept
+		: resource_{mv.resource_}, wheels_{mv.wheels_}, now_{mv.now_}, size_{mv.size_}
+	{
+		mv.wheels_ = {};
+		mv.size_ = 0;
+	}
+
+	TimingWheel& operator=(TimingWheel&& mv) noexcept
+	{
+		clear_();
+		resource_ = mv.resource_;
+		wheels_ = mv.wheels_;
+		now_ = mv.now_;
+		size_ = mv.size_;
+		mv.wheels_ = {};
+		mv.size_ = 0;
+		return *this;
+	}
+
+	~TimingWheel()
+	{
+		clear_();
+	}
+
+	// The copy holds copies of the actions, in the same slots
+	TimingWheel fork() const
+	{
+		TimingWheel res{resource_};
+		res.now_ = now_;
+		for (std::size_t level{0}; level < levels; ++level)
+		{
+			for (std::size_t slot{0}; slot < slots; ++slot)
+			{
+				for (auto timer = wheels_[level][slot].first; timer; timer = timer->next)
+				{
+					append_(res.wheels_[level][slot], timer->clone(timer, resource_));
+				}
+			}
+		}
+		res.size_ = size_;
+		return res;
+	}
+
+	std::size_t size() const noexcept
+	{
+		return size_;
+	}
+
+	// f is called with Args on the ticks-th next call to advance
+	template <typename F>
+	void schedule(std::uint64_t ticks, F&& f)
+	{
+		using Node = TimerOf<std::decay_t<F>>;
+
+		static_assert(std::is_copy_constructible<std::decay_t<F>>{}, "(Dev) Actions are copied by fork");
+		assert(ticks > 0 && "(Dev) Actions are scheduled at least one tick ahead");
+
+		auto node = new (resource_->allocate(sizeof(Node), alignof(Node))) Node{std::forward<F>(f)};
+		node->run = [](Timer* timer, std::tuple<Args&...>* args)
+		{
+			auto self = static_cast<Node*>(timer);
+			if (args)
+				unpack_(self->f, *args, std::index_sequence_for<Args...>{});
+			self->~Node();
+		};
+		node->clone = clone_<Node>();
+		node->due = now_ + ticks;
+		node->bytes = sizeof(Node);
+		node->alignment = alignof(Node);
+		insert_(node);
+		++size_;
+	}
+
+	// Moves to the next tick and fires its actions, in a deterministic order
+	void advance(Args&... args)
+	{
+		++now_;
+		for (std::size_t level{1}; level < levels && !(now_ >> (slot_bits * (level - 1)) & (slots - 1)); ++level)
+			cascade_(level);
+
+		auto& slot = wheels_[0][now_ & (slots - 1)];
+		auto timer = slot.first;
+		slot = {nullptr, nullptr};
+		std::tuple<Args&...> refs{args...};
+		while (timer)
+		{
+			assert(timer->due == now_ && "(Dev) Action fired at the wrong tick");
+			auto next = timer->next;
+			--size_;
+			destroy_(timer, &refs);
+			timer = next;
+		}
+	}
+
+	private:
+	template <typename F, std::size_t... Is>
+	static void unpack_(F& f, std::tuple<Args&...>& args, std::index_sequence<Is...>)
+	{
+		f(std::get<Is>(args)...);
+	}
+
+	template <typename Node>
+	static Clone clone_() noexcept
+	{
+		return [](Timer const* timer, MemoryResource* resource) -> Timer*
+		{
+			auto self = static_cast<Node const*>(timer);
+			auto node = new (resource->allocate(sizeof(Node), alignof(Node))) Node{self->f};
+			node->run = self->run;
+			node->clone = self->clone;
+			node->due = self->due;
+			node->bytes = self->bytes;
+			node->alignment = self->alignment;
+			return node;
+		};
+	}
+
+	static void append_(Slot& slot, Timer* timer) noexcept
+	{
+		timer->next = nullptr;
+		(slot.last ? slot.last->next : slot.first) = timer;
+		slot.last = timer;
+	}
+
+	// Delays too long for the last level are placed as far as it reaches
+	void insert_(Timer* timer) noexcept
+	{
+		auto delay = timer->due - now_;
+		std::size_t level{0};
+		while (level + 1 < levels && delay >> (slot_bits * (level + 1)))
+			++level;
+		auto tick = delay >> (slot_bits * levels) ? now_ + (std::uint64_t{1} << (slot_bits * levels)) - 1 : timer->due;
+		append_(wheels_[level][tick >> (slot_bits * level) & (slots - 1)], timer);
+	}
+
+	void cascade_(std::size_t level) noexcept
+	{
+		auto& slot = wheels_[level][now_ >> (slot_bits * level) & (slots - 1)];
+		auto timer = slot.first;
+		slot = {nullptr, nullptr};
+		while (timer)
+		{
+			auto next = timer->next;
+			insert_(timer);
+			timer = next;
+		}
+	}
+
+	void destroy_(Timer* timer, std::tuple<Args&...>* args)
+	{
+		auto bytes = timer->bytes;
+		auto alignment = timer->alignment;
+		timer->run(timer, args);
+		resource_->deallocate(timer, bytes, alignment);
+	}
+
+	void clear_() noexcept
+	{
+		for (auto& wheel : wheels_)
+		{
+			for (auto& slot : wheel)
+			{
+				for (auto timer = slot.first; timer;)
+				{
+					auto next = timer->next;
+					destroy_(timer, nullptr);
+					timer = next;
+				}
+				slot = {nullptr, nullptr};
+			}
+		}
+		size_ = 0;
+	}
+
+	MemoryResource* resource_;
+	std::array<std::array<Slot, slots>, levels> wheels_;
+	std::uint64_t now_;
+	std::size_t size_;
+};
+
+} // namespace impl
+
+} // namespace mantra
+
+#endif // Header guard
@@ -0,0 +1,191 @@
+/*****
+ * Copyright Benoit Vey (2016)
+ *
+ * benoit.vey@etu.upmc.fr
+ *
+ * This software is governed by the CeCILL-B license under French law and
+ * abiding by the rules of distribution of free software.  You can  use, 
+ * modify and/ or redistribute the software under the terms of the CeCILL-B
+ * license as circulated by CEA, CNRS and INRIA at the following URL
+ * "http://www.cecill.info". 
+ *
+ * As a counterpart to the access to the source code and  rights to copy,
+ * modify and redistribute granted by the license, users are provided only
+ * with a limited warranty  and the software's author,  the holder of the
+ * economic rights,  and the successive licensors  have only  limited
+ * liability. 
+ *
+ * In this respect, the user's attention is drawn to the risks associated
+ * with loading,  using,  modifying and/or developing or reproducing the
+ * software by the user in light of its specific status of free software,
+ * that may mean  that it is complicated to manipulate,  and  that  also
+ * therefore means  that it is reserved for developers  and  experienced
+ * professionals having in-depth computer knowledge. Users are therefore
+ * encouraged to load and test the software's suitability as regards their
+ * requirements in conditions enabling the security of their systems and/or 
+ * data to be ensured and,  more generally, to use and operate it in the 
+ * same conditions as regards security. 
+ *
+ * The fact that you are presently reading this means that you have had
+ * knowledge of the CeCILL-B license and that you accept its terms.
+ *****/
+
+#ifndef MANTRA_IMPL_TRACE_HPP
+#define MANTRA_IMPL_TRACE_HPP
+
+#include <istream>
+#include <ostream>
+#include <string>
+#include <typeindex>
+
+#include "Allocator.hpp"
+#include "utility.hpp"
+
+namespace mantra
+{
+
+namespace impl
+{
+
+// Trace layout
+// Header : magic, version, number of components, number of systems
+// Then a sequence of operations. Each operation starts with an opcode byte, whose high bit is set if the
+// operation was issued by a system during an update. Integers are stored as LEB128 varints.
+//   frame
+//   create       entity, count, {component, payload}...
+//   destroy      entity
+//   add          entity, count, {component, payload}...
+//   remove       entity, count, {component}...
+//   message      system, message type, payload
+//   message_type message type, name
+//   skip         count, {system}...
+// skip precedes the frame of an update(dt) which doesn't update some systems.
+// The delayed changes fired by a frame are recorded before its marker, flagged if a system scheduled them.
+// Payloads are a size followed by the bytes of the object, or an empty size if the type isn't trivially
+// copyable.
+enum class TraceOp : unsigned char
+{
+	frame,
+	create,
+	destroy,
+	add,
+	remove,
+	message,
+	message_type,
+	end,
+	skip
+};
+
+unsigned char constexpr trace_system_flag{0x80};
+char constexpr trace_magic[]{'M', 'T', 'R', 'C'};
+unsigned char constexpr trace_version{2};
+
+template <typename T>
+using is_trace_copyable = std::integral_constant<bool,
+                                                 std::is_trivially_copyable<T>{} && !std::is_pointer<T>{}>;
+
+template <typename T, typename A, typename = void>
+struct can_receive : std::false_type {};
+
+template <typename T, typename A>
+struct can_receive<T, A, decltype((void)std::declval<T&>().receive(std::declval<A>()))> : std::true_type {};
+
+template <typename C, typename S>
+class TraceRecorder;
+
+template <typename... C, typename... S>
+class TraceRecorder<TypeList<C...>, TypeList<S...>>
+{
+	public:
+	explicit TraceRecorder(MemoryResource*) noexcept;
+
+	TraceRecorder(TraceRecorder const&) = delete;
+	TraceRecorder& operator=(TraceRecorder const&) = delete;
+
+	TraceRecorder(TraceRecorder&&) = default;
+	TraceRecorder& operator=(TraceRecorder&&) = default;
+
+	~TraceRecorder() = default;
+
+	void start(std::ostream&);
+	void stop();
+
+	bool active() const noexcept
+	{
+		return out_ != nullptr;
+	}
+
+	// Whether the operations are issued by systems
+	bool in_update() const noexcept
+	{
+		return in_update_;
+	}
+
+	void set_in_update(bool in_update) noexcept
+	{
+		in_update_ = in_update;
+	}
+
+	void skip(bool const*);
+	void begin_frame();
+	void end_frame() noexcept;
+
+	template <typename... Ts, typename R>
+	void create(R const&, std::size_t);
+	// Records the creation of the entity with every component it has, such as a migrated entity
+	template <typename R>
+	void create_owned(R const&, std::size_t);
+	void destroy(std::size_t);
+	template <typename... Ts, typename R>
+	void add(R const&, std::size_t);
+	template <typename... Ts>
+	void remove(std::size_t);
+	template <typename T, typename A>
+	void message(A const&);
+
+	private:
+	void op_(TraceOp);
+	void write_(std::size_t);
+	void write_(void const*, std::size_t);
+	template <typename T, typename R>
+	void component_(R const&, std::size_t, std::true_type);
+	template <typename T, typename R>
+	void component_(R const&, std::size_t, std::false_type);
+
+	std::ostream* out_;
+	Vector<std::type_index> messages_;
+	bool in_update_;
+};
+
+// Reading past the end of the stream or an invalid varint sets the failbit of the stream, after which the
+// reader returns end operations, zero values and empty payloads
+class TraceReader
+{
+	public:
+	explicit TraceReader(std::istream&);
+
+	bool header(std::size_t, std::size_t);
+
+	TraceOp op(bool&);
+	std::size_t read();
+	std::string const& payload();
+
+	explicit operator bool() const noexcept
+	{
+		return !in_.fail();
+	}
+
+	void fail();
+
+	private:
+	std::istream& in_;
+	std::string payload_;
+};
+
+} // namespace impl
+
+} // namespace mantra
+
+#include "TraceImpl.hpp"
+
+#endif // Header guard
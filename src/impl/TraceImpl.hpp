@@ -0,0 +1,303 @@
+/*****
+ * Copyright Benoit Vey (2016)
+ *
+ * benoit.vey@etu.upmc.fr
+ *
+ * This software is governed by the CeCILL-B license under French law and
+ * abiding by the rules of distribution of free software.  You can  use, 
+ * modify and/ or redistribute the software under the terms of the CeCILL-B
+ * license as circulated by CEA, CNRS and INRIA at the following URL
+ * "http://www.cecill.info". 
+ *
+ * As a counterpart to the access to the source code and  rights to copy,
+ * modify and redistribute granted by the license, users are provided only
+ * with a limited warranty  and the software's author,  the holder of the
+ * economic rights,  and the successive licensors  have only  limited
+ * liability. 
+ *
+ * In this respect, the user's attention is drawn to the risks associated
+ * with loading,  using,  modifying and/or developing or reproducing the
+ * software by the user in light of its specific status of free software,
+ * that may mean  that it is complicated to manipulate,  and  that  also
+ * therefore means  that it is reserved for developers  and  experienced
+ * professionals having in-depth computer knowledge. Users are therefore
+ * encouraged to load and test the software's suitability as regards their
+ * requirements in conditions enabling the security of their systems and/or 
+ * data to be ensured and,  more generally, to use and operate it in the 
+ * same conditions as regards security. 
+ *
+ * The fact that you are presently reading this means that you have had
+ * knowledge of the CeCILL-B license and that you accept its terms.
+ *****/
+
+#ifndef MANTRA_IMPL_TRACEIMPL_HPP
+#define MANTRA_IMPL_TRACEIMPL_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <limits>
+#include <typeinfo>
+
+#include "Trace.hpp"
+
+namespace mantra
+{
+
+namespace impl
+{
+
+template <typename... C, typename... S>
+TraceRecorder<TypeList<C...>, TypeList<S...>>::TraceRecorder(MemoryResource* resource) noexcept
+	: out_{nullptr}, messages_{resource}, in_update_{false}
+{}
+
+template <typename... C, typename... S>
+void TraceRecorder<TypeList<C...>, TypeList<S...>>::start(std::ostream& out)
+{
+	assert(!out_ && "Already recording");
+
+	out_ = &out;
+	messages_.clear();
+	out_->write(trace_magic, sizeof(trace_magic));
+	out_->put(static_cast<char>(trace_version));
+	write_(sizeof...(C));
+	write_(sizeof...(S));
+}
+
+template <typename... C, typename... S>
+void TraceRecorder<TypeList<C...>, TypeList<S...>>::stop()
+{
+	assert(out_ && "Not recording");
+
+	op_(TraceOp::end);
+	out_->flush();
+	out_ = nullptr;
+}
+
+// Records the systems which aren't due among the sizeof...(S) flags of due
+template <typename... C, typename... S>
+void TraceRecorder<TypeList<C...>, TypeList<S...>>::skip(bool const* due)
+{
+	auto skipped = static_cast<std::size_t>(std::count(due, due + sizeof...(S), false));
+	if (!out_ || !skipped)
+		return;
+
+	op_(TraceOp::skip);
+	write_(skipped);
+	for (std::size_t i{0}; i < sizeof...(S); ++i)
+	{
+		if (!due[i])
+			write_(i);
+	}
+}
+
+template <typename... C, typename... S>
+void TraceRecorder<TypeList<C...>, TypeList<S...>>::begin_frame()
+{
+	if (out_)
+		op_(TraceOp::frame);
+	in_update_ = true;
+}
+
+template <typename... C, typename... S>
+void TraceRecorder<TypeList<C...>, TypeList<S...>>::end_frame() noexcept
+{
+	in_update_ = false;
+}
+
+template <typename... C, typename... S>
+template <typename... Ts, typename R>
+void TraceRecorder<TypeList<C...>, TypeList<S...>>::create(R const& registry, std::size_t index)
+{
+	op_(TraceOp::create);
+	write_(index);
+	write_(sizeof...(Ts));
+	(void)expand{(component_<Ts>(registry, index, is_trace_copyable<Ts>{}), 0)...};
+}
+
+template <typename... C, typename... S>
+template <typename R>
+void TraceRecorder<TypeList<C...>, TypeList<S...>>::create_owned(R const& registry, std::size_t index)
+{
+	std::size_t count{0};
+	(void)expand{(count += registry.template has_components<C>(index), 0)...};
+	op_(TraceOp::create);
+	write_(index);
+	write_(count);
+	(void)expand
+	{(
+		registry.template has_components<C>(index) ? component_<C>(registry, index, is_trace_copyable<C>{}) : (void)0, 0
+	)...};
+}
+
+template <typename... C, typename... S>
+void TraceRecorder<TypeList<C...>, TypeList<S...>>::destroy(std::size_t index)
+{
+	op_(TraceOp::destroy);
+	write_(index);
+}
+
+template <typename... C, typename... S>
+template <typename... Ts, typename R>
+void TraceRecorder<TypeList<C...>, TypeList<S...>>::add(R const& registry, std::size_t index)
+{
+	op_(TraceOp::add);
+	write_(index);
+	write_(sizeof...(Ts));
+	(void)expand{(component_<Ts>(registry, index, is_trace_copyable<Ts>{}), 0)...};
+}
+
+template <typename... C, typename... S>
+template <typename... Ts>
+void TraceRecorder<TypeList<C...>, TypeList<S...>>::remove(std::size_t index)
+{
+	op_(TraceOp::remove);
+	write_(index);
+	write_(sizeof...(Ts));
+	(void)expand{(write_(index_of<Ts, C...>()), 0)...};
+}
+
+template <typename... C, typename... S>
+template <typename T, typename A>
+void TraceRecorder<TypeList<C...>, TypeList<S...>>::message(A const& arg)
+{
+	std::type_index type{typeid(A)};
+	auto it = std::find(std::begin(messages_), std::end(messages_), type);
+	auto id = static_cast<std::size_t>(it - std::begin(messages_));
+	if (it == std::end(messages_))
+	{
+		messages_.emplace_back(type);
+		auto name = type.name();
+		auto size = std::strlen(name);
+		op_(TraceOp::message_type);
+		write_(id);
+		write_(size);
+		write_(name, size);
+	}
+
+	op_(TraceOp::message);
+	write_(index_of<T, S...>());
+	write_(id);
+	if (is_trace_copyable<A>{})
+	{
+		write_(sizeof(A));
+		write_(&arg, sizeof(A));
+	}
+	else
+		write_(0);
+}
+
+template <typename... C, typename... S>
+void TraceRecorder<TypeList<C...>, TypeList<S...>>::op_(TraceOp op)
+{
+	auto byte = static_cast<unsigned char>(op);
+	if (in_update_)
+		byte |= trace_system_flag;
+	out_->put(static_cast<char>(byte));
+}
+
+template <typename... C, typename... S>
+void TraceRecorder<TypeList<C...>, TypeList<S...>>::write_(std::size_t value)
+{
+	do
+	{
+		auto byte = static_cast<unsigned char>(value & 0x7f);
+		value >>= 7;
+		if (value)
+			byte |= 0x80;
+		out_->put(static_cast<char>(byte));
+	} while (value);
+}
+
+template <typename... C, typename... S>
+void TraceRecorder<TypeList<C...>, TypeList<S...>>::write_(void const* data, std::size_t size)
+{
+	out_->write(static_cast<char const*>(data), static_cast<std::streamsize>(size));
+}
+
+template <typename... C, typename... S>
+template <typename T, typename R>
+void TraceRecorder<TypeList<C...>, TypeList<S...>>::component_(R const& registry, std::size_t index,
+                                                               std::true_type)
+{
+	write_(index_of<T, C...>());
+	write_(sizeof(T));
+	T const value = registry.template get_component<T>(index);
+	write_(&value, sizeof(T));
+}
+
+template <typename... C, typename... S>
+template <typename T, typename R>
+void TraceRecorder<TypeList<C...>, TypeList<S...>>::component_(R const&, std::size_t, std::false_type)
+{
+	write_(index_of<T, C...>());
+	write_(0);
+}
+
+inline TraceReader::TraceReader(std::istream& in)
+	: in_{in}, payload_{}
+{}
+
+inline bool TraceReader::header(std::size_t components, std::size_t systems)
+{
+	char magic[sizeof(trace_magic)];
+	in_.read(magic, sizeof(magic));
+	if (!in_ || !std::equal(std::begin(magic), std::end(magic), std::begin(trace_magic)))
+		return false;
+	auto version = in_.get();
+	if (version < 1 || version > static_cast<int>(trace_version))
+		return false;
+	return read() == components && read() == systems;
+}
+
+inline TraceOp TraceReader::op(bool& from_system)
+{
+	auto byte = in_.get();
+	if (byte == std::istream::traits_type::eof())
+		return TraceOp::end;
+	from_system = (byte & trace_system_flag) != 0;
+	return static_cast<TraceOp>(byte & ~trace_system_flag);
+}
+
+inline std::size_t TraceReader::read()
+{
+	std::size_t value{0};
+	for (unsigned shift{0}; shift < std::numeric_limits<std::size_t>::digits; shift += 7)
+	{
+		auto byte = in_.get();
+		if (byte == std::istream::traits_type::eof())
+			return 0;
+		value |= static_cast<std::size_t>(byte & 0x7f) << shift;
+		if (!(byte & 0x80))
+			return value;
+	}
+	fail();
+	return 0;
+}
+
+// The payload is read by blocks, so that a corrupted size can't allocate more than what the stream holds
+inline std::string const& TraceReader::payload()
+{
+	auto size = read();
+	payload_.clear();
+	while (*this && payload_.size() < size)
+	{
+		char block[256];
+		auto count = std::min(size - payload_.size(), sizeof(block));
+		in_.read(block, static_cast<std::streamsize>(count));
+		payload_.append(block, static_cast<std::size_t>(in_.gcount()));
+	}
+	return payload_;
+}
+
+inline void TraceReader::fail()
+{
+	in_.setstate(std::ios::failbit);
+}
+
+} // namespace impl
+
+} // namespace mantra
+
+#endif // Header guard
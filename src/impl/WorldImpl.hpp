@@ -34,6 +34,10 @@
 #ifndef MANTRA_IMPL_WORLDIMPL_HPP
 #define MANTRA_IMPL_WORLDIMPL_HPP
 
+#include <cstring>
+#include <string>
+#include <typeinfo>
+
 #include "../World.hpp"
 
 #include "../WorldView.hpp"
@@ -41,126 +45,635 @@
 namespace mantra
 {
 
-template <typename... C, typename... S>
-World<CL<C...>, SL<S...>>::World()
-	: entities_{}, components_{}, systems_{}, free_caches_{}
+template <typename... C, typename... S, typename... R, typename I>
+World<CL<C...>, SL<S...>, RL<R...>, I>::World()
+	: World{std::allocator_arg, *default_resource()}
+{}
+
+template <typename... C, typename... S, typename... R, typename I>
+template <typename... Args>
+World<CL<C...>, SL<S...>, RL<R...>, I>::World(Args&&... args)
+	: World{std::allocator_arg, *default_resource(), std::forward<Args>(args)...}
+{}
+
+template <typename... C, typename... S, typename... R, typename I>
+template <typename MR>
+World<CL<C...>, SL<S...>, RL<R...>, I>::World(std::allocator_arg_t, MR& resource)
+	: data_{&resource}, systems_{}, resources_{}, recorder_{&resource}, timers_{&resource},
+	  spawns_{std::make_unique<Spawns>()}, snapshots_{&resource}, history_{&resource}, scheduler_{nullptr},
+	  deterministic_{false}, cursors_{}, rates_{}, due_{}
 {
-	(void)impl::expand{(impl::validate_components(impl::TypeList<C...>{}, typename S::Components{}), 0)...};
+	static_assert(std::is_base_of<MemoryResource, MR>{}, "Invalid memory resource type");
+	(void)impl::expand{(impl::validate_system(impl::TypeList<C...>{}, impl::TypeList<R...>{},
+	                                          typename S::Components{}, typename impl::TermsOf<S>::type{}), 0)...};
 }
 
-template <typename... C, typename... S>
-template <typename... Args>
-World<CL<C...>, SL<S...>>::World(Args&&... args)
-	: entities_{}, components_{}, systems_{impl::piecewise_construct, std::forward<Args>(args)...}, free_caches_{}
+template <typename... C, typename... S, typename... R, typename I>
+template <typename MR, typename... Args>
+World<CL<C...>, SL<S...>, RL<R...>, I>::World(std::allocator_arg_t, MR& resource, Args&&... args)
+	: data_{&resource}, systems_{impl::piecewise_construct, std::forward<Args>(args)...}, resources_{},
+	  recorder_{&resource}, timers_{&resource}, spawns_{std::make_unique<Spawns>()}, snapshots_{&resource},
+	  history_{&resource}, scheduler_{nullptr}, deterministic_{false}, cursors_{}, rates_{}, due_{}
 {
-	(void)impl::expand{(impl::validate_components(impl::TypeList<C...>{}, typename S::Components{}), 0)...};
+	static_assert(std::is_base_of<MemoryResource, MR>{}, "Invalid memory resource type");
+	(void)impl::expand{(impl::validate_system(impl::TypeList<C...>{}, impl::TypeList<R...>{},
+	                                          typename S::Components{}, typename impl::TermsOf<S>::type{}), 0)...};
 }
 
-template <typename... C, typename... S>
-World<CL<C...>, SL<S...>>::~World()
+template <typename... C, typename... S, typename... R, typename I>
+World<CL<C...>, SL<S...>, RL<R...>, I>::World(Data&& data, impl::Tuple<S...> const& systems,
+                                              impl::Tuple<R...> const& resources)
+	: data_{std::move(data)}, systems_{systems}, resources_{resources}, recorder_{data_.resource()},
+	  timers_{data_.resource()}, spawns_{std::make_unique<Spawns>()}, snapshots_{data_.resource()},
+	  history_{data_.resource()}, scheduler_{nullptr}, deterministic_{false}, cursors_{}, rates_{}, due_{}
+{}
+
+template <typename... C, typename... S, typename... R, typename I>
+auto World<CL<C...>, SL<S...>, RL<R...>, I>::fork() const -> World
 {
-	entities_.clear();
+	static_assert(impl::conjunction<std::is_copy_constructible<S>...>{},
+	              "Forked systems must be copy constructible");
+	static_assert(impl::conjunction<std::is_copy_constructible<R>...>{},
+	              "Forked resources must be copy constructible");
+
+	World res{data_.fork(), systems_, resources_};
+	res.scheduler_ = scheduler_;
+	res.deterministic_ = deterministic_;
+	res.cursors_ = cursors_;
+	res.rates_ = rates_;
+	res.timers_ = timers_.fork();
+	return res;
 }
 
-template <typename... C, typename... S>
+template <typename... C, typename... S, typename... R, typename I>
 template <typename... Ts>
-auto World<CL<C...>, SL<S...>>::create_entity() -> EntityHandle<Self, void, C...>
+auto World<CL<C...>, SL<S...>, RL<R...>, I>::create_entity() -> EntityHandle<Self, void, C...>
 {
 	impl::TypeList<Ts...> comp_types{};
 	impl::validate_components(impl::TypeList<C...>{}, comp_types);
 
-	auto it = std::begin(entities_);
-	if (!free_caches_[0].empty())
-	{
-		auto index = free_caches_[0].back();
-		free_caches_[0].pop_back();
-		it += static_cast<std::ptrdiff_t>(index);
-	}
-	else
+	auto index = data_.acquire();
+	data_.create(index, comp_types);
+	if (recorder_.active())
+		recorder_.template create<Ts...>(data_, index);
+	return {data_, recorder_, timers_, index};
+}
+
+template <typename... C, typename... S, typename... R, typename I>
+template <typename... Ts, typename... Args>
+auto World<CL<C...>, SL<S...>, RL<R...>, I>::create_entity(Args&&... args) -> EntityHandle<Self, void, C...>
+{
+	impl::TypeList<Ts...> comp_types{};
+	impl::validate_components(impl::TypeList<C...>{}, comp_types);
+
+	auto index = data_.acquire();
+	data_.create(index, comp_types, std::forward<Args>(args)...);
+	if (recorder_.active())
+		recorder_.template create<Ts...>(data_, index);
+	return {data_, recorder_, timers_, index};
+}
+
+template <typename... C, typename... S, typename... R, typename I>
+auto World<CL<C...>, SL<S...>, RL<R...>, I>::spawner(MemoryResource* resource) noexcept -> Spawner<Self>
+{
+	return {*spawns_, resource};
+}
+
+// The rings are owned through type-erased pointers, since the world doesn't know their component types
+template <typename... C, typename... S, typename... R, typename I>
+template <typename... Ts>
+SnapshotReader<Ts...> World<CL<C...>, SL<S...>, RL<R...>, I>::snapshots(std::size_t buffers)
+{
+	using Ring = impl::SnapshotRing<Ts...>;
+
+	impl::validate_components(impl::TypeList<C...>{}, impl::TypeList<Ts...>{});
+	static_assert(sizeof...(Ts) > 0, "No component types supplied");
+	static_assert(impl::conjunction<std::integral_constant<bool, std::is_copy_constructible<Ts>{} &&
+	                                                            !std::is_pointer<Ts>{}>...>{},
+	              "Snapshot components must be copy constructible and not be pointers");
+
+	std::unique_ptr<void, void (*)(void*)> ring{new Ring{data_.resource(), buffers},
+	                                            [](void* p){delete static_cast<Ring*>(p);}};
+	SnapshotReader<Ts...> res{*static_cast<Ring*>(ring.get())};
+	snapshots_.push_back({std::move(ring), [](void* p, Data const& data){static_cast<Ring*>(p)->capture(data);}});
+	return res;
+}
+
+template <typename... C, typename... S, typename... R, typename I>
+void World<CL<C...>, SL<S...>, RL<R...>, I>::update()
+{
+	due_.fill(true);
+	frame_();
+}
+
+// The time elapsed beyond the interval is kept, so that a system keeps its phase. The rates are advanced on a
+// copy, so that the history saves them as they were before the frame.
+template <typename... C, typename... S, typename... R, typename I>
+void World<CL<C...>, SL<S...>, RL<R...>, I>::update(double dt)
+{
+	assert(dt >= 0 && "Negative time step");
+
+	auto rates = rates_;
+	for (std::size_t i{0}; i < sizeof...(S); ++i)
 	{
-		it = std::find_if(std::begin(entities_), std::end(entities_),
-		                  [](auto const& e){return !e;});
-		if (it == std::end(entities_))
+		auto& rate = rates[i];
+		due_[i] = true;
+		if (rate.interval > 0)
 		{
-			entities_.emplace_back(components_, free_caches_, entities_.size());
-			it = std::end(entities_) - 1;
+			rate.elapsed += dt;
+			due_[i] = rate.elapsed >= rate.interval;
+			if (due_[i])
+				rate.elapsed = std::fmod(rate.elapsed, rate.interval);
 		}
 	}
-	it->create(comp_types);
-	return {entities_, static_cast<std::size_t>(it - std::begin(entities_))};
+	recorder_.skip(due_.data());
+	frame_();
+	rates_ = rates;
 }
 
-template <typename... C, typename... S>
-template <typename... Ts, typename... Args>
-auto World<CL<C...>, SL<S...>>::create_entity(Args&&... args) -> EntityHandle<Self, void, C...>
+template <typename... C, typename... S, typename... R, typename I>
+template <typename T, typename A>
+void World<CL<C...>, SL<S...>, RL<R...>, I>::message(A&& arg)
 {
-	impl::TypeList<Ts...> comp_types{};
-	impl::validate_components(impl::TypeList<C...>{}, comp_types);
+	if (recorder_.active())
+		recorder_.template message<T>(arg);
+	impl::get<T>(systems_).receive(std::forward<A>(arg));
+}
+
+template <typename... C, typename... S, typename... R, typename I>
+void World<CL<C...>, SL<S...>, RL<R...>, I>::reserve_entities(std::size_t n)
+{
+	data_.reserve(n);
+}
+
+template <typename... C, typename... S, typename... R, typename I>
+template <typename T>
+void World<CL<C...>, SL<S...>, RL<R...>, I>::reserve_components(std::size_t n)
+{
+	impl::validate_component<T>(impl::TypeList<C...>{});
+
+	data_.template pool<T>().reserve(n);
+}
+
+template <typename... C, typename... S, typename... R, typename I>
+void World<CL<C...>, SL<S...>, RL<R...>, I>::keep_history(std::size_t frames)
+{
+	history_.resize(frames);
+}
+
+template <typename... C, typename... S, typename... R, typename I>
+std::size_t World<CL<C...>, SL<S...>, RL<R...>, I>::saved_frames() const noexcept
+{
+	return history_.size();
+}
 
-	auto it = std::begin(entities_);
-	if (!free_caches_[0].empty())
+// The live state is replaced by the restored one, which releases the pages written since it was saved
+template <typename... C, typename... S, typename... R, typename I>
+void World<CL<C...>, SL<S...>, RL<R...>, I>::rewind(std::size_t frames)
+{
+	assert(frames <= history_.size() && "Not enough saved frames");
+	assert(!recorder_.active() && "Can't rewind a recording world");
+
+	if (!frames)
+		return;
+	for (; frames > 1; --frames)
+		history_.pop();
+	auto frame = history_.pop();
+	data_ = std::move(frame.data);
+	resources_ = std::move(frame.resources);
+	timers_ = std::move(frame.timers);
+	cursors_ = frame.cursors;
+	rates_ = frame.rates;
+}
+
+template <typename... C, typename... S, typename... R, typename I>
+template <typename T>
+T& World<CL<C...>, SL<S...>, RL<R...>, I>::resource() noexcept
+{
+	impl::validate_resource<T>(impl::TypeList<R...>{});
+
+	return impl::get<T>(resources_);
+}
+
+template <typename... C, typename... S, typename... R, typename I>
+template <typename T>
+T const& World<CL<C...>, SL<S...>, RL<R...>, I>::resource() const noexcept
+{
+	impl::validate_resource<T>(impl::TypeList<R...>{});
+
+	return impl::get<T>(resources_);
+}
+
+template <typename... C, typename... S, typename... R, typename I>
+void World<CL<C...>, SL<S...>, RL<R...>, I>::set_scheduler(Scheduler* scheduler) noexcept
+{
+	scheduler_ = scheduler;
+}
+
+template <typename... C, typename... S, typename... R, typename I>
+Scheduler* World<CL<C...>, SL<S...>, RL<R...>, I>::scheduler() const noexcept
+{
+	return scheduler_;
+}
+
+template <typename... C, typename... S, typename... R, typename I>
+void World<CL<C...>, SL<S...>, RL<R...>, I>::set_deterministic(bool deterministic) noexcept
+{
+	deterministic_ = deterministic;
+}
+
+template <typename... C, typename... S, typename... R, typename I>
+bool World<CL<C...>, SL<S...>, RL<R...>, I>::deterministic() const noexcept
+{
+	return deterministic_;
+}
+
+template <typename... C, typename... S, typename... R, typename I>
+template <typename T>
+void World<CL<C...>, SL<S...>, RL<R...>, I>::set_interval(double interval, bool staggered) noexcept
+{
+	static_assert(impl::is_any<T, S...>{}, "Invalid system type");
+	assert(interval >= 0 && "Negative interval");
+
+	rates_[impl::index_of<T, S...>()] = {interval, 0, staggered};
+	if (staggered)
+		stagger_(interval);
+}
+
+template <typename... C, typename... S, typename... R, typename I>
+template <typename T>
+double World<CL<C...>, SL<S...>, RL<R...>, I>::interval() const noexcept
+{
+	static_assert(impl::is_any<T, S...>{}, "Invalid system type");
+
+	return rates_[impl::index_of<T, S...>()].interval;
+}
+
+template <typename... C, typename... S, typename... R, typename I>
+MemoryResource* World<CL<C...>, SL<S...>, RL<R...>, I>::memory_resource() const noexcept
+{
+	return data_.resource();
+}
+
+template <typename... C, typename... S, typename... R, typename I>
+void World<CL<C...>, SL<S...>, RL<R...>, I>::record(std::ostream& out)
+{
+	recorder_.start(out);
+}
+
+template <typename... C, typename... S, typename... R, typename I>
+void World<CL<C...>, SL<S...>, RL<R...>, I>::stop_recording()
+{
+	recorder_.stop();
+}
+
+// Every value read from the trace is checked before it is used. On the first invalid or missing one, the failbit of
+// the stream is set and the replay stops, the operations before it staying applied.
+template <typename... C, typename... S, typename... R, typename I>
+template <typename... M>
+std::size_t World<CL<C...>, SL<S...>, RL<R...>, I>::replay(std::istream& in, ReplayMode mode)
+{
+	std::array<AddFn, sizeof...(C)> const adders{{static_cast<AddFn>(&replay_add_<C>)...}};
+	std::array<RemoveFn, sizeof...(C)> const removers{{&replay_remove_<C>...}};
+	std::array<std::array<MessageFn, sizeof...(M)>, sizeof...(S)> const receivers{{message_fns_<S, M...>()...}};
+	std::array<char const*, sizeof...(M)> const names{{typeid(M).name()...}};
+
+	impl::TraceReader reader{in};
+	if (!reader.header(sizeof...(C), sizeof...(S)))
 	{
-		auto index = free_caches_[0].back();
-		free_caches_[0].pop_back();
-		it += static_cast<std::ptrdiff_t>(index);
+		reader.fail();
+		return 0;
 	}
-	else
+
+	auto alive = [this](std::size_t index){return index < data_.size() && data_[index];};
+	impl::Vector<std::size_t> message_types{data_.resource()};
+	std::size_t frames{0};
+	due_.fill(true);
+	bool from_system{false};
+	for (auto op = reader.op(from_system); op != impl::TraceOp::end; op = reader.op(from_system))
 	{
-		it = std::find_if(std::begin(entities_), std::end(entities_),
-		                  [](auto const& e){return !e;});
-		if (it == std::end(entities_))
+		auto apply = mode == ReplayMode::operations || !from_system;
+		auto valid = true;
+		switch (op)
 		{
-			entities_.emplace_back(components_, free_caches_, entities_.size());
-			it = std::end(entities_) - 1;
+			case impl::TraceOp::frame:
+				++frames;
+				if (mode == ReplayMode::simulation)
+					frame_();
+				due_.fill(true);
+				break;
+			case impl::TraceOp::skip:
+			{
+				auto count = reader.read();
+				for (std::size_t i{0}; valid && i < count; ++i)
+				{
+					auto system = reader.read();
+					valid = reader && system < sizeof...(S);
+					if (valid)
+						due_[system] = false;
+				}
+				break;
+			}
+			case impl::TraceOp::create:
+			case impl::TraceOp::add:
+			{
+				auto index = reader.read();
+				auto count = reader.read();
+				auto create = apply && op == impl::TraceOp::create;
+				valid = reader && (create ? index == data_.next_index() : !apply || alive(index));
+				if (valid && create)
+					data_.create(data_.acquire(), impl::TypeList<>{});
+				for (std::size_t i{0}; valid && i < count; ++i)
+				{
+					auto comp = reader.read();
+					auto const& payload = reader.payload();
+					valid = reader && comp < sizeof...(C) && (!apply || adders[comp](data_, index, payload));
+				}
+				break;
+			}
+			case impl::TraceOp::destroy:
+			{
+				auto index = reader.read();
+				valid = reader && (!apply || alive(index));
+				if (valid && apply)
+					data_.destroy(index);
+				break;
+			}
+			case impl::TraceOp::remove:
+			{
+				auto index = reader.read();
+				auto count = reader.read();
+				valid = reader && (!apply || alive(index));
+				for (std::size_t i{0}; valid && i < count; ++i)
+				{
+					auto comp = reader.read();
+					valid = reader && comp < sizeof...(C) && (!apply || removers[comp](data_, index));
+				}
+				break;
+			}
+			case impl::TraceOp::message:
+			{
+				auto system = reader.read();
+				auto id = reader.read();
+				auto const& payload = reader.payload();
+				valid = reader && system < sizeof...(S) && id < message_types.size();
+				if (!valid)
+					break;
+				auto type = message_types[id];
+				if (apply && type < sizeof...(M) && receivers[system][type])
+					valid = receivers[system][type](*this, payload);
+				break;
+			}
+			case impl::TraceOp::message_type:
+			{
+				auto id = reader.read();
+				auto const& name = reader.payload();
+				// Types are numbered in order of first use
+				valid = reader && id <= message_types.size();
+				if (!valid)
+					break;
+				auto it = std::find_if(std::begin(names), std::end(names),
+				                       [&name](auto n){return name == n;});
+				message_types.resize(std::max(message_types.size(), id + 1));
+				message_types[id] = static_cast<std::size_t>(it - std::begin(names));
+				break;
+			}
+			default:
+				valid = false;
+				break;
+		}
+		if (!valid)
+		{
+			reader.fail();
+			return frames;
 		}
 	}
-	it->create(comp_types, std::forward<Args>(args)...);
-	return {entities_, static_cast<std::size_t>(it - std::begin(entities_))};
+	return frames;
 }
 
-template <typename... C, typename... S>
-void World<CL<C...>, SL<S...>>::update()
+// Creates the spawned entities, fires the delayed changes due, then updates the due systems
+// The spawned entities are created before the state is saved, so that rewinding doesn't lose them. The changes
+// are fired before the frame marker, so that a simulation replay applies the ones scheduled outside
+// the systems before the wheel fires the others again.
+template <typename... C, typename... S, typename... R, typename I>
+void World<CL<C...>, SL<S...>, RL<R...>, I>::frame_()
 {
-	(void)impl::expand
-	{(
-		update_<S, typename S::Primary>(typename S::Components{}), 0
-	)...};
+	spawns_->publish(data_, recorder_);
+	if (history_.capacity())
+		history_.push(Frame{data_.fork(), impl::as_const(resources_), timers_.fork(), cursors_, rates_});
+	timers_.advance(data_, recorder_);
+	recorder_.begin_frame();
+	if (deterministic_ || (scheduler_ && scheduler_->workers()))
+	{
+		update_stages_(Schedule{});
+	}
+	else
+	{
+		(void)impl::expand
+		{(
+			update_<S, typename S::Primary>(typename S::Components{}, nullptr), 0
+		)...};
+	}
+	data_.publish();
+	recorder_.end_frame();
+	for (auto& snapshots : snapshots_)
+		snapshots.capture(snapshots.ring.get(), data_);
 }
 
-template <typename... C, typename... S>
-template <typename T, typename A>
-void World<CL<C...>, SL<S...>>::message(A&& arg)
+// The entity is recorded as destroyed here and created in the target, so that the trace of each world replays
+// on its own. remap sees both handles before the entity is destroyed here.
+template <typename... C, typename... S, typename... R, typename I>
+template <typename F>
+void World<CL<C...>, SL<S...>, RL<R...>, I>::migrate_(std::size_t index, Self& target, F& remap)
 {
-	impl::get<T>(systems_).receive(std::forward<A>(arg));
+	auto res = target.data_.acquire();
+	data_.move_to(index, target.data_, res);
+	if (target.recorder_.active())
+		target.recorder_.create_owned(target.data_, res);
+
+	remap(EntityHandle<Self, void, C...>{data_, recorder_, timers_, index},
+	      EntityHandle<Self, void, C...>{target.data_, target.recorder_, target.timers_, res});
+
+	if (recorder_.active())
+		recorder_.destroy(index);
+	data_.destroy(index);
+}
+
+// The k-th of n staggered systems of the interval starts with k / n of the interval elapsed, so that they come
+// due at evenly spaced times
+template <typename... C, typename... S, typename... R, typename I>
+void World<CL<C...>, SL<S...>, RL<R...>, I>::stagger_(double interval) noexcept
+{
+	auto same = [interval](Rate const& rate){return rate.staggered && rate.interval == interval;};
+	auto n = std::count_if(std::begin(rates_), std::end(rates_), same);
+	std::size_t k{0};
+	for (auto& rate : rates_)
+	{
+		if (same(rate))
+			rate.elapsed = interval * static_cast<double>(k++) / static_cast<double>(n);
+	}
 }
 
-template <typename... C, typename... S>
-void World<CL<C...>, SL<S...>>::reserve_entities(std::size_t n)
+template <typename... C, typename... S, typename... R, typename I>
+template <typename... St>
+void World<CL<C...>, SL<S...>, RL<R...>, I>::update_stages_(impl::TypeList<St...>)
 {
-	if (free_caches_[0].size() < n)
-		entities_.reserve(entities_.size() + n - free_caches_[0].size());
+	(void)impl::expand{0, (update_stage_(St{}), 0)...};
 }
 
-template <typename... C, typename... S>
+// A system alone in its stage makes its structural changes immediately, like in a sequential update
+template <typename... C, typename... S, typename... R, typename I>
 template <typename T>
-void World<CL<C...>, SL<S...>>::reserve_components(std::size_t n)
+void World<CL<C...>, SL<S...>, RL<R...>, I>::update_stage_(impl::TypeList<T>)
 {
-	impl::validate_component<T>(impl::TypeList<C...>{});
+	update_<T, typename T::Primary>(typename T::Components{}, nullptr);
+}
 
-	auto& cache = free_caches_[impl::index_of<T, C...>()+1];
-	if (cache.size() < n)
+// Recycling destroyed entities is held while the commands are applied, so that the changes a system defers
+// to an entity destroyed by an earlier system are dropped instead of reaching an entity created in its place
+template <typename... C, typename... S, typename... R, typename I>
+template <typename... T>
+void World<CL<C...>, SL<S...>, RL<R...>, I>::update_stage_(impl::TypeList<T...>)
+{
+	std::array<impl::Commands, sizeof...(T)> commands{{(static_cast<void>(sizeof(T)),
+	                                                    impl::Commands{data_.resource()})...}};
+	if (scheduler_ && scheduler_->workers())
+	{
+		TaskGroup group;
+		(void)impl::expand
+		{(
+			scheduler_->spawn(group, [this, &commands]
+			{
+				update_<T, typename T::Primary>(typename T::Components{}, &commands[impl::index_of<T, T...>()]);
+			}), 0
+		)...};
+		scheduler_->wait(group);
+	}
+	else
 	{
-		auto& comps = impl::get<std::vector<boost::optional<T>>>(components_);
-		comps.reserve(comps.size() + n - cache.size());
+		(void)impl::expand
+		{(
+			update_<T, typename T::Primary>(typename T::Components{}, &commands[impl::index_of<T, T...>()]), 0
+		)...};
 	}
+
+	data_.hold_recycling();
+	for (auto& buffer : commands)
+		buffer.apply();
+	data_.release_recycling();
 }
 
-template <typename... C, typename... S>
+template <typename... C, typename... S, typename... R, typename I>
 template <typename T, typename P, typename... O>
-void World<CL<C...>, SL<S...>>::update_(impl::TypeList<O...>)
+void World<CL<C...>, SL<S...>, RL<R...>, I>::update_(impl::TypeList<O...>, impl::Commands* commands)
 {
+	if (!due_[impl::index_of<T, S...>()])
+		return;
+
 	using TP = std::conditional_t<std::is_same<P, void>{}, void const, P>;
-	impl::get<T>(systems_).update(WorldView<Self, TP, O...>{entities_, components_, systems_, free_caches_});
+	using D = typename impl::TermsOf<T>::type;
+	impl::get<T>(systems_).update(WorldView<Self, TP, D, O...>{data_, systems_, resources_, recorder_,
+	                                                           timers_, scheduler_, commands,
+	                                                           &cursors_[impl::index_of<T, S...>()]});
+}
+
+template <typename... C, typename... S, typename... R, typename I>
+template <typename T>
+bool World<CL<C...>, SL<S...>, RL<R...>, I>::replay_add_(Data& data, std::size_t index, std::string const& payload)
+{
+	if (data.template has_components<T>(index))
+		return false;
+	return replay_add_<T>(data, index, payload, impl::is_trace_copyable<T>{});
+}
+
+template <typename... C, typename... S, typename... R, typename I>
+template <typename T>
+bool World<CL<C...>, SL<S...>, RL<R...>, I>::replay_add_(Data& data, std::size_t index, std::string const& payload,
+                                               std::true_type)
+{
+	if (payload.size() != sizeof(T))
+		return false;
+
+	std::aligned_storage_t<sizeof(T), alignof(T)> storage;
+	std::memcpy(&storage, payload.data(), sizeof(T));
+	data.template add_component<T>(index, *reinterpret_cast<T const*>(&storage));
+	return true;
+}
+
+template <typename... C, typename... S, typename... R, typename I>
+template <typename T>
+bool World<CL<C...>, SL<S...>, RL<R...>, I>::replay_add_(Data& data, std::size_t index, std::string const& payload,
+                                               std::false_type)
+{
+	if (!payload.empty())
+		return false;
+
+	data.template add_components<T>(index);
+	return true;
+}
+
+template <typename... C, typename... S, typename... R, typename I>
+template <typename T>
+bool World<CL<C...>, SL<S...>, RL<R...>, I>::replay_remove_(Data& data, std::size_t index)
+{
+	if (!data.template has_components<T>(index))
+		return false;
+
+	data.template remove_components<T>(index);
+	return true;
+}
+
+template <typename... C, typename... S, typename... R, typename I>
+template <typename T, typename... M>
+auto World<CL<C...>, SL<S...>, RL<R...>, I>::message_fns_() -> std::array<MessageFn, sizeof...(M)>
+{
+	return {{message_fn_<T, M>(std::integral_constant<bool, impl::can_receive<T, M>{} &&
+	                           (impl::is_trace_copyable<M>{} || std::is_default_constructible<M>{})>{})...}};
+}
+
+template <typename... C, typename... S, typename... R, typename I>
+template <typename T, typename A>
+auto World<CL<C...>, SL<S...>, RL<R...>, I>::message_fn_(std::true_type) -> MessageFn
+{
+	return &replay_message_<T, A>;
+}
+
+template <typename... C, typename... S, typename... R, typename I>
+template <typename T, typename A>
+auto World<CL<C...>, SL<S...>, RL<R...>, I>::message_fn_(std::false_type) -> MessageFn
+{
+	return nullptr;
+}
+
+template <typename... C, typename... S, typename... R, typename I>
+template <typename T, typename A>
+bool World<CL<C...>, SL<S...>, RL<R...>, I>::replay_message_(Self& world, std::string const& payload)
+{
+	return replay_message_<T, A>(world, payload, impl::is_trace_copyable<A>{});
+}
+
+template <typename... C, typename... S, typename... R, typename I>
+template <typename T, typename A>
+bool World<CL<C...>, SL<S...>, RL<R...>, I>::replay_message_(Self& world, std::string const& payload, std::true_type)
+{
+	if (payload.size() != sizeof(A))
+		return false;
+
+	std::aligned_storage_t<sizeof(A), alignof(A)> storage;
+	std::memcpy(&storage, payload.data(), sizeof(A));
+	impl::get<T>(world.systems_).receive(*reinterpret_cast<A const*>(&storage));
+	return true;
+}
+
+template <typename... C, typename... S, typename... R, typename I>
+template <typename T, typename A>
+bool World<CL<C...>, SL<S...>, RL<R...>, I>::replay_message_(Self& world, std::string const& payload, std::false_type)
+{
+	if (!payload.empty())
+		return false;
+
+	impl::get<T>(world.systems_).receive(A{});
+	return true;
 }
 
 } // namespace mantra
@@ -38,165 +38,360 @@
 namespace mantra
 {
 
-template <typename W, typename P, typename... C>
-WorldView<W, P, C...>::WorldView(typename WC::EntCont& entities, typename WC::CompCont& components,
-                                 typename WC::SysCont& systems, typename WC::Caches& caches) noexcept
-	: entities_{entities}, components_{components}, systems_{systems}, free_caches_{caches}
+template <typename W, typename P, typename D, typename... C>
+WorldView<W, P, D, C...>::WorldView(typename WC::Data& data, typename WC::SysCont& systems,
+                                    typename WC::ResCont& resources, typename WC::Recorder& recorder,
+                                    typename WC::Timers& timers, Scheduler* scheduler, impl::Commands* commands,
+                                    std::size_t* cursor) noexcept
+	: data_{data}, systems_{systems}, resources_{resources}, recorder_{recorder}, timers_{timers}, scheduler_{scheduler},
+	  commands_{commands}, cursor_{cursor}, driver_{data.template plan<C...>(D{})}, scratch_{nullptr}, gathered_{},
+	  chunk_begin_{0}, chunk_mask_{0}
 {
-	impl::validate_components(typename W::Components{}, impl::TypeList<C...>{});
+	impl::validate_system(typename W::Components{}, typename W::Resources{}, impl::TypeList<C...>{}, D{});
 }
 
-template <typename W, typename P, typename... C>
+template <typename W, typename P, typename D, typename... C>
+WorldView<W, P, D, C...>::~WorldView()
+{
+	if (scratch_)
+	{
+		flush_chunk_();
+		data_.resource()->deallocate(scratch_, chunk_bytes_, chunk_size);
+	}
+}
+
+template <typename W, typename P, typename D, typename... C>
 template <typename... Ts>
-EntityHandle<W, P, C...> WorldView<W, P, C...>::create_entity()
+EntityHandle<W, P, C...> WorldView<W, P, D, C...>::create_entity()
 {
 	impl::TypeList<Ts...> comp_types{};
 	impl::validate_components(typename W::Components{}, comp_types);
 
-	auto it = std::begin(entities_);
-	if (!free_caches_[0].empty())
-	{
-		auto index = free_caches_[0].back();
-		free_caches_[0].pop_back();
-		it += static_cast<std::ptrdiff_t>(index);
-	}
-	else
+	if (auto buffer = buffer_())
 	{
-		it = std::find_if(std::begin(entities_), std::end(entities_),
-		                  [](auto const& e){return !e;});
-		if (it == std::end(entities_))
+		buffer->push([&data = data_, &recorder = recorder_](impl::Commands& commands)
 		{
-			entities_.emplace_back(components_, free_caches_, entities_.size());
-			it = std::end(entities_) - 1;
-		}
+			auto index = data.acquire();
+			data.create(index, impl::TypeList<Ts...>{});
+			if (recorder.active())
+				recorder.template create<Ts...>(data, index);
+			commands.bind(index);
+		});
+		return {data_, recorder_, timers_, buffer->pending(), buffer};
 	}
-	it->create(comp_types);
-	return {entities_, static_cast<std::size_t>(it - std::begin(entities_))};
+
+	auto index = data_.acquire();
+	data_.create(index, comp_types);
+	if (recorder_.active())
+		recorder_.template create<Ts...>(data_, index);
+	return {data_, recorder_, timers_, index};
 }
 
-template <typename W, typename P, typename... C>
+template <typename W, typename P, typename D, typename... C>
 template <typename... Ts, typename... Args>
-EntityHandle<W, P, C...> WorldView<W, P, C...>::create_entity(Args&&... args)
+EntityHandle<W, P, C...> WorldView<W, P, D, C...>::create_entity(Args&&... args)
 {
 	impl::TypeList<Ts...> comp_types{};
 	impl::validate_components(typename W::Components{}, comp_types);
 
-	auto it = std::begin(entities_);
-	if (!free_caches_[0].empty())
+	if (auto buffer = buffer_())
 	{
-		auto index = free_caches_[0].back();
-		free_caches_[0].pop_back();
-		it += static_cast<std::ptrdiff_t>(index);
+		buffer->push([&data = data_, &recorder = recorder_,
+		              values = std::make_tuple(impl::own(std::forward<Args>(args))...)]
+		             (impl::Commands& commands) mutable
+		{
+			auto index = data.acquire();
+			impl::unpack([&data, index](auto&&... a)
+			{
+				data.create(index, impl::TypeList<Ts...>{}, std::forward<decltype(a)>(a)...);
+			}, values);
+			if (recorder.active())
+				recorder.template create<Ts...>(data, index);
+			commands.bind(index);
+		});
+		return {data_, recorder_, timers_, buffer->pending(), buffer};
 	}
-	else
+
+	auto index = data_.acquire();
+	data_.create(index, comp_types, std::forward<Args>(args)...);
+	if (recorder_.active())
+		recorder_.template create<Ts...>(data_, index);
+	return {data_, recorder_, timers_, index};
+}
+
+template <typename W, typename P, typename D, typename... C>
+typename WorldView<W, P, D, C...>::Entities WorldView<W, P, D, C...>::entities()
+{
+	static_assert(sizeof...(C) > 0, "The system has no components");
+
+	return WorldView<W, P, D, C...>::Entities{*this};
+}
+
+template <typename W, typename P, typename D, typename... C>
+typename WorldView<W, P, D, C...>::Chunks WorldView<W, P, D, C...>::chunks()
+{
+	static_assert(sizeof...(C) > 0, "The system has no components");
+
+	return WorldView<W, P, D, C...>::Chunks{*this};
+}
+
+// Ranges are made of whole words of the bitsets, several per thread so that faster threads steal the ranges
+// of slower ones. The buffers of the ranges are applied in order, which makes the result independent of the
+// partition.
+template <typename W, typename P, typename D, typename... C>
+template <typename F>
+void WorldView<W, P, D, C...>::parallel_for_each(F f)
+{
+	static_assert(sizeof...(C) > 0, "The system has no components");
+
+	auto words = (data_.size() + 63) / 64;
+	auto parallel = scheduler_ && scheduler_->workers() && words >= 2;
+	auto grain = parallel ? std::max<std::size_t>(1, words / (8 * (scheduler_->workers() + 1))) : words;
+	impl::Vector<impl::Commands> buffers{data_.resource()};
+	buffers.reserve(grain ? (words + grain - 1) / grain : 0);
+	for (std::size_t begin{0}; begin < words; begin += grain)
+		buffers.emplace_back(data_.resource());
+
+	if (parallel)
+	{
+		unshare_primary_(impl::is_any<P, C...>{});
+		scheduler_->parallel_for(words, grain, [this, &f, &buffers, grain](std::size_t begin, std::size_t end)
+		{
+			for_each_(begin, end, f, &buffers[begin / grain]);
+		});
+	}
+	else if (words)
+	{
+		for_each_(0, words, f, &buffers[0]);
+	}
+
+	if (commands_)
 	{
-		it = std::find_if(std::begin(entities_), std::end(entities_),
-		                  [](auto const& e){return !e;});
-		if (it == std::end(entities_))
+		for (auto& buffer : buffers)
 		{
-			entities_.emplace_back(components_, free_caches_, entities_.size());
-			it = std::end(entities_) - 1;
+			if (!buffer.empty())
+				commands_->push([range = std::move(buffer)](impl::Commands&) mutable {range.apply();});
 		}
+		return;
 	}
-	it->create(comp_types, std::forward<Args>(args)...);
-	return {entities_, static_cast<std::size_t>(it - std::begin(entities_))};
+	data_.hold_recycling();
+	for (auto& buffer : buffers)
+		buffer.apply();
+	data_.release_recycling();
+}
+
+template <typename W, typename P, typename D, typename... C>
+template <typename F>
+std::size_t WorldView<W, P, D, C...>::for_each_slice(std::size_t budget, F f)
+{
+	return for_each_slice_(f, [budget](std::size_t count){return count >= budget;});
+}
+
+// The clock is read after each entity, which costs little next to the work worth slicing
+template <typename W, typename P, typename D, typename... C>
+template <typename Rep, typename Period, typename F>
+std::size_t WorldView<W, P, D, C...>::for_each_slice(std::chrono::duration<Rep, Period> budget, F f)
+{
+	auto deadline = std::chrono::steady_clock::now() + budget;
+	return for_each_slice_(f, [deadline](std::size_t count)
+	{
+		return count && std::chrono::steady_clock::now() >= deadline;
+	});
+}
+
+template <typename W, typename P, typename D, typename... C>
+template <typename T>
+std::enable_if_t<impl::is_any<P, T>{}, T&> WorldView<W, P, D, C...>::resource() noexcept
+{
+	static_assert(impl::is_used<T, D>{}, "The system doesn't use this resource");
+
+	return impl::get<T>(resources_);
 }
 
-template <typename W, typename P, typename... C>
-typename WorldView<W, P, C...>::Entities WorldView<W, P, C...>::entities()
+template <typename W, typename P, typename D, typename... C>
+template <typename T>
+T const& WorldView<W, P, D, C...>::resource() const noexcept
 {
-	return WorldView<W, P, C...>::Entities{*this};
+	static_assert(impl::is_used<T, D>{}, "The system doesn't use this resource");
+
+	return impl::get<T>(resources_);
 }
 
-template <typename W, typename P, typename... C>
+template <typename W, typename P, typename D, typename... C>
 template <typename T, typename A>
-void WorldView<W, P, C...>::message(A&& arg)
+void WorldView<W, P, D, C...>::message(A&& arg)
 {
+	if (auto buffer = buffer_())
+	{
+		buffer->push([&systems = systems_, &recorder = recorder_, value = std::decay_t<A>(std::forward<A>(arg))]
+		             (impl::Commands&) mutable
+		{
+			if (recorder.active())
+				recorder.template message<T>(value);
+			impl::get<T>(systems).receive(std::move(value));
+		});
+		return;
+	}
+
+	if (recorder_.active())
+		recorder_.template message<T>(arg);
 	impl::get<T>(systems_).receive(std::forward<A>(arg));
 }
 
-template <typename W, typename P, typename... C>
-void WorldView<W, P, C...>::reserve_entities(std::size_t n)
+template <typename W, typename P, typename D, typename... C>
+void WorldView<W, P, D, C...>::reserve_entities(std::size_t n)
 {
-	if (free_caches_[0].size() < n)
-		entities_.reserve(entities_.size() + n - free_caches_[0].size());
+	if (auto buffer = buffer_())
+		buffer->push([&data = data_, n](impl::Commands&){data.reserve(n);});
+	else
+		data_.reserve(n);
 }
 
-template <typename W, typename P, typename... C>
+template <typename W, typename P, typename D, typename... C>
 template <typename T>
-void WorldView<W, P, C...>::reserve_components(std::size_t n)
+void WorldView<W, P, D, C...>::reserve_components(std::size_t n)
 {
 	impl::validate_component<T>(typename W::Components{});
 
-	auto& cache = free_caches_[impl::index_of<T, C...>()+1];
-	if (cache.size() < n)
+	if (auto buffer = buffer_())
+		buffer->push([&data = data_, n](impl::Commands&){data.template pool<T>().reserve(n);});
+	else
+		data_.template pool<T>().reserve(n);
+}
+
+template <typename W, typename P, typename D, typename... C>
+impl::Commands* WorldView<W, P, D, C...>::buffer_() const noexcept
+{
+	auto const& range = impl::range_commands();
+	return range.data == &data_ ? range.commands : commands_;
+}
+
+// Entities in the words [begin, end), whose commands go to buffer
+template <typename W, typename P, typename D, typename... C>
+template <typename F>
+void WorldView<W, P, D, C...>::for_each_(std::size_t begin, std::size_t end, F& f, impl::Commands* buffer)
+{
+	auto& range = impl::range_commands();
+	auto outer = range;
+	range = {&data_, buffer};
+
+	auto last = std::min(64 * end, data_.size());
+	for (auto index = data_.template find<C...>(64 * begin, driver_, D{}); index < last;
+	     index = data_.template find<C...>(index + 1, driver_, D{}))
+	{
+		EntityHandle<W, P, C...> handle{data_, recorder_, timers_, index, buffer};
+		f(handle);
+	}
+	range = outer;
+}
+
+// The cursor is the index following the last entity processed. A slice runs from the cursor to the end, then
+// from the first entity to the cursor, and stops on the way when stop returns true.
+template <typename W, typename P, typename D, typename... C>
+template <typename F, typename Stop>
+std::size_t WorldView<W, P, D, C...>::for_each_slice_(F& f, Stop stop)
+{
+	static_assert(sizeof...(C) > 0, "The system has no components");
+	assert(cursor_ && "(Dev) Slicing without a cursor");
+
+	auto start = std::min(*cursor_, data_.size());
+	auto wrapped = false;
+	auto index = data_.template find<C...>(start, driver_, D{});
+	std::size_t count{0};
+	while (!stop(count))
 	{
-		auto& comps = std::get<std::vector<boost::optional<T>>>(components_);
-		comps.reserve(comps.size() + n - cache.size());
+		if (index >= data_.size())
+		{
+			if (wrapped || !start)
+				break;
+			wrapped = true;
+			index = data_.template find<C...>(0, driver_, D{});
+			continue;
+		}
+		if (wrapped && index >= start)
+			break;
+
+		EntityHandle<W, P, C...> handle{data_, recorder_, timers_, index, commands_};
+		f(handle);
+		++count;
+		*cursor_ = index + 1;
+		index = data_.template find<C...>(index + 1, driver_, D{});
 	}
+	return count;
 }
 
-template <typename W, typename P, typename... C>
-WorldView<W, P, C...>::Entities::Entities(WorldView<W, P, C...>& view)
+template <typename W, typename P, typename D, typename... C>
+void WorldView<W, P, D, C...>::unshare_primary_(std::false_type) noexcept
+{}
+
+template <typename W, typename P, typename D, typename... C>
+void WorldView<W, P, D, C...>::unshare_primary_(std::true_type) noexcept
+{
+	impl::unshare(data_.template pool<P>());
+}
+
+template <typename W, typename P, typename D, typename... C>
+WorldView<W, P, D, C...>::Entities::Entities(WorldView<W, P, D, C...>& view)
 	: view_{view}
 {}
 
-template <typename W, typename P, typename... C>
-typename WorldView<W, P, C...>::EntityIterator WorldView<W, P, C...>::Entities::begin()
+template <typename W, typename P, typename D, typename... C>
+typename WorldView<W, P, D, C...>::EntityIterator WorldView<W, P, D, C...>::Entities::begin()
 {
-	return WorldView<W, P, C...>::EntityIterator{view_};
+	return WorldView<W, P, D, C...>::EntityIterator{view_};
 }
 
-template <typename W, typename P, typename... C>
-typename WorldView<W, P, C...>::EntityIterator WorldView<W, P, C...>::Entities::end()
+template <typename W, typename P, typename D, typename... C>
+typename WorldView<W, P, D, C...>::EntityIterator WorldView<W, P, D, C...>::Entities::end()
 {
-	return WorldView<W, P, C...>::EntityIterator{};
+	return WorldView<W, P, D, C...>::EntityIterator{};
 }
 
-template <typename W, typename P, typename... C>
-WorldView<W, P, C...>::EntityIterator::EntityIterator()
+template <typename W, typename P, typename D, typename... C>
+WorldView<W, P, D, C...>::EntityIterator::EntityIterator()
 	: view_{nullptr}, handle_{}, index_{0}
 {}
 
-template <typename W, typename P, typename... C>
-WorldView<W, P, C...>::EntityIterator::EntityIterator(WorldView<W, P, C...>& view)
-	: view_{&view}, handle_{}, index_{0}
+template <typename W, typename P, typename D, typename... C>
+WorldView<W, P, D, C...>::EntityIterator::EntityIterator(WorldView<W, P, D, C...>& view)
+	: view_{&view}, handle_{}, index_{view.data_.template find<C...>(0, view.driver_, D{})}
 {
-	if (view_->entities_.empty())
+	if (index_ == view_->data_.size())
+	{
 		view_ = nullptr;
-	else if (!view_->entities_[0] || !view_->entities_[0].template has_components<C...>())
-		find_next_();
+		index_ = 0;
+	}
 }
 
-template <typename W, typename P, typename... C>
-WorldView<W, P, C...>::EntityIterator::EntityIterator(WorldView<W, P, C...>::EntityIterator const& cp)
+template <typename W, typename P, typename D, typename... C>
+WorldView<W, P, D, C...>::EntityIterator::EntityIterator(WorldView<W, P, D, C...>::EntityIterator const& cp)
 	: view_{cp.view_}, handle_{}, index_{cp.index_}
 {}
 
-template <typename W, typename P, typename... C>
-EntityHandle<W, P, C...>& WorldView<W, P, C...>::EntityIterator::operator*()
+template <typename W, typename P, typename D, typename... C>
+EntityHandle<W, P, C...>& WorldView<W, P, D, C...>::EntityIterator::operator*()
 {
 	assert(view_ && "Can't dereference an invalid iterator");
 
 	if (!handle_)
-		handle_.emplace(view_->entities_, index_);
+		handle_.emplace(view_->data_, view_->recorder_, view_->timers_, index_, view_->commands_);
 
 	return handle_.get();
 }
 
-template <typename W, typename P, typename... C>
-EntityHandle<W, P, C...>* WorldView<W, P, C...>::EntityIterator::operator->()
+template <typename W, typename P, typename D, typename... C>
+EntityHandle<W, P, C...>* WorldView<W, P, D, C...>::EntityIterator::operator->()
 {
 	assert(view_ && "Can't dereference an invalid iterator");
 
 	if (!handle_)
-		handle_.emplace(view_->entities_, index_);
+		handle_.emplace(view_->data_, view_->recorder_, view_->timers_, index_, view_->commands_);
 
 	return &(handle_.get());
 }
 
-template <typename W, typename P, typename... C>
-typename WorldView<W, P, C...>::EntityIterator& WorldView<W, P, C...>::EntityIterator::operator++()
+template <typename W, typename P, typename D, typename... C>
+typename WorldView<W, P, D, C...>::EntityIterator& WorldView<W, P, D, C...>::EntityIterator::operator++()
 {
 	assert(view_ && "Can't increment an invalid iterator");
 
@@ -206,8 +401,8 @@ typename WorldView<W, P, C...>::EntityIterator& WorldView<W, P, C...>::EntityIte
 	return *this;
 }
 
-template <typename W, typename P, typename... C>
-typename WorldView<W, P, C...>::EntityIterator WorldView<W, P, C...>::EntityIterator::operator++(int)
+template <typename W, typename P, typename D, typename... C>
+typename WorldView<W, P, D, C...>::EntityIterator WorldView<W, P, D, C...>::EntityIterator::operator++(int)
 {
 	assert(view_ && "Can't increment an invalid iterator");
 
@@ -217,21 +412,302 @@ typename WorldView<W, P, C...>::EntityIterator WorldView<W, P, C...>::EntityIter
 	return cp;
 }
 
-template <typename W, typename P, typename... C>
-void WorldView<W, P, C...>::EntityIterator::find_next_()
+template <typename W, typename P, typename D, typename... C>
+void WorldView<W, P, D, C...>::EntityIterator::find_next_()
 {
 	assert(view_ && "(Dev) Can't call this on an invalid iterator");
 
-	auto it = std::find_if(std::begin(view_->entities_) + static_cast<std::ptrdiff_t>(index_) + 1,
-	                       std::end(view_->entities_),
-	                       [](auto const& e){return e && e.template has_components<C...>();});
-	if (it == std::end(view_->entities_))
+	index_ = view_->data_.template find<C...>(index_ + 1, view_->driver_, D{});
+	if (index_ == view_->data_.size())
 	{
 		view_ = nullptr;
 		index_ = 0;
 	}
-	else
-		index_ = static_cast<std::size_t>(it - std::begin(view_->entities_));
+}
+
+template <typename W, typename P, typename D, typename... C>
+WorldView<W, P, D, C...>::Chunk::Chunk(WorldView<W, P, D, C...>* view, std::size_t begin, std::size_t size) noexcept
+	: view_{view}, begin_{begin}, size_{size}, mask_{0}, count_{0}, ids_{}
+{}
+
+template <typename W, typename P, typename D, typename... C>
+std::size_t WorldView<W, P, D, C...>::Chunk::begin() const noexcept
+{
+	return begin_;
+}
+
+template <typename W, typename P, typename D, typename... C>
+std::size_t WorldView<W, P, D, C...>::Chunk::size() const noexcept
+{
+	return size_;
+}
+
+template <typename W, typename P, typename D, typename... C>
+std::uint64_t WorldView<W, P, D, C...>::Chunk::mask() const noexcept
+{
+	return mask_;
+}
+
+template <typename W, typename P, typename D, typename... C>
+std::size_t WorldView<W, P, D, C...>::Chunk::count() const noexcept
+{
+	return count_;
+}
+
+template <typename W, typename P, typename D, typename... C>
+std::size_t const* WorldView<W, P, D, C...>::Chunk::ids() const noexcept
+{
+	return ids_.data();
+}
+
+template <typename W, typename P, typename D, typename... C>
+template <typename T>
+auto WorldView<W, P, D, C...>::Chunk::data() const -> DataPointer<T>
+{
+	impl::validate_component<T>(impl::TypeList<C...>{});
+	static_assert(std::is_trivially_copyable<T>{} && !std::is_pointer<T>{},
+	              "Chunked access requires trivially copyable, non pointer components");
+	static_assert(!impl::is_soa<impl::PoolOf<T>>{}, "Use field() to access struct-of-arrays components");
+	static_assert(!impl::is_optional<T, D>{}, "Optional components can't be accessed by chunks");
+	assert(view_ && "Can't access an invalid chunk");
+
+	auto idx = impl::index_of<T, C...>();
+	auto array = view_->chunk_array_(*this, impl::chunk_slots<C...>(idx),
+	                                 impl::chunk_bytes<C...>(idx));
+	auto data = reinterpret_cast<T*>(array.first);
+	if (array.second)
+	{
+		auto const& registry = impl::as_const(view_->data_);
+		for (std::size_t i{0}; i < count_; ++i)
+			::new (static_cast<void*>(data + i)) T(registry.template get_component<T>(ids_[i]));
+	}
+	return data;
+}
+
+template <typename W, typename P, typename D, typename... C>
+template <typename T, std::size_t I>
+auto WorldView<W, P, D, C...>::Chunk::field() const -> FieldPointer<T, I>
+{
+	impl::validate_component<T>(impl::TypeList<C...>{});
+	static_assert(impl::is_soa<impl::PoolOf<T>>{}, "Field access requires struct-of-arrays storage");
+	static_assert(!impl::is_optional<T, D>{}, "Optional components can't be accessed by chunks");
+	assert(view_ && "Can't access an invalid chunk");
+
+	auto& pool = view_->data_.template pool<T>();
+	if (count_ == size_)
+		return pool.template field<I>(begin_);
+
+	using Field = typename impl::PoolOf<T>::template Field<I>;
+	auto idx = impl::index_of<T, C...>();
+	auto array = view_->chunk_array_(*this, impl::chunk_slots<C...>(idx) + I,
+	                                 impl::chunk_bytes<C...>(idx) +
+	                                 impl::ChunkLayout<impl::PoolOf<T>>::offset(I));
+	auto data = reinterpret_cast<Field*>(array.first);
+	if (array.second)
+	{
+		for (std::size_t i{0}; i < count_; ++i)
+			data[i] = *pool.template field<I>(ids_[i]);
+	}
+	return data;
+}
+
+template <typename W, typename P, typename D, typename... C>
+WorldView<W, P, D, C...>::Chunks::Chunks(WorldView<W, P, D, C...>& view)
+	: view_{view}
+{}
+
+template <typename W, typename P, typename D, typename... C>
+typename WorldView<W, P, D, C...>::ChunkIterator WorldView<W, P, D, C...>::Chunks::begin()
+{
+	return WorldView<W, P, D, C...>::ChunkIterator{view_};
+}
+
+template <typename W, typename P, typename D, typename... C>
+typename WorldView<W, P, D, C...>::ChunkIterator WorldView<W, P, D, C...>::Chunks::end()
+{
+	return WorldView<W, P, D, C...>::ChunkIterator{};
+}
+
+template <typename W, typename P, typename D, typename... C>
+WorldView<W, P, D, C...>::ChunkIterator::ChunkIterator()
+	: view_{nullptr}, chunk_{nullptr, 0, 0}
+{}
+
+template <typename W, typename P, typename D, typename... C>
+WorldView<W, P, D, C...>::ChunkIterator::ChunkIterator(WorldView<W, P, D, C...>& view)
+	: view_{&view}, chunk_{nullptr, 0, 0}
+{
+	find_next_(0);
+}
+
+// Gathered primary components must reach the entities even if the iteration is interrupted
+template <typename W, typename P, typename D, typename... C>
+WorldView<W, P, D, C...>::ChunkIterator::~ChunkIterator()
+{
+	if (view_)
+		view_->flush_chunk_();
+}
+
+template <typename W, typename P, typename D, typename... C>
+typename WorldView<W, P, D, C...>::Chunk& WorldView<W, P, D, C...>::ChunkIterator::operator*()
+{
+	assert(view_ && "Can't dereference an invalid iterator");
+
+	return chunk_;
+}
+
+template <typename W, typename P, typename D, typename... C>
+typename WorldView<W, P, D, C...>::Chunk* WorldView<W, P, D, C...>::ChunkIterator::operator->()
+{
+	assert(view_ && "Can't dereference an invalid iterator");
+
+	return &chunk_;
+}
+
+template <typename W, typename P, typename D, typename... C>
+typename WorldView<W, P, D, C...>::ChunkIterator& WorldView<W, P, D, C...>::ChunkIterator::operator++()
+{
+	assert(view_ && "Can't increment an invalid iterator");
+
+	find_next_(chunk_.begin() + chunk_size);
+
+	return *this;
+}
+
+template <typename W, typename P, typename D, typename... C>
+typename WorldView<W, P, D, C...>::ChunkIterator WorldView<W, P, D, C...>::ChunkIterator::operator++(int)
+{
+	assert(view_ && "Can't increment an invalid iterator");
+
+	auto cp = *this;
+	++*this;
+
+	return cp;
+}
+
+template <typename W, typename P, typename D, typename... C>
+void WorldView<W, P, D, C...>::ChunkIterator::find_next_(std::size_t begin)
+{
+	assert(view_ && "(Dev) Can't call this on an invalid iterator");
+
+	static_assert(chunk_size == 64, "(Dev) Chunks must map to column words");
+
+	auto const& data = view_->data_;
+	for (auto word = begin / chunk_size; word * chunk_size < data.size();
+	     word = data.next_word(view_->driver_, word + 1))
+	{
+		auto bits = data.template matches<C...>(word, D{});
+		if (bits)
+		{
+			begin = word * chunk_size;
+			Chunk chunk{view_, begin, std::min(chunk_size, data.size() - begin)};
+			chunk.mask_ = bits;
+			for (; bits; bits &= bits - 1)
+				chunk.ids_[chunk.count_++] = begin + impl::count_trailing_zeros(bits);
+			chunk_ = chunk;
+			return;
+		}
+	}
+	view_->flush_chunk_();
+	view_ = nullptr;
+	chunk_ = Chunk{nullptr, 0, 0};
+}
+
+// Returns an array of the scratch space, and whether it must be filled. Reaching another chunk flushes the
+// arrays of the previous one.
+template <typename W, typename P, typename D, typename... C>
+std::pair<unsigned char*, bool> WorldView<W, P, D, C...>::chunk_array_(Chunk const& chunk, std::size_t slot,
+                                                                    std::size_t offset)
+{
+	if (!scratch_)
+	{
+		scratch_ = static_cast<unsigned char*>(
+			data_.resource()->allocate(chunk_bytes_, chunk_size));
+	}
+	else if (chunk.begin() != chunk_begin_ || chunk.mask() != chunk_mask_)
+		flush_chunk_();
+
+	if (chunk.begin() != chunk_begin_ || chunk.mask() != chunk_mask_)
+	{
+		gathered_.reset();
+		chunk_begin_ = chunk.begin();
+		chunk_mask_ = chunk.mask();
+	}
+
+	auto fresh = !gathered_[slot];
+	gathered_[slot] = true;
+	return {scratch_ + offset, fresh};
+}
+
+template <typename W, typename P, typename D, typename... C>
+void WorldView<W, P, D, C...>::flush_chunk_()
+{
+	flush_chunk_(std::integral_constant<bool, impl::is_any<P, C...>{}>{});
+}
+
+template <typename W, typename P, typename D, typename... C>
+void WorldView<W, P, D, C...>::flush_chunk_(std::false_type) noexcept
+{}
+
+template <typename W, typename P, typename D, typename... C>
+void WorldView<W, P, D, C...>::flush_chunk_(std::true_type)
+{
+	if (scratch_)
+		flush_primary_(impl::is_soa<impl::PoolOf<P>>{});
+}
+
+template <typename W, typename P, typename D, typename... C>
+void WorldView<W, P, D, C...>::flush_primary_(std::false_type)
+{
+	auto idx = impl::index_of<P, C...>();
+	if (!gathered_[impl::chunk_slots<C...>(idx)])
+		return;
+
+	auto data = reinterpret_cast<P const*>(scratch_ + impl::chunk_bytes<C...>(idx));
+	for (auto bits = chunk_mask_; bits; bits &= bits - 1, ++data)
+	{
+		auto index = chunk_begin_ + impl::count_trailing_zeros(bits);
+		if (data_[index] && data_[index].template has_components<P>())
+			data_.template get_component<P>(index) = *data;
+	}
+}
+
+template <typename W, typename P, typename D, typename... C>
+void WorldView<W, P, D, C...>::flush_primary_(std::true_type)
+{
+	flush_fields_(std::make_index_sequence<impl::ChunkLayout<impl::PoolOf<P>>::slots>{});
+}
+
+template <typename W, typename P, typename D, typename... C>
+template <std::size_t... Is>
+void WorldView<W, P, D, C...>::flush_fields_(std::index_sequence<Is...>)
+{
+	(void)impl::expand
+	{(
+		flush_field_<Is>(), 0
+	)...};
+}
+
+// Entities destroyed or deprived of the primary component since the chunk was reached are skipped
+template <typename W, typename P, typename D, typename... C>
+template <std::size_t I>
+void WorldView<W, P, D, C...>::flush_field_()
+{
+	using Pool = impl::PoolOf<P>;
+
+	auto idx = impl::index_of<P, C...>();
+	if (!gathered_[impl::chunk_slots<C...>(idx) + I])
+		return;
+
+	auto& pool = data_.template pool<P>();
+	auto data = reinterpret_cast<typename Pool::template Field<I> const*>(
+		scratch_ + impl::chunk_bytes<C...>(idx) + impl::ChunkLayout<Pool>::offset(I));
+	for (auto bits = chunk_mask_; bits; bits &= bits - 1, ++data)
+	{
+		auto index = chunk_begin_ + impl::count_trailing_zeros(bits);
+		if (data_[index] && data_[index].template has_components<P>())
+			*pool.template field<I>(index) = *data;
+	}
 }
 
 } // namespace mantra
@@ -41,9 +41,23 @@
 
 #include <boost/optional.hpp>
 
+#include "Allocator.hpp"
+
 namespace mantra
 {
 
+template <typename... T>
+struct Without;
+
+template <typename... T>
+struct Maybe;
+
+template <typename... T>
+struct Uses;
+
+template <typename T>
+struct Previous;
+
 namespace impl
 {
 
@@ -108,8 +122,6 @@ struct identity
 template <typename... Ts>
 struct TypeList : private identity<Ts>... // Supplied same type multiple times
 {
-	static_assert(sizeof...(Ts) > 0, "No types supplied");
-
 	template <typename... Us>
 	constexpr bool contains() const noexcept
 	{
@@ -225,6 +237,115 @@ decltype(auto) invoke(F&& f, T<Us...>&& t)
 	return f(get<Us>(std::forward<T<Us...>>(t))...);
 }
 
+// Reads through a reference to non-const data without selecting the mutating overloads, which may copy a
+// page shared with a forked world
+template <typename T>
+constexpr T const& as_const(T& t) noexcept
+{
+	return t;
+}
+
+inline unsigned count_trailing_zeros(std::uint64_t word) noexcept
+{
+	assert(word && "(Dev) Undefined for 0");
+
+#if defined(__GNUC__)
+	return static_cast<unsigned>(__builtin_ctzll(word));
+#else
+	unsigned res{0};
+	for (; !(word & 1); word >>= 1)
+		++res;
+	return res;
+#endif
+}
+
+template <typename...>
+struct Pack
+{};
+
+// Declaration terms of a system besides its components : the components it excludes, the components it
+// accesses without requiring them and the world resources it uses
+template <typename X, typename M, typename U>
+struct Terms
+{};
+
+using NoTerms = Terms<Without<>, Maybe<>, Uses<>>;
+
+// Components listed as Previous<T> are required like T, but read from the copies of the previous frame
+template <typename T>
+struct Unwrap
+{
+	using type = T;
+};
+
+template <typename T>
+struct Unwrap<Previous<T>>
+{
+	using type = T;
+};
+
+template <typename T>
+using Stored = typename Unwrap<T>::type;
+
+template <typename T, typename D>
+struct is_optional;
+
+template <typename T, typename X, typename... M, typename U>
+struct is_optional<T, Terms<X, Maybe<M...>, U>> : is_any<T, M...> {};
+
+template <typename T, typename D>
+struct is_used;
+
+template <typename T, typename X, typename M, typename... U>
+struct is_used<T, Terms<X, M, Uses<U...>>> : is_any<T, U...> {};
+
+// Splits the terms of a system declaration
+// A primary type which is a used resource isn't a component.
+template <typename R, typename X, typename M, typename U, typename... Ts>
+struct SplitTerms;
+
+template <typename... R, typename... X, typename... M, typename... U>
+struct SplitTerms<Pack<R...>, Pack<X...>, Pack<M...>, Pack<U...>>
+{
+	template <typename P>
+	using Components = std::conditional_t<std::is_same<P, void>{} || is_any<P, U...>{},
+	                                      TypeList<R..., M...>, TypeList<P, R..., M...>>;
+	using Terms = impl::Terms<Without<X...>, Maybe<M...>, Uses<U...>>;
+};
+
+template <typename... R, typename... X, typename... M, typename... U, typename T, typename... Ts>
+struct SplitTerms<Pack<R...>, Pack<X...>, Pack<M...>, Pack<U...>, T, Ts...>
+	: SplitTerms<Pack<R..., T>, Pack<X...>, Pack<M...>, Pack<U...>, Ts...>
+{};
+
+template <typename... R, typename... X, typename... M, typename... U, typename... W, typename... Ts>
+struct SplitTerms<Pack<R...>, Pack<X...>, Pack<M...>, Pack<U...>, Without<W...>, Ts...>
+	: SplitTerms<Pack<R...>, Pack<X..., W...>, Pack<M...>, Pack<U...>, Ts...>
+{};
+
+template <typename... R, typename... X, typename... M, typename... U, typename... O, typename... Ts>
+struct SplitTerms<Pack<R...>, Pack<X...>, Pack<M...>, Pack<U...>, Maybe<O...>, Ts...>
+	: SplitTerms<Pack<R...>, Pack<X...>, Pack<M..., O...>, Pack<U...>, Ts...>
+{};
+
+template <typename... R, typename... X, typename... M, typename... U, typename... G, typename... Ts>
+struct SplitTerms<Pack<R...>, Pack<X...>, Pack<M...>, Pack<U...>, Uses<G...>, Ts...>
+	: SplitTerms<Pack<R...>, Pack<X...>, Pack<M...>, Pack<U..., G...>, Ts...>
+{};
+
+// Systems without a Terms type have no other terms than their components
+template <typename S, typename = void>
+struct TermsOf
+{
+	using type = NoTerms;
+};
+
+template <typename S>
+struct TermsOf<S, std::conditional_t<false, typename S::Terms, void>>
+{
+	using type = typename S::Terms;
+};
+
 template <typename T, typename... C>
 constexpr void validate_component(TypeList<C...> c) noexcept
 {
@@ -234,22 +355,48 @@ constexpr void validate_component(TypeList<C...> c) noexcept
 template <typename... C, typename... T>
 constexpr void validate_components(TypeList<C...> c, TypeList<T...>) noexcept
 {
+	static_assert(sizeof...(T) > 0, "No types supplied");
 	static_assert(c.template contains<T...>(), "Invalid component type");
 }
 
-template <typename... Ts>
-class Entity;
+template <typename T, typename... R>
+constexpr void validate_resource(TypeList<R...> r) noexcept
+{
+	static_assert(r.template contains<T>(), "Invalid resource type");
+}
+
+template <typename... C, typename... R, typename... T, typename... X, typename M, typename... U>
+constexpr void validate_system(TypeList<C...> c, TypeList<R...> r, TypeList<T...>,
+                               Terms<Without<X...>, M, Uses<U...>>) noexcept
+{
+	static_assert(c.template contains<Stored<T>..., X...>(), "Invalid component type");
+	static_assert(r.template contains<U...>(), "Invalid resource type");
+}
+
+template <typename I, typename... C>
+class Registry;
 
 template <typename C, typename S>
+class TraceRecorder;
+
+template <typename... Args>
+class TimingWheel;
+
+template <typename... Args>
+class SpawnQueue;
+
+template <typename C, typename S, typename R, typename I>
 struct WorldCont;
 
-template <typename... C, typename... S>
-struct WorldCont<TypeList<C...>, TypeList<S...>>
+template <typename... C, typename... S, typename... R, typename I>
+struct WorldCont<TypeList<C...>, TypeList<S...>, TypeList<R...>, I>
 {
-	using EntCont = std::vector<Entity<C...>>;
-	using CompCont = Tuple<std::vector<boost::optional<C>>...>;
+	using Data = Registry<I, C...>;
 	using SysCont = Tuple<S...>;
-	using Caches = std::array<std::vector<std::size_t>, sizeof...(C) + 1>;
+	using ResCont = Tuple<R...>;
+	using Recorder = TraceRecorder<TypeList<C...>, TypeList<S...>>;
+	using Timers = TimingWheel<Data, Recorder>;
+	using Spawns = SpawnQueue<Data, Recorder>;
 };
 
 } // namespace impl
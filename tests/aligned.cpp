@@ -0,0 +1,89 @@
+// Aligned resource tests
+//
+// Blocks of an aligned resource start on a cache line, large blocks are mapped on huge page boundaries without
+// going through the upstream resource, and worlds run on top of it.
+
+#include <cstdint>
+
+#include <mantra/MemoryResource.hpp>
+#include <mantra/System.hpp>
+#include <mantra/World.hpp>
+
+#include "check.hpp"
+#include "counting_resource.hpp"
+
+struct Position
+{
+	float x, y, z;
+};
+
+struct Velocity
+{
+	float x, y, z;
+};
+
+class MoveSys : public mantra::System<Position, Velocity>
+{
+	public:
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		for (auto& entity : wv.entities())
+			entity.template get_component<Position>().x += entity.template get_component<Velocity>().x;
+	}
+};
+
+using World = mantra::World<mantra::ComponentList<Position, Velocity>, mantra::SystemList<MoveSys>>;
+
+namespace
+{
+
+bool aligned(void* p, std::uintptr_t alignment)
+{
+	return reinterpret_cast<std::uintptr_t>(p) % alignment == 0;
+}
+
+void blocks(mantra::HugePages pages)
+{
+	test::CountingResource upstream;
+	{
+		std::size_t const large{5 << 20};
+		mantra::AlignedResource resource{pages, 1 << 20, &upstream};
+		CHECK(resource.huge_pages() == pages);
+		auto small = resource.allocate(3, 1);
+		auto big = resource.allocate(large, 8);
+		CHECK(aligned(small, 64));
+		CHECK(aligned(big, pages == mantra::HugePages::none ? 64 : 2 << 20));
+		CHECK(upstream.total == (pages == mantra::HugePages::none ? 2u : 1u));
+		static_cast<char*>(big)[large - 1] = 1;
+		resource.deallocate(big, large, 8);
+		resource.deallocate(small, 3, 1);
+	}
+	CHECK(upstream.live == 0);
+}
+
+void world(mantra::HugePages pages)
+{
+	mantra::AlignedResource resource{pages, 1 << 16};
+	World world{std::allocator_arg, resource};
+	world.reserve_components<Position>(20000);
+	auto first = world.create_entity<Position, Velocity>(mantra::forward_as_tuple(Position{0, 0, 0}),
+	                                                     mantra::forward_as_tuple(Velocity{1, 0, 0}));
+	for (int i{1}; i < 20000; ++i)
+		world.create_entity<Position, Velocity>(mantra::forward_as_tuple(Position{0, 0, 0}),
+		                                        mantra::forward_as_tuple(Velocity{1, 0, 0}));
+	world.update();
+	CHECK(first.get_component<Position>().x == 1);
+}
+
+} // namespace
+
+int main()
+{
+	for (auto pages : {mantra::HugePages::none, mantra::HugePages::transparent, mantra::HugePages::reserved})
+	{
+		blocks(pages);
+		world(pages);
+	}
+	return test::result();
+}
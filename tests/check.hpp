@@ -0,0 +1,39 @@
+// Shared checks for the behaviour tests
+//
+// A test is an executable whose `main` runs the checks and returns `test::result()`. A failed `CHECK` prints
+// the condition and its location, and makes the test fail without stopping it. Checks don't depend on
+// `NDEBUG`, so the tests behave the same in every build type.
+
+#ifndef MANTRA_TESTS_CHECK_HPP
+#define MANTRA_TESTS_CHECK_HPP
+
+#include <cstdlib>
+#include <iostream>
+
+namespace test
+{
+
+inline int& failures() noexcept
+{
+	static int count{0};
+	return count;
+}
+
+inline void check(bool ok, char const* condition, char const* file, int line)
+{
+	if (ok)
+		return;
+	std::cerr << file << ':' << line << ": check failed: " << condition << '\n';
+	++failures();
+}
+
+inline int result()
+{
+	return failures() ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+} // namespace test
+
+#define CHECK(...) ::test::check(static_cast<bool>(__VA_ARGS__), #__VA_ARGS__, __FILE__, __LINE__)
+
+#endif // Header guard
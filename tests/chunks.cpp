@@ -0,0 +1,162 @@
+// Chunk tests
+//
+// Chunks list their visible entities in order, give packed aligned arrays of every component, and write the
+// gathered arrays of the primary component back to the pools.
+
+#include <cstdint>
+
+#include <mantra/System.hpp>
+#include <mantra/World.hpp>
+
+#include "check.hpp"
+
+struct Position
+{
+	float x, y;
+};
+
+struct Velocity
+{
+	float x, y;
+};
+
+struct Mass
+{
+	float m;
+};
+
+struct Heavy
+{};
+
+namespace mantra
+{
+
+template <>
+struct storage_traits<Position>
+{
+	using storage = SoAStorage<MANTRA_MEMBER(Position, x), MANTRA_MEMBER(Position, y)>;
+};
+
+} // namespace mantra
+
+struct Stats
+{
+	std::size_t count;
+	bool aligned;
+	bool ordered;
+	double sum;
+};
+
+// Struct-of-arrays primary component, dense secondary one. The loops run over whole chunks, padding included
+class MoveSys : public mantra::System<Position, Velocity>
+{
+	public:
+	explicit MoveSys(Stats* s) : stats{s} {}
+
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		stats->count = 0;
+		stats->aligned = stats->ordered = true;
+		for (auto& chunk : wv.chunks())
+		{
+			auto x = chunk.template field<Position, 0>();
+			auto y = chunk.template field<Position, 1>();
+			auto v = chunk.template data<Velocity>();
+			stats->aligned = stats->aligned && reinterpret_cast<std::uintptr_t>(x) % 64 == 0
+			                 && reinterpret_cast<std::uintptr_t>(v) % 64 == 0;
+			for (std::size_t i{0}; i < mantra::chunk_size; ++i)
+			{
+				x[i] += v[i].x;
+				y[i] += v[i].y;
+			}
+			for (std::size_t i{1}; i < chunk.count(); ++i)
+				stats->ordered = stats->ordered && chunk.ids()[i] > chunk.ids()[i - 1];
+			stats->count += chunk.count();
+		}
+	}
+
+	Stats* stats;
+};
+
+// Dense primary component, gathered then written back, including when the iteration stops early
+class MassSys : public mantra::System<Mass, Heavy>
+{
+	public:
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		for (auto& chunk : wv.chunks())
+		{
+			auto m = chunk.template data<Mass>();
+			for (std::size_t i{0}; i < chunk.count(); ++i)
+				m[i].m *= 2;
+			if (chunk.begin() == 64)
+				break;
+		}
+	}
+};
+
+class ProbeSys : public mantra::System<void, Position, Mass>
+{
+	public:
+	explicit ProbeSys(Stats* s) : stats{s} {}
+
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		stats->sum = 0;
+		for (auto& entity : wv.entities())
+		{
+			Position p = entity.template get_component<Position>();
+			stats->sum += p.x + p.y + entity.template get_component<Mass>().m;
+		}
+	}
+
+	Stats* stats;
+};
+
+using World = mantra::World<mantra::ComponentList<Position, Velocity, Mass, Heavy>,
+                            mantra::SystemList<MoveSys, MassSys, ProbeSys>>;
+
+namespace
+{
+
+// The first chunk is full, the others are sparse
+void kernels()
+{
+	Stats stats{};
+	World world{mantra::forward_as_tuple(&stats), mantra::forward_as_tuple(), mantra::forward_as_tuple(&stats)};
+	for (int i{0}; i < 300; ++i)
+	{
+		if (i < 64 || i % 3 == 0)
+			world.create_entity<Position, Velocity, Mass, Heavy>(
+			    mantra::forward_as_tuple(Position{float(i), 0}), mantra::forward_as_tuple(Velocity{1, 2}),
+			    mantra::forward_as_tuple(Mass{1}), mantra::forward_as_tuple());
+		else
+			world.create_entity<Position, Mass>(mantra::forward_as_tuple(Position{float(i), 1}),
+			                                    mantra::forward_as_tuple(Mass{1}));
+	}
+	world.update();
+
+	std::size_t count{0};
+	double sum{0};
+	for (int i{0}; i < 300; ++i)
+	{
+		bool moving{i < 64 || i % 3 == 0};
+		count += moving;
+		double mass{moving && i < 128 ? 2. : 1.};
+		sum += moving ? i + 1 + 2 + mass : i + 1 + mass;
+	}
+	CHECK(stats.count == count);
+	CHECK(stats.aligned && stats.ordered);
+	CHECK(stats.sum == sum);
+}
+
+} // namespace
+
+int main()
+{
+	kernels();
+	return test::result();
+}
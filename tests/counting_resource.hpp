@@ -0,0 +1,52 @@
+// Memory resource counting the allocations of the tests
+//
+// Forwards to the default resource, and counts the live allocations and every allocation made. While it
+// forwards, `in_upstream()` is true, so that a test counting the allocations of the global heap can leave
+// those out.
+
+#ifndef MANTRA_TESTS_COUNTING_RESOURCE_HPP
+#define MANTRA_TESTS_COUNTING_RESOURCE_HPP
+
+#include <mantra/MemoryResource.hpp>
+
+namespace test
+{
+
+inline bool& in_upstream() noexcept
+{
+	static bool value{false};
+	return value;
+}
+
+class CountingResource final : public mantra::MemoryResource
+{
+	public:
+	std::size_t live{0};
+	std::size_t total{0};
+
+	private:
+	void* do_allocate(std::size_t bytes, std::size_t alignment) override
+	{
+		++live;
+		++total;
+		in_upstream() = true;
+		auto p = mantra::default_resource()->allocate(bytes, alignment);
+		in_upstream() = false;
+		return p;
+	}
+
+	void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override
+	{
+		--live;
+		mantra::default_resource()->deallocate(p, bytes, alignment);
+	}
+
+	bool do_is_equal(mantra::MemoryResource const& other) const noexcept override
+	{
+		return this == &other;
+	}
+};
+
+} // namespace test
+
+#endif // Header guard
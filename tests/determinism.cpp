@@ -0,0 +1,143 @@
+// Determinism tests
+//
+// A deterministic world records the same trace whatever its scheduler and number of workers, including with
+// entities created, destroyed and changed from parallel loops and concurrent systems.
+
+#include <sstream>
+#include <string>
+
+#include <mantra/Scheduler.hpp>
+#include <mantra/System.hpp>
+#include <mantra/World.hpp>
+
+#include "check.hpp"
+
+struct Position
+{
+	float v;
+};
+
+struct Velocity
+{
+	float v;
+};
+
+struct Life
+{
+	int frames;
+};
+
+struct Tag
+{
+	int v;
+};
+
+struct Note
+{
+	int v;
+};
+
+class CountSys;
+
+// Spawns an entity from each entity going past 50, and sends notes from the ones past 40
+class MoveSys : public mantra::System<Position, Velocity>
+{
+	public:
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		wv.parallel_for_each([&wv](auto& entity) {
+			auto& p = entity.template get_component<Position>();
+			p.v += entity.template get_component<Velocity>().v;
+			if (p.v > 50)
+			{
+				auto child = wv.template create_entity<Position, Velocity, Life>(
+				    mantra::forward_as_tuple(Position{0}), mantra::forward_as_tuple(Velocity{p.v / 100}),
+				    mantra::forward_as_tuple(Life{5}));
+				child.template add_component<Tag>(Tag{1});
+				p.v = 0;
+			}
+			if (p.v > 40)
+				wv.template message<CountSys>(Note{int(p.v)});
+		});
+	}
+};
+
+class AgeSys : public mantra::System<Life>
+{
+	public:
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		wv.parallel_for_each([](auto& entity) {
+			if (--entity.template get_component<Life>().frames <= 0)
+				entity.destroy();
+		});
+	}
+};
+
+class TagSys : public mantra::System<Tag, Velocity>
+{
+	public:
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		for (auto& entity : wv.entities())
+			if (entity.template get_component<Velocity>().v > 0.3f)
+				entity.template remove_components<Tag>();
+	}
+};
+
+class CountSys : public mantra::System<Note>
+{
+	public:
+	template <typename WV>
+	void update(WV&&)
+	{}
+
+	void receive(Note)
+	{}
+};
+
+using World = mantra::World<mantra::ComponentList<Position, Velocity, Life, Tag, Note>,
+                            mantra::SystemList<MoveSys, AgeSys, TagSys, CountSys>>;
+
+namespace
+{
+
+std::string run(mantra::Scheduler* scheduler)
+{
+	World world;
+	world.set_scheduler(scheduler);
+	world.set_deterministic(true);
+	std::ostringstream trace;
+	world.record(trace);
+	for (int i{0}; i < 2000; ++i)
+		world.create_entity<Position, Velocity, Life>(mantra::forward_as_tuple(Position{float(i % 50)}),
+		                                              mantra::forward_as_tuple(Velocity{float(i % 7) * 0.5f}),
+		                                              mantra::forward_as_tuple(Life{100 + i % 13}));
+	for (int i{0}; i < 60; ++i)
+		world.update();
+	world.stop_recording();
+	return trace.str();
+}
+
+void same_trace()
+{
+	auto sequential = run(nullptr);
+	CHECK(sequential.size() > 1000);
+	for (std::size_t workers : {0u, 1u, 3u, 7u})
+	{
+		mantra::Scheduler scheduler{workers};
+		CHECK(run(&scheduler) == sequential);
+		CHECK(run(&scheduler) == sequential);
+	}
+}
+
+} // namespace
+
+int main()
+{
+	same_trace();
+	return test::result();
+}
@@ -0,0 +1,129 @@
+// Double-buffered component tests
+//
+// Systems reading a component through a Previous term see its value at the end of the previous frame, run in
+// the same stage as the system writing it, and get the same values with or without a scheduler and in forks.
+
+#include <mantra/Scheduler.hpp>
+#include <mantra/System.hpp>
+#include <mantra/World.hpp>
+
+#include "check.hpp"
+
+struct Position
+{
+	float v;
+};
+
+struct Velocity
+{
+	float v;
+};
+
+struct Seen
+{
+	float v;
+};
+
+namespace mantra
+{
+
+template <>
+struct storage_traits<Position>
+{
+	using storage = DoubleBufferedStorage;
+};
+
+} // namespace mantra
+
+class MoveSys : public mantra::System<Position, Velocity>
+{
+	public:
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		wv.parallel_for_each([](auto& entity) {
+			entity.template get_component<Position>().v += entity.template get_component<Velocity>().v;
+		});
+	}
+};
+
+class ReadSys : public mantra::System<Seen, mantra::Previous<Position>>
+{
+	public:
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		for (auto& entity : wv.entities())
+			entity.template get_component<Seen>().v = entity.template get_previous<Position>().v;
+	}
+};
+
+struct Stats
+{
+	int checked;
+	int wrong;
+};
+
+class CheckSys : public mantra::System<void, Position, Seen, mantra::Maybe<Velocity>>
+{
+	public:
+	explicit CheckSys(Stats* s) : stats{s} {}
+
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		for (auto& entity : wv.entities())
+		{
+			auto velocity = entity.template find_component<Velocity>();
+			auto previous = entity.template get_component<Position>().v - (velocity ? velocity->v : 0);
+			stats->wrong += entity.template get_component<Seen>().v != previous;
+			++stats->checked;
+		}
+	}
+
+	Stats* stats;
+};
+
+using World = mantra::World<mantra::ComponentList<Position, Velocity, Seen>,
+                            mantra::SystemList<MoveSys, ReadSys, CheckSys>>;
+
+static_assert(std::is_same<World::Schedule, mantra::StageList<mantra::SystemList<MoveSys, ReadSys>,
+                                                              mantra::SystemList<CheckSys>>>{},
+              "Reading the previous positions doesn't wait for MoveSys");
+
+namespace
+{
+
+void previous(mantra::Scheduler* scheduler, bool deterministic)
+{
+	Stats stats{};
+	World world{mantra::forward_as_tuple(), mantra::forward_as_tuple(), mantra::forward_as_tuple(&stats)};
+	world.set_scheduler(scheduler);
+	world.set_deterministic(deterministic);
+	for (int i{0}; i < 1000; ++i)
+	{
+		if (i % 3)
+			world.create_entity<Position, Velocity, Seen>(mantra::forward_as_tuple(Position{float(i)}),
+			                                              mantra::forward_as_tuple(Velocity{1}),
+			                                              mantra::forward_as_tuple(Seen{-1}));
+		else
+			world.create_entity<Position, Seen>(mantra::forward_as_tuple(Position{float(i)}),
+			                                    mantra::forward_as_tuple(Seen{-1}));
+	}
+	for (int i{0}; i < 5; ++i)
+		world.update();
+	auto child = world.fork();
+	child.update();
+	CHECK(stats.checked == 6000 && stats.wrong == 0);
+}
+
+} // namespace
+
+int main()
+{
+	mantra::Scheduler scheduler{2};
+	previous(nullptr, false);
+	previous(&scheduler, false);
+	previous(nullptr, true);
+	return test::result();
+}
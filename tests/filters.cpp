@@ -0,0 +1,118 @@
+// Filter tests
+//
+// Without terms exclude the owners of their components from views, and Maybe terms give optional access to
+// components the entities may lack, in entity and chunk iteration alike.
+
+#include <mantra/System.hpp>
+#include <mantra/World.hpp>
+
+#include "check.hpp"
+
+struct Counter
+{
+	int n;
+};
+
+struct Frozen
+{};
+
+struct Bonus
+{
+	int b;
+};
+
+struct Stats
+{
+	int ticked;
+	int bonus;
+	int chunked;
+	int plain;
+};
+
+// Increments the counters that aren't frozen, by their bonus if any
+class TickSys : public mantra::System<Counter, mantra::Without<Frozen>, mantra::Maybe<Bonus>>
+{
+	public:
+	explicit TickSys(Stats* s) : stats{s} {}
+
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		stats->ticked = stats->bonus = stats->chunked = 0;
+		for (auto& entity : wv.entities())
+		{
+			++stats->ticked;
+			auto bonus = entity.template find_component<Bonus>();
+			entity.template get_component<Counter>().n += bonus ? bonus->b : 1;
+			stats->bonus += bonus ? bonus->b : 0;
+		}
+		for (auto& chunk : wv.chunks())
+			stats->chunked += static_cast<int>(chunk.count());
+	}
+
+	Stats* stats;
+};
+
+class PlainSys : public mantra::System<void, Counter, mantra::Without<Frozen, Bonus>>
+{
+	public:
+	explicit PlainSys(Stats* s) : stats{s} {}
+
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		stats->plain = 0;
+		for (auto& entity : wv.entities())
+			stats->plain += entity.template get_component<Counter>().n;
+	}
+
+	Stats* stats;
+};
+
+using World = mantra::World<mantra::ComponentList<Counter, Frozen, Bonus>, mantra::SystemList<TickSys, PlainSys>>;
+
+namespace
+{
+
+void filters()
+{
+	Stats stats{};
+	World world{mantra::forward_as_tuple(&stats), mantra::forward_as_tuple(&stats)};
+	int frozen{0}, bonus{0};
+	auto thawed = world.create_entity<Counter, Frozen>(mantra::forward_as_tuple(Counter{0}),
+	                                                   mantra::forward_as_tuple());
+	for (int i{0}; i < 5000; ++i)
+	{
+		auto e = world.create_entity<Counter>(mantra::forward_as_tuple(Counter{0}));
+		if (i % 3 == 0)
+		{
+			e.add_component<Frozen>();
+			++frozen;
+		}
+		else if (i % 5 == 0)
+		{
+			e.add_component<Bonus>(Bonus{2});
+			++bonus;
+		}
+	}
+	world.update();
+	int const plain{5000 - frozen - bonus};
+	CHECK(stats.ticked == 5000 - frozen && stats.chunked == stats.ticked);
+	CHECK(stats.bonus == 2 * bonus);
+	CHECK(stats.plain == plain);
+
+	// Removing the excluded component brings the entity back into the views
+	thawed.remove_components<Frozen>();
+	world.update();
+	CHECK(stats.ticked == 5000 - frozen + 1);
+	CHECK(stats.plain == 2 * plain + 1);
+	CHECK(thawed.get_component<Counter>().n == 1);
+}
+
+} // namespace
+
+int main()
+{
+	filters();
+	return test::result();
+}
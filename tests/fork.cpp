@@ -0,0 +1,175 @@
+// Fork tests
+//
+// Forks are independent of their parent, share the pages of paged components until either world writes to
+// them, copy the other components, and can be updated concurrently.
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <mantra/System.hpp>
+#include <mantra/World.hpp>
+
+#include "check.hpp"
+#include "counting_resource.hpp"
+
+struct Position
+{
+	float x;
+};
+
+struct Velocity
+{
+	float x;
+};
+
+struct Name
+{
+	std::string s;
+};
+
+struct Clock
+{
+	int ticks;
+};
+
+namespace mantra
+{
+
+template <>
+struct storage_traits<Position>
+{
+	using storage = PagedStorage<64>;
+};
+
+template <>
+struct storage_traits<Name>
+{
+	using storage = PagedStorage<8>;
+};
+
+} // namespace mantra
+
+class TickSys : public mantra::System<Clock, mantra::Uses<Clock>>
+{
+	public:
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		++wv.template resource<Clock>().ticks;
+	}
+};
+
+// Only writes the positions of the moving entities, through a constant read first
+class MoveSys : public mantra::System<Position, Velocity>
+{
+	public:
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		for (auto& entity : wv.entities())
+		{
+			auto v = entity.template get_component<Velocity>().x;
+			if (v != 0)
+				entity.template get_component<Position>().x += v;
+		}
+	}
+};
+
+using World = mantra::World<mantra::ComponentList<Position, Velocity, Name>, mantra::SystemList<TickSys, MoveSys>,
+                            mantra::ResourceList<Clock>>;
+
+namespace
+{
+
+int const count{10000};
+
+void populate(World& world)
+{
+	for (int i{0}; i < count; ++i)
+		world.create_entity<Position, Velocity, Name>(mantra::forward_as_tuple(Position{float(i)}),
+		                                              mantra::forward_as_tuple(Velocity{i < 64 ? 1.f : 0.f}),
+		                                              mantra::forward_as_tuple(Name{std::to_string(i)}));
+}
+
+void independence()
+{
+	World parent;
+	populate(parent);
+	auto first = parent.create_entity<Position, Name>(mantra::forward_as_tuple(Position{-1}),
+	                                                  mantra::forward_as_tuple(Name{"first"}));
+	parent.update();
+
+	auto child = parent.fork();
+	auto forked = child.create_entity<Name>(mantra::forward_as_tuple(Name{"forked"}));
+	child.update();
+	child.update();
+	CHECK(parent.resource<Clock>().ticks == 1 && child.resource<Clock>().ticks == 3);
+
+	// Writes to a shared page in either world stay in that world
+	first.get_component<Name>().s = "parent";
+	first.get_component<Position>().x = 5;
+	parent.update();
+	CHECK(forked.get_component<Name>().s == "forked");
+	CHECK(first.get_component<Name>().s == "parent" && first.get_component<Position>().x == 5);
+
+	// Forks of forks outlive their parents
+	auto grandchild = child.fork();
+	{
+		World gone{std::move(child)};
+	}
+	grandchild.update();
+	CHECK(grandchild.resource<Clock>().ticks == 4);
+}
+
+// Forking copies the page tables, not the pages, and a frame writing to one page copies that page only
+void copy_on_write()
+{
+	test::CountingResource resource;
+	World parent{std::allocator_arg, resource};
+	populate(parent);
+	parent.update();
+	std::size_t const pages{count / 64 + count / 8};
+
+	auto before = resource.total;
+	auto child = parent.fork();
+	auto forked = resource.total - before;
+	CHECK(forked < pages / 4);
+
+	before = resource.total;
+	child.update();
+	CHECK(resource.total - before <= 2);
+}
+
+void concurrent()
+{
+	World parent;
+	populate(parent);
+	std::vector<World> forks;
+	for (int i{0}; i < 8; ++i)
+		forks.push_back(parent.fork());
+	std::vector<std::thread> threads;
+	for (auto& f : forks)
+		threads.emplace_back([&f] {
+			for (int k{0}; k < 20; ++k)
+				f.update();
+		});
+	for (int k{0}; k < 10; ++k)
+		parent.update();
+	for (auto& t : threads)
+		t.join();
+	bool ticked{true};
+	for (auto& f : forks)
+		ticked = ticked && f.resource<Clock>().ticks == 20;
+	CHECK(ticked && parent.resource<Clock>().ticks == 10);
+}
+
+} // namespace
+
+int main()
+{
+	independence();
+	copy_on_write();
+	concurrent();
+	return test::result();
+}
@@ -0,0 +1,69 @@
+// Benchmark harness tests
+//
+// Option lists, command line status and frame time summaries of the macro benchmarks.
+
+#include <vector>
+
+#include "../benchmarks/harness.hpp"
+#include "check.hpp"
+
+namespace
+{
+
+void parse_lists()
+{
+	CHECK(bench::parse_list("1000,10000") == std::vector<std::size_t>{1000, 10000});
+	CHECK(bench::parse_list("4") == std::vector<std::size_t>{4});
+	CHECK(bench::parse_list("1,,2,") == std::vector<std::size_t>{1, 2});
+	CHECK(bench::parse_list("").empty());
+}
+
+void parse_options()
+{
+	char arg0[] = "bench", arg1[] = "--threads", arg2[] = "1,8", arg3[] = "--frames", arg4[] = "10";
+	char* argv[] = {arg0, arg1, arg2, arg3, arg4};
+	auto opts = bench::parse_options(5, argv);
+	CHECK(opts.threads == std::vector<std::size_t>{1, 8});
+	CHECK(opts.frames == 10);
+	CHECK(opts.entities == std::vector<std::size_t>{1000, 10000});
+	CHECK(opts.warmup == 20 && opts.seed == 42);
+}
+
+// Help is a success, unknown options and runs without frames are not
+void parse_status()
+{
+	char arg0[] = "bench", help[] = "--help", h[] = "-h", frames[] = "--frames", zero[] = "0", bad[] = "--bad";
+	bench::Options opts;
+	char* with_help[] = {arg0, frames, zero, help};
+	CHECK(bench::parse_options(4, with_help, opts) == bench::Parse::help);
+	char* with_h[] = {arg0, h};
+	CHECK(bench::parse_options(2, with_h, opts) == bench::Parse::help);
+	char* no_frames[] = {arg0, frames, zero};
+	CHECK(bench::parse_options(3, no_frames, opts) == bench::Parse::invalid);
+	char* unknown[] = {arg0, bad};
+	CHECK(bench::parse_options(2, unknown, opts) == bench::Parse::invalid);
+	char* none[] = {arg0};
+	bench::Options defaults;
+	CHECK(bench::parse_options(1, none, defaults) == bench::Parse::run);
+}
+
+void summarize()
+{
+	std::vector<double> times;
+	for (int i{100}; i > 0; --i)
+		times.push_back(i);
+	auto res = bench::summarize(times);
+	CHECK(res.mean == 50.5);
+	CHECK(res.p50 == 51 && res.p90 == 90 && res.p99 == 99 && res.max == 100);
+}
+
+} // namespace
+
+int main()
+{
+	parse_lists();
+	parse_options();
+	parse_status();
+	summarize();
+	return test::result();
+}
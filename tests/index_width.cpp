@@ -0,0 +1,172 @@
+// Index width tests
+//
+// Entity records hold narrowed keys and presence bits only, worlds with a narrow index width create, destroy
+// and recycle entities like the default ones, and a component whose key doesn't fit terminates the program.
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+
+#include <mantra/System.hpp>
+#include <mantra/World.hpp>
+
+#include "check.hpp"
+
+struct Position
+{
+	float x;
+};
+
+struct Health
+{
+	int hp;
+};
+
+struct Rare
+{
+	int z;
+};
+
+namespace mantra
+{
+
+template <>
+struct storage_traits<Rare>
+{
+	using storage = SparseSetStorage;
+};
+
+} // namespace mantra
+
+struct Stats
+{
+	long sum;
+	int count;
+	int rare;
+};
+
+// Ages the entities, and destroys the ones whose health is a multiple of 7
+class AgeSys : public mantra::System<Position, Health>
+{
+	public:
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		for (auto& entity : wv.entities())
+		{
+			entity.template get_component<Position>().x += 1;
+			if (entity.template get_component<Health>().hp % 7 == 0)
+				entity.destroy();
+		}
+	}
+};
+
+class ProbeSys : public mantra::System<void, Health>
+{
+	public:
+	explicit ProbeSys(Stats* s) : stats{s} {}
+
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		*stats = Stats{};
+		for (auto& entity : wv.entities())
+		{
+			stats->sum += entity.template get_component<Health>().hp;
+			++stats->count;
+		}
+	}
+
+	Stats* stats;
+};
+
+class RareSys : public mantra::System<void, Rare>
+{
+	public:
+	explicit RareSys(Stats* s) : stats{s} {}
+
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		for (auto& entity : wv.entities())
+		{
+			(void)entity;
+			++stats->rare;
+		}
+	}
+
+	Stats* stats;
+};
+
+using Components = mantra::ComponentList<Position, Health, Rare>;
+using Systems = mantra::SystemList<AgeSys, ProbeSys, RareSys>;
+using World = mantra::World<Components, Systems, mantra::ResourceList<>, std::uint16_t>;
+
+// Two 16 bit keys for the slot keyed pools, and one byte of presence bits
+static_assert(sizeof(mantra::impl::Entity<std::uint16_t, Position, Health>) == 6, "Slim records");
+static_assert(sizeof(mantra::impl::Entity<std::uint16_t, Position, Health>)
+                  < sizeof(mantra::impl::Entity<std::uint32_t, Position, Health>),
+              "Narrower records");
+
+namespace
+{
+
+void narrow()
+{
+	Stats stats{};
+	World world{mantra::forward_as_tuple(), mantra::forward_as_tuple(&stats), mantra::forward_as_tuple(&stats)};
+	long sum{0};
+	int count{0}, rare{0};
+	for (int i{0}; i < 1000; ++i)
+	{
+		auto e = world.create_entity<Position, Health>(mantra::forward_as_tuple(Position{0}),
+		                                               mantra::forward_as_tuple(Health{i}));
+		if (i % 10 == 0)
+			e.add_component<Rare>(Rare{i});
+		if (i % 7)
+		{
+			sum += i;
+			++count;
+			rare += i % 10 == 0;
+		}
+	}
+	world.update();
+	world.update();
+	CHECK(stats.sum == sum && stats.count == count && stats.rare == rare);
+
+	// The destroyed records are recycled, with all their presence bits cleared
+	for (int i{0}; i < 2000; ++i)
+	{
+		auto e = world.create_entity<Health>(mantra::forward_as_tuple(Health{1}));
+		CHECK(!e.has_components<Rare>() && !e.has_components<Position>());
+		e.destroy();
+	}
+	auto e = world.create_entity<Position, Health, Rare>(
+	    mantra::forward_as_tuple(), mantra::forward_as_tuple(Health{1}), mantra::forward_as_tuple());
+	CHECK(e.has_components<Rare>() && e.has_components<Position, Health>());
+	world.update();
+	CHECK(stats.count == count + 1 && stats.rare == rare + 1);
+}
+
+std::size_t created{0};
+
+// The 65537th component of a slot keyed pool doesn't fit in 16 bits. The world terminates the program instead of
+// storing a truncated key, and the handler ends the test there.
+void limit()
+{
+	std::set_terminate([] { std::_Exit(created == 65536 ? test::result() : EXIT_FAILURE); });
+	Stats stats{};
+	World world{mantra::forward_as_tuple(), mantra::forward_as_tuple(&stats), mantra::forward_as_tuple(&stats)};
+	for (; created <= 65536; ++created)
+		world.create_entity<Position>(mantra::forward_as_tuple(Position{0}));
+	CHECK(!"The key of the 65537th component was truncated");
+}
+
+} // namespace
+
+int main()
+{
+	narrow();
+	limit();
+	return test::result();
+}
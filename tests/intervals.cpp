@@ -0,0 +1,117 @@
+// Update interval tests
+//
+// Systems with an interval run once per interval of the clock advanced by update(dt), staggered systems of the
+// same interval never run on the same frame, update() runs every system, and simulation replays and rewinds keep
+// the recorded frames.
+
+#include <sstream>
+
+#include <mantra/System.hpp>
+#include <mantra/World.hpp>
+
+#include "check.hpp"
+
+struct A
+{
+	int v;
+};
+
+template <int N>
+class CountSys : public mantra::System<void, A>
+{
+	public:
+	explicit CountSys(int* r) : runs{r} {}
+
+	template <typename WV>
+	void update(WV&&)
+	{
+		++runs[N];
+	}
+
+	int* runs;
+};
+
+using World = mantra::World<mantra::ComponentList<A>,
+                            mantra::SystemList<CountSys<0>, CountSys<1>, CountSys<2>, CountSys<3>>>;
+
+namespace
+{
+
+World make(int (&runs)[4])
+{
+	return World{mantra::forward_as_tuple(&runs[0]), mantra::forward_as_tuple(&runs[0]),
+	             mantra::forward_as_tuple(&runs[0]), mantra::forward_as_tuple(&runs[0])};
+}
+
+void intervals()
+{
+	int runs[4]{};
+	auto world = make(runs);
+	world.set_interval<CountSys<1>>(0.1);
+	world.set_interval<CountSys<2>>(0.5, true);
+	world.set_interval<CountSys<3>>(0.5, true);
+	int together{0};
+	for (int i{0}; i < 600; ++i)
+	{
+		auto before2 = runs[2], before3 = runs[3];
+		world.update(1. / 60);
+		together += runs[2] != before2 && runs[3] != before3;
+	}
+	CHECK(runs[0] == 600);
+	CHECK(runs[1] >= 99 && runs[1] <= 100);
+	CHECK(runs[2] >= 19 && runs[2] <= 20 && runs[3] >= 19 && runs[3] <= 20);
+	CHECK(together == 0);
+
+	auto before = runs[1];
+	world.update();
+	CHECK(runs[0] == 601 && runs[1] == before + 1);
+}
+
+void replay()
+{
+	int recorded[4]{}, replayed[4]{};
+	std::stringstream trace;
+	{
+		auto world = make(recorded);
+		world.set_interval<CountSys<1>>(0.25);
+		world.record(trace);
+		for (int i{0}; i < 10; ++i)
+			world.update(0.1);
+		world.stop_recording();
+	}
+	auto world = make(replayed);
+	CHECK(world.replay(trace, mantra::ReplayMode::simulation) == 10);
+	CHECK(replayed[0] == recorded[0] && replayed[1] == recorded[1]);
+	CHECK(recorded[1] < recorded[0]);
+}
+
+// The system runs on the third frame, rewinding to before it replays it across the interval boundary
+void rewind()
+{
+	int runs[4]{};
+	auto world = make(runs);
+	world.set_interval<CountSys<1>>(3);
+	world.keep_history(4);
+	for (int i{0}; i < 4; ++i)
+		world.update(1);
+	CHECK(runs[1] == 1);
+
+	world.rewind(2);
+	world.update(1);
+	CHECK(runs[1] == 2);
+	world.update(1);
+	world.update(1);
+	CHECK(runs[1] == 2);
+	world.update(1);
+	CHECK(runs[1] == 3);
+}
+
+} // namespace
+
+int main()
+{
+	intervals();
+	replay();
+	rewind();
+	return test::result();
+}
@@ -0,0 +1,194 @@
+// Memory resource tests
+//
+// Every allocation of a world goes through its memory resource, and the global heap is never used once the
+// world is constructed, recording included.
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <ostream>
+#include <streambuf>
+
+#include <mantra/MemoryResource.hpp>
+#include <mantra/System.hpp>
+#include <mantra/World.hpp>
+
+#include "check.hpp"
+#include "counting_resource.hpp"
+
+namespace
+{
+
+// Allocations made by the upstream resource of the test resources aren't counted
+std::atomic<std::size_t> global_allocations{0};
+
+} // namespace
+
+void* operator new(std::size_t bytes)
+{
+	if (!test::in_upstream())
+		++global_allocations;
+	if (auto p = std::malloc(bytes ? bytes : 1))
+		return p;
+	throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+	std::free(p);
+}
+
+struct Position
+{
+	float x, y;
+};
+
+struct Velocity
+{
+	float x, y;
+};
+
+struct Dead {};
+
+struct Hit
+{
+	int damage;
+};
+
+namespace mantra
+{
+
+template <>
+struct storage_traits<Dead>
+{
+	using storage = TagStorage;
+};
+
+template <>
+struct storage_traits<Position>
+{
+	using storage = PagedStorage<64>;
+};
+
+template <>
+struct storage_traits<Velocity>
+{
+	using storage = PagedStorage<64>;
+};
+
+} // namespace mantra
+
+class MoveSys : public mantra::System<Position, Velocity>
+{
+	public:
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		for (auto& entity : wv.entities())
+		{
+			auto& p = entity.template get_component<Position>();
+			p.x += entity.template get_component<Velocity>().x;
+			if (p.x > 10)
+				entity.template add_component<Dead>();
+		}
+	}
+
+	void receive(Hit)
+	{}
+};
+
+class ReapSys : public mantra::System<Dead>
+{
+	public:
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		for (auto& entity : wv.entities())
+			entity.destroy();
+		wv.template create_entity<Position, Velocity>(mantra::forward_as_tuple(Position{0, 0}),
+		                                              mantra::forward_as_tuple(Velocity{1, 0}));
+	}
+};
+
+using World = mantra::World<mantra::ComponentList<Position, Velocity, Dead>, mantra::SystemList<MoveSys, ReapSys>>;
+
+// Discards the trace without allocating
+class NullBuffer : public std::streambuf
+{
+	protected:
+	int_type overflow(int_type c) override
+	{
+		return traits_type::not_eof(c);
+	}
+
+	std::streamsize xsputn(char const*, std::streamsize count) override
+	{
+		return count;
+	}
+};
+
+namespace
+{
+
+void no_global_allocation()
+{
+	test::CountingResource resource;
+	NullBuffer buffer;
+	std::ostream trace{&buffer};
+	{
+		World world{std::allocator_arg, resource};
+		auto before = global_allocations.load();
+
+		world.record(trace);
+		world.keep_history(4);
+		for (int i{0}; i < 200; ++i)
+		{
+			world.create_entity<Position, Velocity>(mantra::forward_as_tuple(Position{float(i % 10), 0}),
+			                                        mantra::forward_as_tuple(Velocity{1, 0}));
+		}
+		world.message<MoveSys>(Hit{1});
+		for (int i{0}; i < 20; ++i)
+			world.update();
+		world.message<MoveSys>(Hit{2});
+		world.update();
+		world.stop_recording();
+		world.rewind(2);
+		world.update();
+
+		CHECK(global_allocations.load() == before);
+		CHECK(resource.total > 0 && resource.live > 0);
+	}
+	CHECK(resource.live == 0);
+}
+
+void monotonic()
+{
+	test::CountingResource upstream;
+	{
+		mantra::MonotonicResource arena{1 << 20, &upstream};
+		World world{std::allocator_arg, arena};
+		for (int i{0}; i < 1000; ++i)
+		{
+			world.create_entity<Position, Velocity>(mantra::forward_as_tuple(Position{0, 0}),
+			                                        mantra::forward_as_tuple(Velocity{1, 0}));
+		}
+		for (int i{0}; i < 5; ++i)
+			world.update();
+		CHECK(upstream.total <= 4);
+	}
+	CHECK(upstream.live == 0);
+}
+
+} // namespace
+
+int main()
+{
+	no_global_allocation();
+	monotonic();
+	return test::result();
+}
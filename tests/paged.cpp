@@ -0,0 +1,116 @@
+// Paged storage tests
+//
+// Components of a paged pool keep their address while the pool grows and other components are erased, erased
+// slots are reused, and the page table grows geometrically.
+
+#include <string>
+#include <vector>
+
+#include <mantra/System.hpp>
+#include <mantra/World.hpp>
+
+#include "check.hpp"
+#include "counting_resource.hpp"
+
+struct Position
+{
+	float x;
+};
+
+struct Name
+{
+	std::string s;
+};
+
+namespace mantra
+{
+
+template <>
+struct storage_traits<Position>
+{
+	using storage = PagedStorage<64>;
+};
+
+template <>
+struct storage_traits<Name>
+{
+	using storage = PagedStorage<4>;
+};
+
+} // namespace mantra
+
+class MoveSys : public mantra::System<Position, Name>
+{
+	public:
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		for (auto& entity : wv.entities())
+			entity.template get_component<Position>().x += 1;
+	}
+};
+
+using World = mantra::World<mantra::ComponentList<Position, Name>, mantra::SystemList<MoveSys>>;
+
+namespace
+{
+
+void stable_addresses()
+{
+	World world;
+	auto first = world.create_entity<Position, Name>(mantra::forward_as_tuple(Position{1}),
+	                                                 mantra::forward_as_tuple(Name{"first"}));
+	auto position = &first.get_component<Position>();
+	auto name = &first.get_component<Name>();
+	for (int i{0}; i < 5000; ++i)
+	{
+		auto e = world.create_entity<Position, Name>(mantra::forward_as_tuple(Position{0}),
+		                                             mantra::forward_as_tuple(Name{std::string(40, 'x')}));
+		if (i % 2)
+			e.destroy();
+	}
+	world.update();
+	CHECK(&first.get_component<Position>() == position && &first.get_component<Name>() == name);
+	CHECK(position->x == 2 && name->s == "first");
+}
+
+void reuse()
+{
+	test::CountingResource resource;
+	mantra::impl::Pool<int, mantra::PagedStorage<4>> pool{mantra::impl::Allocator<int>{&resource}};
+	std::vector<std::size_t> keys;
+	for (int i{0}; i < 8; ++i)
+		keys.push_back(pool.emplace(0, i));
+	auto address = &pool.get(keys[5]);
+	pool.erase(keys[5]);
+	auto allocations = resource.total;
+	auto key = pool.emplace(0, 42);
+	CHECK(key == keys[5] && &pool.get(key) == address && pool.get(key) == 42);
+	CHECK(resource.total == allocations && pool.size() == 8);
+	CHECK(pool.get(keys[7]) == 7);
+}
+
+// One allocation per page, plus a logarithmic number for the page table and the alive bits
+void growth()
+{
+	test::CountingResource resource;
+	{
+		mantra::impl::Pool<int, mantra::PagedStorage<4>> pool{mantra::impl::Allocator<int>{&resource}};
+		std::size_t const pages{4096};
+		for (std::size_t i{0}; i < pages * 4; ++i)
+			pool.emplace(i, static_cast<int>(i));
+		CHECK(resource.total < pages + 64);
+		CHECK(pool.size() == pages * 4);
+	}
+	CHECK(resource.live == 0);
+}
+
+} // namespace
+
+int main()
+{
+	stable_addresses();
+	reuse();
+	growth();
+	return test::result();
+}
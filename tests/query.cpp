@@ -0,0 +1,148 @@
+// Query tests
+//
+// Views visit exactly the entities owning all their components, in index order, across the words of the
+// occupancy columns, including after components are added and removed, whichever column drives the iteration.
+
+#include <vector>
+
+#include <mantra/System.hpp>
+#include <mantra/World.hpp>
+
+#include "check.hpp"
+
+using Id = int;
+
+struct A
+{};
+
+struct B
+{};
+
+struct Visits
+{
+	std::vector<int> entities;
+	std::vector<int> chunks;
+};
+
+class JoinSys : public mantra::System<void, Id, A, B>
+{
+	public:
+	explicit JoinSys(Visits* v) : visits{v} {}
+
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		visits->entities.clear();
+		visits->chunks.clear();
+		for (auto& entity : wv.entities())
+			visits->entities.push_back(entity.template get_component<Id>());
+		for (auto& chunk : wv.chunks())
+		{
+			auto ids = chunk.template data<Id>();
+			for (std::size_t i{0}; i < chunk.count(); ++i)
+				visits->chunks.push_back(ids[i]);
+		}
+	}
+
+	Visits* visits;
+};
+
+using World = mantra::World<mantra::ComponentList<Id, A, B>, mantra::SystemList<JoinSys>>;
+
+namespace
+{
+
+bool has_a(int i)
+{
+	return i % 3 == 0 || (i >= 600 && i < 700);
+}
+
+bool has_b(int i)
+{
+	return i % 5 == 0 || i == 63 || i == 64 || (i >= 640 && i < 660);
+}
+
+void intersection()
+{
+	Visits visits;
+	World world{mantra::forward_as_tuple(&visits)};
+	int const n{3000};
+	std::vector<decltype(world.create_entity<Id>())> entities;
+	for (int i{0}; i < n; ++i)
+	{
+		auto e = world.create_entity<Id>(mantra::forward_as_tuple(Id{i}));
+		if (has_a(i))
+			e.add_component<A>();
+		if (has_b(i))
+			e.add_component<B>();
+		entities.push_back(e);
+	}
+	std::vector<int> expected;
+	for (int i{0}; i < n; ++i)
+		if (has_a(i) && has_b(i))
+			expected.push_back(i);
+	world.update();
+	CHECK(visits.entities == expected);
+	CHECK(visits.chunks == expected);
+
+	// Clearing bits updates the columns
+	for (int i{0}; i < n; i += 2)
+	{
+		if (has_a(i))
+			entities[static_cast<std::size_t>(i)].remove_components<A>();
+		if (i % 10 == 0)
+			entities[static_cast<std::size_t>(i)].destroy();
+	}
+	expected.clear();
+	for (int i{1}; i < n; i += 2)
+		if (has_a(i) && has_b(i))
+			expected.push_back(i);
+	world.update();
+	CHECK(visits.entities == expected);
+	CHECK(visits.chunks == expected);
+}
+
+// The rare component drives the iteration through the summary of its column, with owners at the edges of
+// column words and summary words. Then it becomes the common one
+void driving()
+{
+	Visits visits;
+	World world{mantra::forward_as_tuple(&visits)};
+	int const n{10000};
+	std::vector<int> const rare{0, 63, 64, 4095, 4096, 4097, 8191, n - 1};
+	std::vector<decltype(world.create_entity<Id>())> entities;
+	for (int i{0}; i < n; ++i)
+		entities.push_back(world.create_entity<Id, A>(mantra::forward_as_tuple(Id{i}), mantra::forward_as_tuple()));
+	world.update();
+	CHECK(visits.entities.empty() && visits.chunks.empty());
+
+	for (auto i : rare)
+		entities[static_cast<std::size_t>(i)].add_component<B>();
+	world.update();
+	CHECK(visits.entities == rare);
+	CHECK(visits.chunks == rare);
+
+	std::vector<int> expected;
+	for (int i{0}; i < n; ++i)
+	{
+		auto& e = entities[static_cast<std::size_t>(i)];
+		if (!e.has_components<B>())
+			e.add_component<B>();
+		if (i % 100 == 0)
+			expected.push_back(i);
+		else
+			e.remove_components<A>();
+	}
+	world.update();
+	CHECK(visits.entities == expected);
+	CHECK(visits.chunks == expected);
+}
+
+} // namespace
+
+int main()
+{
+	intersection();
+	driving();
+	return test::result();
+}
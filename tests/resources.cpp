@@ -0,0 +1,79 @@
+// Resource tests
+//
+// Resources are value initialized, written by the system whose primary type they are, read by the systems using
+// them, and keep their value across frames.
+
+#include <mantra/System.hpp>
+#include <mantra/World.hpp>
+
+#include "check.hpp"
+
+struct Clock
+{
+	long frame;
+	float dt;
+};
+
+struct Config
+{
+	float gravity;
+};
+
+struct Velocity
+{
+	float y;
+};
+
+class ClockSys : public mantra::System<Clock, mantra::Uses<Clock>>
+{
+	public:
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		++wv.template resource<Clock>().frame;
+	}
+};
+
+class FallSys : public mantra::System<Velocity, mantra::Uses<Clock, Config>>
+{
+	public:
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		auto const& clock = wv.template resource<Clock>();
+		auto gravity = wv.template resource<Config>().gravity;
+		for (auto& entity : wv.entities())
+			entity.template get_component<Velocity>().y -= gravity * clock.dt;
+	}
+};
+
+using World = mantra::World<mantra::ComponentList<Velocity>, mantra::SystemList<ClockSys, FallSys>,
+                            mantra::ResourceList<Clock, Config>>;
+
+namespace
+{
+
+void resources()
+{
+	World world;
+	auto const& view = world;
+	CHECK(view.resource<Clock>().frame == 0 && view.resource<Clock>().dt == 0);
+	CHECK(view.resource<Config>().gravity == 0);
+
+	world.resource<Clock>().dt = 0.5f;
+	world.resource<Config>().gravity = 2.f;
+	auto falling = world.create_entity<Velocity>();
+	for (int i{0}; i < 4; ++i)
+		world.update();
+	CHECK(view.resource<Clock>().frame == 4);
+	CHECK(falling.get_component<Velocity>().y == -4.f);
+	CHECK(&view.resource<Clock>() == &world.resource<Clock>());
+}
+
+} // namespace
+
+int main()
+{
+	resources();
+	return test::result();
+}
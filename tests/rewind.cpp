@@ -0,0 +1,248 @@
+// Rewind tests
+//
+// Rewinding restores the entities, components and resources saved before an update, replaying the rewound
+// frames gives the same state again, a frame writing a few pages only copies those pages, and components with
+// other storage policies are rewound too.
+
+#include <mantra/System.hpp>
+#include <mantra/World.hpp>
+
+#include "check.hpp"
+#include "counting_resource.hpp"
+
+struct Position
+{
+	float x;
+};
+
+struct Velocity
+{
+	float x;
+};
+
+struct Life
+{
+	int frames;
+};
+
+struct Score
+{
+	int points;
+};
+
+struct Random
+{
+	unsigned state;
+
+	unsigned next()
+	{
+		state = state * 1103515245u + 12345u;
+		return state >> 16;
+	}
+};
+
+namespace mantra
+{
+
+template <>
+struct storage_traits<Position>
+{
+	using storage = PagedStorage<256>;
+};
+
+template <>
+struct storage_traits<Velocity>
+{
+	using storage = PagedStorage<256>;
+};
+
+template <>
+struct storage_traits<Life>
+{
+	using storage = PagedStorage<256>;
+};
+
+} // namespace mantra
+
+// Spawns a few short-lived entities every frame
+class SpawnSys : public mantra::System<Random, mantra::Uses<Random>>
+{
+	public:
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		auto& random = wv.template resource<Random>();
+		for (int i{0}; i < 3; ++i)
+			wv.template create_entity<Position, Velocity, Life>(
+			    mantra::forward_as_tuple(Position{float(random.next() % 100)}), mantra::forward_as_tuple(Velocity{1}),
+			    mantra::forward_as_tuple(Life{int(random.next() % 10) + 1}));
+	}
+};
+
+// Only writes the positions of the moving entities
+class MoveSys : public mantra::System<Position, Velocity>
+{
+	public:
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		for (auto& entity : wv.entities())
+		{
+			auto v = entity.template get_component<Velocity>().x;
+			if (v != 0)
+				entity.template get_component<Position>().x += v;
+		}
+	}
+};
+
+class DieSys : public mantra::System<Life>
+{
+	public:
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		for (auto& entity : wv.entities())
+			if (--entity.template get_component<Life>().frames <= 0)
+				entity.destroy();
+	}
+};
+
+struct Stats
+{
+	double sum;
+	int count;
+};
+
+class ProbeSys : public mantra::System<void, Position>
+{
+	public:
+	explicit ProbeSys(Stats* s) : stats{s} {}
+
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		*stats = Stats{};
+		for (auto& entity : wv.entities())
+		{
+			stats->sum += entity.template get_component<Position>().x;
+			++stats->count;
+		}
+	}
+
+	Stats* stats;
+};
+
+// Scores every entity, its components use the default storage
+class ScoreSys : public mantra::System<Score>
+{
+	public:
+	explicit ScoreSys(Stats* s) : stats{s} {}
+
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		*stats = Stats{};
+		for (auto& entity : wv.entities())
+		{
+			stats->sum += ++entity.template get_component<Score>().points;
+			++stats->count;
+		}
+	}
+
+	Stats* stats;
+};
+
+using World = mantra::World<mantra::ComponentList<Position, Velocity, Life>,
+                            mantra::SystemList<SpawnSys, MoveSys, DieSys, ProbeSys>, mantra::ResourceList<Random>>;
+
+using Scores = mantra::World<mantra::ComponentList<Position, Score>, mantra::SystemList<ScoreSys>>;
+
+namespace
+{
+
+void populate(World& world)
+{
+	world.resource<Random>().state = 1;
+	for (int i{0}; i < 100000; ++i)
+		world.create_entity<Position, Velocity>(mantra::forward_as_tuple(Position{float(i)}),
+		                                        mantra::forward_as_tuple(Velocity{0}));
+}
+
+void rewind()
+{
+	Stats stats{};
+	World world{mantra::forward_as_tuple(), mantra::forward_as_tuple(), mantra::forward_as_tuple(),
+	            mantra::forward_as_tuple(&stats)};
+	populate(world);
+	world.keep_history(8);
+	for (int i{0}; i < 20; ++i)
+		world.update();
+	CHECK(world.saved_frames() == 8);
+
+	auto random = world.resource<Random>().state;
+	world.update();
+	auto after = stats;
+	for (int i{0}; i < 4; ++i)
+		world.update();
+	auto target = stats;
+
+	world.rewind(5);
+	CHECK(world.saved_frames() == 3);
+	CHECK(world.resource<Random>().state == random);
+	world.update();
+	CHECK(stats.sum == after.sum && stats.count == after.count);
+	for (int i{0}; i < 4; ++i)
+		world.update();
+	CHECK(stats.sum == target.sum && stats.count == target.count);
+
+	world.keep_history(2);
+	CHECK(world.saved_frames() == 2);
+	world.keep_history(0);
+	world.update();
+	CHECK(world.saved_frames() == 0);
+}
+
+// The frame copies the page table of each pool, the entity records and the few pages it writes
+void copy_on_write()
+{
+	test::CountingResource resource;
+	Stats stats{};
+	World world{std::allocator_arg, resource, mantra::forward_as_tuple(), mantra::forward_as_tuple(),
+	            mantra::forward_as_tuple(), mantra::forward_as_tuple(&stats)};
+	populate(world);
+	world.keep_history(8);
+	for (int i{0}; i < 20; ++i)
+		world.update();
+	auto before = resource.total;
+	world.update();
+	CHECK(resource.total - before < 32);
+}
+
+void dense()
+{
+	Stats stats{};
+	Scores world{mantra::forward_as_tuple(&stats)};
+	for (int i{0}; i < 1000; ++i)
+		world.create_entity<Position, Score>(mantra::forward_as_tuple(Position{float(i)}),
+		                                     mantra::forward_as_tuple(Score{i}));
+	world.keep_history(4);
+	for (int i{0}; i < 3; ++i)
+		world.update();
+	auto after = stats;
+	world.update();
+	world.update();
+
+	world.rewind(2);
+	world.update();
+	CHECK(stats.sum == after.sum + 1000 && stats.count == 1000);
+}
+
+} // namespace
+
+int main()
+{
+	rewind();
+	copy_on_write();
+	dense();
+	return test::result();
+}
@@ -0,0 +1,136 @@
+// Scheduler tests
+//
+// Tasks spawned from other tasks are waited for with their group, continuations run after the whole group,
+// groups can be reused, parallel loops cover their range once, and worlds update on a shared scheduler.
+
+#include <atomic>
+#include <numeric>
+#include <vector>
+
+#include <mantra/Scheduler.hpp>
+#include <mantra/System.hpp>
+#include <mantra/World.hpp>
+
+#include "check.hpp"
+
+struct Position
+{
+	float x;
+};
+
+struct Velocity
+{
+	float x;
+};
+
+class MoveSys : public mantra::System<Position, Velocity>
+{
+	public:
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		wv.parallel_for_each([](auto& entity) {
+			entity.template get_component<Position>().x += entity.template get_component<Velocity>().x;
+		});
+	}
+};
+
+class SumSys : public mantra::System<void, Position>
+{
+	public:
+	explicit SumSys(long* s) : sum{s} {}
+
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		std::atomic<long> total{0};
+		wv.parallel_for_each([&total](auto& entity) {
+			total += static_cast<long>(entity.template get_component<Position>().x);
+		});
+		*sum = total;
+	}
+
+	long* sum;
+};
+
+using World = mantra::World<mantra::ComponentList<Position, Velocity>, mantra::SystemList<MoveSys, SumSys>>;
+
+namespace
+{
+
+void tasks(mantra::Scheduler& scheduler)
+{
+	std::atomic<int> count{0};
+	bool ordered{true};
+	mantra::TaskGroup group, next;
+	for (int i{0}; i < 100; ++i)
+		scheduler.spawn(group, [&count, &scheduler, &group] {
+			++count;
+			scheduler.spawn(group, [&count] { ++count; });
+		});
+	scheduler.then(group, next, [&count, &ordered] {
+		ordered = count == 200;
+		count += 1000;
+	});
+	scheduler.wait(next);
+	CHECK(ordered && count == 1200);
+
+	scheduler.spawn(next, [&count] { ++count; });
+	scheduler.wait(next);
+	CHECK(count == 1201);
+}
+
+void loops(mantra::Scheduler& scheduler)
+{
+	std::vector<int> v(100000);
+	scheduler.parallel_for(v.size(), 1000, [&v](std::size_t begin, std::size_t end) {
+		for (auto i = begin; i < end; ++i)
+			v[i] += static_cast<int>(i % 7);
+	});
+	long expected{0};
+	for (std::size_t i{0}; i < v.size(); ++i)
+		expected += static_cast<long>(i % 7);
+	CHECK(std::accumulate(v.begin(), v.end(), 0L) == expected);
+}
+
+void worlds(mantra::Scheduler& scheduler)
+{
+	long sum{0};
+	World world{mantra::forward_as_tuple(), mantra::forward_as_tuple(&sum)};
+	world.set_scheduler(&scheduler);
+	CHECK(world.scheduler() == &scheduler);
+	for (int i{0}; i < 50000; ++i)
+	{
+		if (i % 3)
+			world.create_entity<Position, Velocity>(mantra::forward_as_tuple(Position{1}),
+			                                        mantra::forward_as_tuple(Velocity{1}));
+		else
+			world.create_entity<Position>(mantra::forward_as_tuple(Position{0}));
+	}
+	int const moving{33333};
+	world.update();
+	CHECK(sum == 2 * moving);
+
+	auto child = world.fork();
+	CHECK(child.scheduler() == &scheduler);
+	child.update();
+	child.update();
+	CHECK(sum == 4 * moving);
+	world.update();
+	CHECK(sum == 3 * moving);
+}
+
+} // namespace
+
+int main()
+{
+	for (std::size_t workers : {0u, 1u, 3u, 7u})
+	{
+		mantra::Scheduler scheduler{workers};
+		CHECK(scheduler.workers() == workers);
+		tasks(scheduler);
+		loops(scheduler);
+		worlds(scheduler);
+	}
+	return test::result();
+}
@@ -0,0 +1,169 @@
+// Sharding tests
+//
+// Migrations move entities and their components to another shard, only the first migration queued for an entity
+// is applied, migrations of destroyed entities are dropped, and migrating leaves the pages shared with a fork as
+// they are.
+
+#include <string>
+#include <vector>
+
+#include <mantra/ShardedWorld.hpp>
+#include <mantra/System.hpp>
+#include <mantra/World.hpp>
+
+#include "check.hpp"
+#include "counting_resource.hpp"
+
+struct Position
+{
+	long x;
+};
+
+struct Name
+{
+	std::string s;
+};
+
+namespace mantra
+{
+
+template <>
+struct storage_traits<Position>
+{
+	using storage = PagedStorage<64>;
+};
+
+} // namespace mantra
+
+struct Stats
+{
+	long entities, sum;
+};
+
+// Counts the entities of its shard, and sums their positions
+class CountSys : public mantra::System<Position>
+{
+	public:
+	explicit CountSys(Stats* stats) : stats_{stats}
+	{
+	}
+
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		*stats_ = Stats{0, 0};
+		for (auto& entity : wv.entities())
+		{
+			++stats_->entities;
+			stats_->sum += entity.template get_component<Position>().x;
+		}
+	}
+
+	private:
+	Stats* stats_;
+};
+
+using World = mantra::World<mantra::ComponentList<Position, Name>, mantra::SystemList<CountSys>>;
+using Sharded = mantra::ShardedWorld<World>;
+
+namespace
+{
+
+void first_wins()
+{
+	Stats stats[3]{};
+	Sharded world{3, [&stats](std::size_t i) {
+		return World{mantra::forward_as_tuple(&stats[i])};
+	}};
+	auto e = world.shard(0).create_entity<Position>(mantra::forward_as_tuple(Position{7}));
+	auto f = world.shard(0).create_entity<Position>(mantra::forward_as_tuple(Position{100}));
+	world.migrate(e, 2);
+	world.migrate(f, 1);
+	world.migrate(e, 1);
+	world.migrate(e, 0);
+	world.update();
+	CHECK(stats[0].entities == 0);
+	CHECK(stats[1].entities == 1 && stats[1].sum == 100);
+	CHECK(stats[2].entities == 1 && stats[2].sum == 7);
+}
+
+void dropped()
+{
+	Stats stats[2]{};
+	Sharded world{2, [&stats](std::size_t i) {
+		return World{mantra::forward_as_tuple(&stats[i])};
+	}};
+	auto stay = world.shard(0).create_entity<Position>(mantra::forward_as_tuple(Position{1}));
+	auto gone = world.shard(0).create_entity<Position>(mantra::forward_as_tuple(Position{2}));
+	world.migrate(stay, 0);
+	world.migrate(gone, 1);
+	gone.destroy();
+	world.shard(0).create_entity<Position>(mantra::forward_as_tuple(Position{3}));
+	CHECK(world.apply_migrations() == 0);
+	world.update();
+	CHECK(stats[0].entities == 2 && stats[0].sum == 4 && stats[1].entities == 0);
+}
+
+void components()
+{
+	Stats stats[2]{};
+	Sharded world{2, [&stats](std::size_t i) { return World{mantra::forward_as_tuple(&stats[i])}; }};
+	std::vector<Sharded::Handle> moved;
+	for (long i{0}; i < 10; ++i)
+	{
+		auto e = world.shard(0).create_entity<Position, Name>(mantra::forward_as_tuple(Position{i}),
+		                                                      mantra::forward_as_tuple(Name{std::to_string(i)}));
+		world.migrate(e, 1);
+	}
+	auto count = world.apply_migrations([&moved](Sharded::Handle const&, Sharded::Handle const& to) {
+		moved.push_back(to);
+	});
+	CHECK(count == 10 && moved.size() == 10);
+	bool same{true};
+	for (auto& e : moved)
+		same = same && std::to_string(e.get_component<Position>().x) == e.get_component<Name>().s;
+	CHECK(same);
+}
+
+// Allocations made by migrating trivially copyable components, with or without a fork of the source shard.
+// Migrating them reads them without copying the pages the fork shares
+std::size_t migrate_all(bool forked)
+{
+	test::CountingResource resource;
+	Stats stats[2]{};
+	Sharded world{2, [&resource, &stats](std::size_t i) {
+		return World{std::allocator_arg, resource, mantra::forward_as_tuple(&stats[i])};
+	}};
+	for (long i{0}; i < 640; ++i)
+		world.migrate(world.shard(0).create_entity<Position>(mantra::forward_as_tuple(Position{i})), 1);
+	auto fork = world.shard(0).fork();
+	if (!forked)
+		fork = World{std::allocator_arg, resource, mantra::forward_as_tuple(&stats[0])};
+
+	auto before = resource.total;
+	CHECK(world.apply_migrations() == 640);
+	auto res = resource.total - before;
+
+	// The fork counts to the stats of the shard it was forked from
+	fork.update();
+	CHECK(stats[0].entities == (forked ? 640 : 0) && stats[0].sum == (forked ? 639 * 640 / 2 : 0));
+	world.update();
+	CHECK(stats[0].entities == 0 && stats[1].entities == 640 && stats[1].sum == 639 * 640 / 2);
+	return res;
+}
+
+void shared_pages()
+{
+	CHECK(migrate_all(true) == migrate_all(false));
+}
+
+} // namespace
+
+int main()
+{
+	first_wins();
+	dropped();
+	components();
+	shared_pages();
+	return test::result();
+}
@@ -0,0 +1,119 @@
+// Snapshot tests
+//
+// Readers get the newest whole frame that was published, snapshots they hold stay unchanged while the world
+// goes on, and reader threads never see a torn frame.
+
+#include <atomic>
+#include <thread>
+
+#include <mantra/System.hpp>
+#include <mantra/World.hpp>
+
+#include "check.hpp"
+
+struct Pair
+{
+	long a, b;
+};
+
+struct Health
+{
+	long v;
+};
+
+// Writes the frame number to every entity, keeping b == -a
+class FrameSys : public mantra::System<Pair>
+{
+	public:
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		++frame;
+		for (auto& entity : wv.entities())
+			entity.template get_component<Pair>() = Pair{frame, -frame};
+	}
+
+	long frame{0};
+};
+
+using World = mantra::World<mantra::ComponentList<Pair, Health>, mantra::SystemList<FrameSys>>;
+
+namespace
+{
+
+void ring()
+{
+	World world;
+	auto reader = world.snapshots<Pair, Health>();
+	CHECK(!reader.read() && reader.read().size() == 0);
+	for (int i{0}; i < 1000; ++i)
+	{
+		auto e = world.create_entity<Pair>(mantra::forward_as_tuple(Pair{0, 0}));
+		if (i % 2)
+			e.add_component<Health>(Health{i});
+	}
+	world.update();
+	{
+		auto first = reader.read();
+		CHECK(first && first.frame() == 1 && first.size() == 500 && first.get<Pair>(0).a == 1);
+		world.update();
+		auto second = reader.read();
+		CHECK(second.frame() == 2 && second.get<Pair>(0).a == 2);
+		world.update();
+		CHECK(reader.read().frame() == 3);
+
+		// Two snapshots are held and the third is the newest : the frame is skipped
+		world.update();
+		CHECK(first.get<Pair>(0).a == 1 && second.get<Pair>(0).a == 2);
+		CHECK(reader.read().frame() == 3);
+	}
+	world.update();
+	CHECK(reader.read().frame() == 5);
+}
+
+void readers()
+{
+	World world;
+	auto reader = world.snapshots<Pair, Health>();
+	for (int i{0}; i < 1000; ++i)
+		world.create_entity<Pair, Health>(mantra::forward_as_tuple(Pair{0, 0}), mantra::forward_as_tuple(Health{i}));
+	world.update();
+
+	std::atomic<bool> stop{false};
+	std::atomic<long> reads{0}, torn{0};
+	std::thread threads[3];
+	for (auto& t : threads)
+		t = std::thread([&stop, &reads, &torn, reader] {
+			long last{0};
+			while (!stop)
+			{
+				auto snapshot = reader.read();
+				auto frame = snapshot.get<Pair>(0).a;
+				snapshot.for_each([&torn, frame](Pair const& p, Health const&) {
+					torn += p.a != frame || p.b != -frame;
+				});
+				torn += frame < last;
+				last = frame;
+				++reads;
+			}
+		});
+	for (int i{0}; i < 3000; ++i)
+		world.update();
+	stop = true;
+	for (auto& t : threads)
+		t.join();
+	CHECK(reads > 0 && torn == 0);
+
+	// The last frame may have been skipped while the readers held snapshots, the next one can't
+	world.update();
+	CHECK(reader.read().frame() == 3002);
+}
+
+} // namespace
+
+int main()
+{
+	ring();
+	readers();
+	return test::result();
+}
@@ -0,0 +1,183 @@
+// Struct-of-arrays tests
+//
+// Struct-of-arrays components read and write through their proxies like whole components, their fields are
+// reached in place through chunks, and they survive a trace round trip.
+
+#include <cstdint>
+#include <sstream>
+
+#include <mantra/System.hpp>
+#include <mantra/World.hpp>
+
+#include "check.hpp"
+
+struct Position
+{
+	float x, y;
+};
+
+struct Velocity
+{
+	float x, y;
+};
+
+struct Moving
+{};
+
+namespace mantra
+{
+
+template <>
+struct storage_traits<Position>
+{
+	using storage = SoAStorage<MANTRA_MEMBER(Position, x), MANTRA_MEMBER(Position, y)>;
+};
+
+template <>
+struct storage_traits<Velocity>
+{
+	using storage = SoAStorage<MANTRA_MEMBER(Velocity, x), MANTRA_MEMBER(Velocity, y)>;
+};
+
+} // namespace mantra
+
+struct Stats
+{
+	std::size_t chunks;
+	std::size_t lanes;
+	bool aligned;
+	float sum;
+};
+
+// Moves the entities a field at a time
+class MoveSys : public mantra::System<Position, Velocity>
+{
+	public:
+	explicit MoveSys(Stats* s) : stats{s} {}
+
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		stats->chunks = stats->lanes = 0;
+		stats->aligned = true;
+		for (auto& chunk : wv.chunks())
+		{
+			++stats->chunks;
+			auto x = chunk.template field<Position, 0>();
+			auto y = chunk.template field<Position, 1>();
+			auto vx = chunk.template field<Velocity, 0>();
+			auto vy = chunk.template field<Velocity, 1>();
+			stats->aligned = stats->aligned && reinterpret_cast<std::uintptr_t>(x) % 64 == 0
+			                 && reinterpret_cast<std::uintptr_t>(vy) % 64 == 0;
+			for (std::size_t i{0}; i < chunk.count(); ++i)
+			{
+				x[i] += vx[i];
+				y[i] += vy[i];
+				++stats->lanes;
+			}
+		}
+	}
+
+	Stats* stats;
+};
+
+// Sums the positions through the read-only proxies
+class ProbeSys : public mantra::System<void, Position, Moving>
+{
+	public:
+	explicit ProbeSys(Stats* s) : stats{s} {}
+
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		stats->sum = 0;
+		for (auto& entity : wv.entities())
+		{
+			auto position = entity.template get_component<Position>();
+			Position p = position;
+			stats->sum += p.x + position.template get<1>();
+		}
+	}
+
+	Stats* stats;
+};
+
+using World = mantra::World<mantra::ComponentList<Position, Velocity, Moving>, mantra::SystemList<MoveSys, ProbeSys>>;
+
+namespace
+{
+
+World make(Stats& stats)
+{
+	return World{mantra::forward_as_tuple(&stats), mantra::forward_as_tuple(&stats)};
+}
+
+void populate(World& world)
+{
+	for (int i{0}; i < 200; ++i)
+	{
+		if (i % 3 == 0)
+			world.create_entity<Position, Velocity, Moving>(mantra::forward_as_tuple(Position{float(i), 0}),
+			                                                mantra::forward_as_tuple(Velocity{1, 2}),
+			                                                mantra::forward_as_tuple());
+		else
+			world.create_entity<Position>(mantra::forward_as_tuple(Position{float(i), 1}));
+	}
+}
+
+// Every third entity moves by (1, 2), in the 4 chunks covering 200 entities
+float expected()
+{
+	float sum{0};
+	for (int i{0}; i < 200; ++i)
+		sum += i % 3 == 0 ? float(i) + 1 + 2 : 0;
+	return sum;
+}
+
+void proxies()
+{
+	Stats stats{};
+	World world{make(stats)};
+	auto e = world.create_entity<Position>(mantra::forward_as_tuple(Position{1, 2}));
+	e.get_component<Position>() = Position{3, 4};
+	e.get_component<Position>().get<0>() += 1;
+	Position p = e.get_component<Position>();
+	CHECK(p.x == 4 && p.y == 4);
+}
+
+void chunks()
+{
+	Stats stats{};
+	World world{make(stats)};
+	populate(world);
+	world.update();
+	CHECK(stats.chunks == 4 && stats.lanes == 67);
+	CHECK(stats.aligned);
+	CHECK(stats.sum == expected());
+}
+
+void round_trip()
+{
+	Stats recorded{}, replayed{};
+	std::stringstream trace;
+	{
+		World world{make(recorded)};
+		world.record(trace);
+		populate(world);
+		world.update();
+		world.stop_recording();
+	}
+	World world{make(replayed)};
+	CHECK(world.replay(trace, mantra::ReplayMode::simulation) == 1 && !trace.fail());
+	CHECK(replayed.sum == recorded.sum && replayed.lanes == recorded.lanes);
+}
+
+} // namespace
+
+int main()
+{
+	proxies();
+	chunks();
+	round_trip();
+	return test::result();
+}
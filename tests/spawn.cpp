@@ -0,0 +1,120 @@
+// Spawner tests
+//
+// Entities submitted by spawners appear at the start of the next frame, including when producer threads submit
+// them during updates, and the recorded trace replays them.
+
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include <mantra/System.hpp>
+#include <mantra/World.hpp>
+
+#include "check.hpp"
+
+struct A
+{
+	int v;
+};
+
+struct B
+{
+	std::vector<int> v;
+};
+
+struct Stats
+{
+	std::size_t count;
+	long sum;
+	std::size_t items;
+};
+
+class CountSys : public mantra::System<void, A, mantra::Maybe<B>>
+{
+	public:
+	explicit CountSys(Stats* s) : stats{s} {}
+
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		*stats = Stats{};
+		for (auto& entity : wv.entities())
+		{
+			++stats->count;
+			stats->sum += entity.template get_component<A>().v;
+			if (auto b = entity.template find_component<B>())
+				stats->items += b->v.size();
+		}
+	}
+
+	Stats* stats;
+};
+
+using World = mantra::World<mantra::ComponentList<A, B>, mantra::SystemList<CountSys>>;
+
+namespace
+{
+
+void submit()
+{
+	Stats stats{};
+	World world{mantra::forward_as_tuple(&stats)};
+	{
+		auto spawner = world.spawner();
+		spawner.create_entity<A>(mantra::forward_as_tuple(A{5}));
+		spawner.create_entity<A, B>(mantra::forward_as_tuple(A{6}),
+		                            mantra::forward_as_tuple(B{std::vector<int>(100, 1)}));
+		world.update();
+		CHECK(stats.count == 0);
+		spawner.submit();
+		world.update();
+		CHECK(stats.count == 2 && stats.sum == 11 && stats.items == 100);
+		spawner.create_entity<A>(mantra::forward_as_tuple(A{1}));
+	}
+	world.update();
+	CHECK(stats.count == 3 && stats.sum == 12);
+}
+
+void producers()
+{
+	Stats stats{}, replayed{};
+	std::stringstream trace;
+	int const threads{4}, each{20000};
+	{
+		World world{mantra::forward_as_tuple(&stats)};
+		world.record(trace);
+		std::vector<std::thread> producers;
+		for (int t{0}; t < threads; ++t)
+			producers.emplace_back([&world, t] {
+				auto spawner = world.spawner();
+				for (int i{0}; i < each; ++i)
+				{
+					spawner.create_entity<A, B>(mantra::forward_as_tuple(A{1}),
+					                            mantra::forward_as_tuple(B{std::vector<int>(3, t)}));
+					if (i % 100 == 99)
+						spawner.submit();
+				}
+			});
+		for (int i{0}; i < 10; ++i)
+			world.update();
+		for (auto& p : producers)
+			p.join();
+		world.update();
+		world.stop_recording();
+	}
+	std::size_t const count{threads * each};
+	CHECK(stats.count == count && stats.sum == long(count) && stats.items == 3 * count);
+
+	World world{mantra::forward_as_tuple(&replayed)};
+	CHECK(world.replay(trace, mantra::ReplayMode::simulation) == 11 && !trace.fail());
+	CHECK(replayed.count == count && replayed.sum == stats.sum);
+}
+
+} // namespace
+
+int main()
+{
+	submit();
+	producers();
+	return test::result();
+}
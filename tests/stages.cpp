@@ -0,0 +1,182 @@
+// Stage tests
+//
+// Systems are laid out in stages at compile time, and the structural changes and messages issued by concurrent
+// systems and by parallel loops are applied in the same order whatever the number of threads.
+
+#include <vector>
+
+#include <mantra/Scheduler.hpp>
+#include <mantra/System.hpp>
+#include <mantra/World.hpp>
+
+#include "check.hpp"
+
+using Id = int;
+
+struct Velocity
+{
+	int v;
+};
+
+struct Health
+{
+	int hp;
+};
+
+struct Spawned
+{
+	int parent;
+};
+
+struct Note
+{
+	int id;
+};
+
+struct Log
+{
+	std::vector<int> notes;
+	std::vector<int> spawned;
+	int killed;
+};
+
+class LogSys;
+
+// Each moving entity spawns a child and sends a note from a parallel loop, and the fast ones are destroyed
+class MoveSys : public mantra::System<Id, Velocity>
+{
+	public:
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		wv.parallel_for_each([&wv](auto& entity) {
+			auto id = entity.template get_component<Id>();
+			if (id % 5 == 0)
+				wv.template create_entity<Spawned>(mantra::forward_as_tuple(Spawned{id}));
+			if (entity.template get_component<Velocity>().v > 2)
+				entity.destroy();
+			else
+				wv.template message<LogSys>(Note{id});
+		});
+	}
+};
+
+// Shares the first stage with MoveSys, and removes the health of the entities it doesn't destroy
+class KillSys : public mantra::System<Health, Velocity>
+{
+	public:
+	explicit KillSys(Log* l) : log{l} {}
+
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		for (auto& entity : wv.entities())
+		{
+			if (entity.template get_component<Velocity>().v == 1)
+			{
+				entity.destroy();
+				++log->killed;
+			}
+			else
+				entity.template remove_components<Health>();
+		}
+	}
+
+	Log* log;
+};
+
+class LogSys : public mantra::System<Note>
+{
+	public:
+	explicit LogSys(Log* l) : log{l} {}
+
+	template <typename WV>
+	void update(WV&&)
+	{}
+
+	void receive(Note note)
+	{
+		log->notes.push_back(note.id);
+	}
+
+	Log* log;
+};
+
+// Reads the identifiers MoveSys writes, hence the second stage
+class ReadSys : public mantra::System<void, Spawned, mantra::Maybe<Id>>
+{
+	public:
+	explicit ReadSys(Log* l) : log{l} {}
+
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		log->spawned.clear();
+		for (auto& entity : wv.entities())
+			log->spawned.push_back(entity.template get_component<Spawned>().parent);
+	}
+
+	Log* log;
+};
+
+using World = mantra::World<mantra::ComponentList<Id, Velocity, Health, Spawned, Note>,
+                            mantra::SystemList<MoveSys, KillSys, LogSys, ReadSys>>;
+
+static_assert(std::is_same<World::Schedule, mantra::StageList<mantra::SystemList<MoveSys, KillSys, LogSys>,
+                                                              mantra::SystemList<ReadSys>>>{},
+              "Compile-time stages");
+
+namespace
+{
+
+Log run(mantra::Scheduler* scheduler)
+{
+	Log log{};
+	World world{mantra::forward_as_tuple(), mantra::forward_as_tuple(&log), mantra::forward_as_tuple(&log),
+	            mantra::forward_as_tuple(&log)};
+	world.set_scheduler(scheduler);
+	for (int i{0}; i < 5000; ++i)
+		world.create_entity<Id, Velocity, Health>(mantra::forward_as_tuple(Id{i}),
+		                                          mantra::forward_as_tuple(Velocity{i % 4}),
+		                                          mantra::forward_as_tuple(Health{1}));
+	for (int i{0}; i < 3; ++i)
+		world.update();
+	return log;
+}
+
+void same_results()
+{
+	auto sequential = run(nullptr);
+
+	// Notes come in entity order, the fast entities are gone from the second frame, the slow ones from the third
+	std::vector<int> notes;
+	for (int i{0}; i < 5000; ++i)
+		if (i % 4 <= 2)
+			notes.push_back(i);
+	for (int i{0}; i < 5000; ++i)
+		if (i % 4 == 0 || i % 4 == 2)
+			notes.push_back(i);
+	for (int i{0}; i < 5000; ++i)
+		if (i % 4 == 0 || i % 4 == 2)
+			notes.push_back(i);
+	CHECK(sequential.notes == notes);
+	CHECK(sequential.killed == 1250);
+	CHECK(sequential.spawned.size() == 1000 + 500 + 500);
+
+	for (std::size_t workers : {0u, 1u, 3u, 7u})
+	{
+		mantra::Scheduler scheduler{workers};
+		auto parallel = run(&scheduler);
+		CHECK(parallel.notes == sequential.notes);
+		CHECK(parallel.spawned == sequential.spawned);
+		CHECK(parallel.killed == sequential.killed);
+	}
+}
+
+} // namespace
+
+int main()
+{
+	same_results();
+	return test::result();
+}
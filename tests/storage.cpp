@@ -0,0 +1,169 @@
+// Storage policy tests
+//
+// Sparse-set, hash map, tag and singleton components behave like dense ones through the world, erasing from a
+// sparse set keeps the other components in place, and the sparse set grows geometrically.
+
+#include <cstddef>
+#include <vector>
+
+#include <mantra/System.hpp>
+#include <mantra/World.hpp>
+
+#include "check.hpp"
+#include "counting_resource.hpp"
+
+struct Position
+{
+	float x;
+};
+
+struct Velocity
+{
+	float v;
+};
+
+struct Selected
+{
+	int count;
+};
+
+struct Config
+{
+	int gravity;
+};
+
+struct Active
+{};
+
+namespace mantra
+{
+
+template <>
+struct storage_traits<Velocity>
+{
+	using storage = SparseSetStorage;
+};
+
+template <>
+struct storage_traits<Selected>
+{
+	using storage = HashMapStorage;
+};
+
+template <>
+struct storage_traits<Config>
+{
+	using storage = SingletonStorage;
+};
+
+} // namespace mantra
+
+static_assert(std::is_same<mantra::storage_traits<Active>::storage, mantra::TagStorage>{},
+              "Empty components default to tag storage");
+
+class MoveSys : public mantra::System<Position, Velocity, Active>
+{
+	public:
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		for (auto& entity : wv.entities())
+			entity.template get_component<Position>().x += entity.template get_component<Velocity>().v;
+	}
+};
+
+class SelectSys : public mantra::System<Selected, Position>
+{
+	public:
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		for (auto& entity : wv.entities())
+			entity.template get_component<Selected>().count += 1;
+	}
+};
+
+using World = mantra::World<mantra::ComponentList<Position, Velocity, Selected, Config, Active>,
+                            mantra::SystemList<MoveSys, SelectSys>>;
+
+namespace
+{
+
+void through_world()
+{
+	World world;
+	auto global = world.create_entity<Config>(mantra::forward_as_tuple(Config{7}));
+	std::vector<decltype(global)> entities;
+	for (int i{0}; i < 1000; ++i)
+	{
+		auto e = world.create_entity<Position, Velocity, Active>(mantra::forward_as_tuple(Position{0}),
+		                                                         mantra::forward_as_tuple(Velocity{float(i)}),
+		                                                         mantra::forward_as_tuple());
+		if (i % 10 == 0)
+			e.add_component<Selected>(Selected{i});
+		if (i % 3 == 0)
+			e.remove_components<Velocity>();
+		if (i % 7 == 0)
+			e.destroy();
+		else
+			entities.push_back(e);
+	}
+	world.update();
+	world.update();
+
+	CHECK(global.get_component<Config>().gravity == 7);
+	bool moved{true}, selected{true};
+	for (auto& e : entities)
+	{
+		if (e.has_components<Velocity>())
+			moved = moved && e.get_component<Position>().x == 2 * e.get_component<Velocity>().v;
+		else
+			moved = moved && e.get_component<Position>().x == 0;
+		if (e.has_components<Selected>())
+			selected = selected && e.get_component<Selected>().count % 10 == 2;
+	}
+	CHECK(moved);
+	CHECK(selected);
+}
+
+void sparse_erase()
+{
+	mantra::impl::Pool<int, mantra::SparseSetStorage> pool{mantra::impl::Allocator<int>{}};
+	for (int i{0}; i < 8; ++i)
+		pool.emplace(static_cast<std::size_t>(3 * i), i);
+	pool.erase(0);
+	pool.erase(12);
+	pool.erase(21);
+	CHECK(pool.size() == 5);
+	bool kept{true};
+	for (int i : {1, 2, 3, 5, 6})
+		kept = kept && pool.get(static_cast<std::size_t>(3 * i)) == i;
+	CHECK(kept);
+	pool.emplace(12, 40);
+	CHECK(pool.get(12) == 40 && pool.get(18) == 6 && pool.size() == 6);
+}
+
+// The components and their owners grow geometrically, the sparse array by resizing to the largest entity
+void sparse_growth()
+{
+	test::CountingResource resource;
+	{
+		mantra::impl::Pool<int, mantra::SparseSetStorage> pool{mantra::impl::Allocator<int>{&resource}};
+		std::size_t const n{1 << 14};
+		for (std::size_t i{0}; i < n; ++i)
+			pool.emplace(i, static_cast<int>(i));
+		CHECK(resource.total < 3 * 64);
+		CHECK(pool.size() == n && pool.get(n - 1) == static_cast<int>(n - 1));
+	}
+	CHECK(resource.live == 0);
+}
+
+} // namespace
+
+int main()
+{
+	through_world();
+	sparse_erase();
+	sparse_growth();
+	return test::result();
+}
@@ -0,0 +1,156 @@
+// Time-slicing tests
+//
+// Slices go through the entities in turn from one frame to the next, never process an entity twice in the same
+// slice, timed slices process at least one entity, and rewinding resumes the slices where the restored frame
+// left them.
+
+#include <chrono>
+#include <vector>
+
+#include <mantra/System.hpp>
+#include <mantra/World.hpp>
+
+#include "check.hpp"
+
+struct A
+{
+	int v;
+};
+
+struct B
+{
+	int v;
+};
+
+struct Slices
+{
+	std::size_t budget;
+	std::size_t counted;
+	std::size_t timed;
+	std::vector<int> as;
+};
+
+class CountSys : public mantra::System<A>
+{
+	public:
+	explicit CountSys(Slices* s) : slices{s} {}
+
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		slices->counted = wv.for_each_slice(slices->budget, [](auto& entity) {
+			++entity.template get_component<A>().v;
+		});
+	}
+
+	Slices* slices;
+};
+
+class TimeSys : public mantra::System<B>
+{
+	public:
+	explicit TimeSys(Slices* s) : slices{s} {}
+
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		slices->timed = wv.for_each_slice(std::chrono::nanoseconds{0}, [](auto& entity) {
+			++entity.template get_component<B>().v;
+		});
+	}
+
+	Slices* slices;
+};
+
+class ReadSys : public mantra::System<void, A>
+{
+	public:
+	explicit ReadSys(Slices* s) : slices{s} {}
+
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		slices->as.clear();
+		for (auto& entity : wv.entities())
+			slices->as.push_back(entity.template get_component<A>().v);
+	}
+
+	Slices* slices;
+};
+
+using World = mantra::World<mantra::ComponentList<A, B>, mantra::SystemList<CountSys, TimeSys, ReadSys>>;
+
+namespace
+{
+
+World make(Slices& slices)
+{
+	World world{mantra::forward_as_tuple(&slices), mantra::forward_as_tuple(&slices),
+	            mantra::forward_as_tuple(&slices)};
+	for (int i{0}; i < 20; ++i)
+	{
+		if (i % 2)
+			world.create_entity<A, B>(mantra::forward_as_tuple(A{0}), mantra::forward_as_tuple(B{0}));
+		else
+			world.create_entity<A>(mantra::forward_as_tuple(A{0}));
+	}
+	return world;
+}
+
+// 7 entities per frame out of 20 : after f frames, every entity was processed about 7f/20 times
+void round_robin()
+{
+	Slices slices{7, 0, 0, {}};
+	auto world = make(slices);
+	bool fair{true};
+	for (int f{1}; f <= 20; ++f)
+	{
+		world.update();
+		int total{0};
+		for (auto v : slices.as)
+		{
+			total += v;
+			fair = fair && v >= (7 * f) / 20 && v <= (7 * f + 19) / 20;
+		}
+		fair = fair && slices.counted == 7 && total == 7 * f;
+	}
+	CHECK(fair);
+	CHECK(slices.as == std::vector<int>(20, 7));
+	CHECK(slices.timed == 1);
+}
+
+void large_budget()
+{
+	Slices slices{100, 0, 0, {}};
+	auto world = make(slices);
+	world.update();
+	world.update();
+	CHECK(slices.counted == 20);
+	CHECK(slices.as == std::vector<int>(20, 2));
+}
+
+// The replayed frame wraps around the entities from the cursor saved with the frame, not the live one
+void rewind()
+{
+	Slices slices{7, 0, 0, {}};
+	auto world = make(slices);
+	world.keep_history(1);
+	world.update();
+	world.update();
+	world.update();
+	auto as = slices.as;
+	world.rewind(1);
+	world.update();
+	CHECK(slices.counted == 7);
+	CHECK(slices.as == as);
+}
+
+} // namespace
+
+int main()
+{
+	round_robin();
+	large_budget();
+	rewind();
+	return test::result();
+}
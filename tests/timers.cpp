@@ -0,0 +1,178 @@
+// Delayed change tests
+//
+// The timing wheel fires every action on its tick, through the cascades of every level and past the range of
+// the last one, and delayed changes apply at the start of their frame, are dropped when stale, and don't replace
+// components added in the meantime.
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <mantra/System.hpp>
+#include <mantra/World.hpp>
+
+#include "check.hpp"
+
+struct A
+{
+	int v;
+};
+
+struct B
+{
+	int v;
+};
+
+struct Life
+{
+	int frames;
+};
+
+// Schedules the destruction of the entities on their first frame, and the removal of their A earlier
+class ExpireSys : public mantra::System<Life, A>
+{
+	public:
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		for (auto& entity : wv.entities())
+		{
+			auto& life = entity.template get_component<Life>().frames;
+			if (life > 0)
+			{
+				entity.destroy_after(static_cast<std::size_t>(life));
+				if (life > 1)
+					entity.template remove_after<A>(static_cast<std::size_t>(life - 1));
+				life = 0;
+			}
+		}
+	}
+};
+
+struct Counts
+{
+	std::size_t a;
+	std::size_t life;
+};
+
+template <typename T>
+class CountSys : public mantra::System<void, T>
+{
+	public:
+	explicit CountSys(std::size_t* c) : count{c} {}
+
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		*count = 0;
+		for (auto& entity : wv.entities())
+		{
+			(void)entity;
+			++*count;
+		}
+	}
+
+	std::size_t* count;
+};
+
+using World = mantra::World<mantra::ComponentList<A, B, Life>,
+                            mantra::SystemList<ExpireSys, CountSys<A>, CountSys<Life>>>;
+
+namespace
+{
+
+void cascade()
+{
+	mantra::impl::TimingWheel<std::uint64_t> wheel{mantra::default_resource()};
+	std::mt19937 random{1};
+	std::uint64_t const beyond{(std::uint64_t{1} << 24) + 5};
+	int fired{0}, late{0};
+	for (int i{0}; i < 3000; ++i)
+	{
+		std::uint64_t delay{1 + random() % (i % 3 == 0 ? 70000 : 300)};
+		if (i == 7)
+			delay = beyond;
+		wheel.schedule(delay, [delay, &fired, &late](std::uint64_t& now) {
+			++fired;
+			late += now != delay;
+		});
+	}
+	CHECK(wheel.size() == 3000);
+	for (std::uint64_t now{1}; now <= beyond + 10; ++now)
+		wheel.advance(now);
+	CHECK(fired == 3000 && late == 0);
+	CHECK(wheel.size() == 0);
+}
+
+void handles()
+{
+	Counts counts{};
+	World world{mantra::forward_as_tuple(), mantra::forward_as_tuple(&counts.a),
+	            mantra::forward_as_tuple(&counts.life)};
+	auto first = world.create_entity<A>(mantra::forward_as_tuple(A{1}));
+	first.destroy_after(3);
+	auto second = world.create_entity<A>(mantra::forward_as_tuple(A{2}));
+	second.add_after<B>(2, B{7});
+	second.remove_after<A, B>(4);
+	std::vector<std::size_t> seen;
+	for (int i{0}; i < 4; ++i)
+	{
+		world.update();
+		seen.push_back(counts.a);
+		if (i == 1)
+			CHECK(second.has_components<B>() && second.get_component<B>().v == 7);
+	}
+	CHECK((seen == std::vector<std::size_t>{2, 2, 1, 0}));
+	CHECK(!second.has_components<A>() && !second.has_components<B>());
+
+	// Adding a component the entity already has leaves it as it is
+	second.add_component<B>(B{1});
+	second.add_after<B>(1, B{2});
+	world.update();
+	CHECK(second.get_component<B>().v == 1);
+
+	// Changes of a destroyed entity don't reach the entity recycling its index
+	auto stale = world.create_entity<A>(mantra::forward_as_tuple(A{3}));
+	stale.destroy_after(2);
+	stale.add_after<B>(1, B{3});
+	stale.destroy();
+	auto recycled = world.create_entity<A>(mantra::forward_as_tuple(A{4}));
+	for (int i{0}; i < 3; ++i)
+		world.update();
+	CHECK(recycled.has_components<A>() && recycled.get_component<A>().v == 4);
+	CHECK(!recycled.has_components<B>());
+}
+
+// The systems sharing the first stage schedule from their handles, and a fork keeps the pending changes
+void from_systems()
+{
+	Counts counts{};
+	World world{mantra::forward_as_tuple(), mantra::forward_as_tuple(&counts.a),
+	            mantra::forward_as_tuple(&counts.life)};
+	world.set_deterministic(true);
+	for (int i{1}; i <= 5; ++i)
+		world.create_entity<A, Life>(mantra::forward_as_tuple(A{i}), mantra::forward_as_tuple(Life{i}));
+	std::vector<std::size_t> lives, as;
+	world.update();
+	auto fork = world.fork();
+	for (int i{0}; i < 5; ++i)
+	{
+		world.update();
+		lives.push_back(counts.life);
+		as.push_back(counts.a);
+	}
+	CHECK((lives == std::vector<std::size_t>{4, 3, 2, 1, 0}));
+	CHECK((as == std::vector<std::size_t>{3, 2, 1, 0, 0}));
+	fork.update();
+	CHECK(counts.life == 4 && counts.a == 3);
+}
+
+} // namespace
+
+int main()
+{
+	cascade();
+	handles();
+	from_systems();
+	return test::result();
+}
@@ -0,0 +1,237 @@
+// Trace tests
+//
+// Round trips of traces through both replay modes, and replays of truncated and corrupted traces, which must
+// stop with the failbit of the stream set.
+
+#include <sstream>
+#include <string>
+
+#include <mantra/System.hpp>
+#include <mantra/World.hpp>
+
+#include "check.hpp"
+
+using Counter = int;
+struct IncTag {};
+struct DecTag {};
+struct Name
+{
+	std::string s;
+};
+struct Ping
+{
+	int v;
+};
+
+struct Stats
+{
+	int sum;
+	int count;
+	int names;
+	int pings;
+};
+
+// Moves the counters up, switches them to DecTag past 3, and spawns an entity every frame
+class IncSys : public mantra::System<Counter, IncTag>
+{
+	public:
+	explicit IncSys(Stats* s) : stats{s} {}
+
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		for (auto& entity : wv.entities())
+		{
+			if (++entity.template get_component<Counter>() > 3)
+			{
+				entity.template remove_components<IncTag>();
+				entity.template add_component<DecTag>();
+			}
+		}
+		wv.template create_entity<Counter>(mantra::forward_as_tuple(100));
+	}
+
+	void receive(Ping p)
+	{
+		stats->pings += p.v;
+	}
+
+	Stats* stats;
+};
+
+class DecSys : public mantra::System<Counter, DecTag>
+{
+	public:
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		for (auto& entity : wv.entities())
+		{
+			if (--entity.template get_component<Counter>() < -3)
+				entity.destroy();
+		}
+	}
+};
+
+class ProbeSys : public mantra::System<void, Counter>
+{
+	public:
+	explicit ProbeSys(Stats* s) : stats{s} {}
+
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		stats->sum = stats->count = 0;
+		for (auto& entity : wv.entities())
+		{
+			stats->sum += entity.template get_component<Counter>();
+			++stats->count;
+		}
+	}
+
+	Stats* stats;
+};
+
+class NameSys : public mantra::System<void, Name>
+{
+	public:
+	explicit NameSys(Stats* s) : stats{s} {}
+
+	template <typename WV>
+	void update(WV&& wv)
+	{
+		stats->names = 0;
+		for (auto& entity : wv.entities())
+		{
+			(void)entity;
+			++stats->names;
+		}
+	}
+
+	Stats* stats;
+};
+
+using World = mantra::World<mantra::ComponentList<Counter, IncTag, DecTag, Name>,
+                            mantra::SystemList<IncSys, DecSys, ProbeSys, NameSys>>;
+
+namespace
+{
+
+World make(Stats& stats)
+{
+	return World{mantra::forward_as_tuple(&stats), mantra::forward_as_tuple(), mantra::forward_as_tuple(&stats),
+	             mantra::forward_as_tuple(&stats)};
+}
+
+bool same(Stats const& l, Stats const& r)
+{
+	return l.sum == r.sum && l.count == r.count && l.names == r.names && l.pings == r.pings;
+}
+
+std::string record(Stats& stats)
+{
+	std::stringstream trace;
+	auto world = make(stats);
+	world.record(trace);
+	world.create_entity<Counter, IncTag>(mantra::forward_as_tuple(1), mantra::forward_as_tuple());
+	world.create_entity<Counter, Name>(mantra::forward_as_tuple(7), mantra::forward_as_tuple(Name{"x"}));
+	world.message<IncSys>(Ping{5});
+	for (int i{0}; i < 12; ++i)
+		world.update();
+	auto e = world.create_entity<IncTag>();
+	e.add_component<Name>();
+	e.remove_components<IncTag>();
+	world.stop_recording();
+	world.update();
+	return trace.str();
+}
+
+void round_trip()
+{
+	Stats recorded{}, ops{}, sim{};
+	auto trace = record(recorded);
+
+	auto world = make(ops);
+	std::istringstream in{trace};
+	CHECK(world.replay<Ping>(in) == 12);
+	CHECK(!in.fail());
+	world.update();
+	CHECK(same(recorded, ops));
+
+	auto simulated = make(sim);
+	std::istringstream again{trace};
+	CHECK(simulated.replay<Ping>(again, mantra::ReplayMode::simulation) == 12);
+	CHECK(!again.fail());
+	simulated.update();
+	CHECK(same(recorded, sim));
+}
+
+// Every prefix of the trace is truncated : the replay must end and report it
+void truncated()
+{
+	Stats stats{};
+	auto trace = record(stats);
+	auto failed = 0u;
+	for (std::size_t size{0}; size < trace.size(); ++size)
+	{
+		Stats s{};
+		auto world = make(s);
+		std::istringstream in{trace.substr(0, size)};
+		world.replay<Ping>(in);
+		failed += in.fail();
+	}
+	CHECK(failed == trace.size());
+}
+
+std::string header()
+{
+	Stats stats{};
+	std::stringstream trace;
+	auto world = make(stats);
+	world.record(trace);
+	world.stop_recording();
+	auto res = trace.str();
+	res.pop_back(); // end
+	return res;
+}
+
+bool rejects(std::string const& ops)
+{
+	Stats stats{};
+	auto world = make(stats);
+	std::istringstream in{header() + ops};
+	world.replay<Ping>(in);
+	return in.fail();
+}
+
+void corrupted()
+{
+	Stats stats{};
+	auto world = make(stats);
+	std::istringstream bad_magic{"MTRX"};
+	CHECK(world.replay<Ping>(bad_magic) == 0 && bad_magic.fail());
+
+	CHECK(!rejects("\x07"));                                                 // end
+	CHECK(!rejects(std::string{"\x01\x00\x01\x00\x04\x01\x00\x00\x00\x07", 10}));  // create with a counter
+	CHECK(!rejects(std::string{"\x06\x00\x01x\x05\x00\x00\x00\x07", 9}));          // message of an unknown type
+	CHECK(rejects("\x02\x05"));                                              // destroy of a missing entity
+	CHECK(rejects("\x01\x00\x01\x63\x00\x07"));                              // unknown component
+	CHECK(rejects("\x01\x03\x00\x07"));                                      // create at the wrong index
+	CHECK(rejects(std::string{"\x01\x00\x02\x00\x04\x01\x00\x00\x00\x00\x04\x01\x00\x00\x00\x07", 16}));
+	CHECK(rejects(std::string{"\x01\x00\x01\x00\x02\x01\x00\x07", 8}));      // payload of the wrong size
+	CHECK(rejects(std::string{"\x05\x00\x03\x00\x07", 5}));                  // undeclared message type
+	CHECK(rejects("\x06\x04\x01x\x07"));                                     // message types out of order
+	CHECK(rejects("\x01\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff")); // varint too long
+	CHECK(rejects("\x01\x00\x01\x00\xff\xff\xff\xff\x0f"));                 // payload past the end
+	CHECK(rejects("\x42"));                                                  // unknown operation
+}
+
+} // namespace
+
+int main()
+{
+	round_trip();
+	truncated();
+	corrupted();
+	return test::result();
+}